@@ -0,0 +1,57 @@
+#include "aot_runtime.hpp"
+
+Interpreter& AotRuntime::interpreter() noexcept {
+    static Interpreter* interpreter = new Interpreter;
+    return *interpreter;
+}
+
+void AotRuntime::fail(const std::string& msg) noexcept {
+    std::cerr << interpreter().fail(msg).unwrap_error() << '\n' ;
+    std::exit(1);
+}
+
+Value AotRuntime::unary(Unary* site, const Value& operand) noexcept {
+    ValueResult result = interpreter().apply_unary(site, operand);
+    if (result.is_error())
+        fail(result.unwrap_error());
+    return result.unwrap();
+}
+
+Value AotRuntime::binary(Binary* site, const Value& left, const Value& right) noexcept {
+    ValueResult result = interpreter().apply_binary(site, left, right);
+    if (result.is_error())
+        fail(result.unwrap_error());
+    return result.unwrap();
+}
+
+Value AotRuntime::cast(const Type* target, const Value& value) noexcept {
+    CastResult result = target->cast(value.box());
+    if (result.is_error())
+        fail(result.unwrap_error());
+    return Value::unbox(result.unwrap());
+}
+
+void AotRuntime::store(const char* name, Slot& slot, const Value& value) noexcept {
+    EnvironmentResult stored = Environment::store(name, &slot, value);
+    if (stored.is_error())
+        fail(stored.unwrap_error());
+}
+
+void AotRuntime::print(const Value& value) noexcept {
+    value.box()->format_to(interpreter().output());
+}
+
+Value AotRuntime::big_integer(const char* digits) noexcept {
+    BigInteger big;
+    BigInteger::parse(digits, big);
+    return Value::of_object(new ObjectBigInteger{std::move(big)});
+}
+
+Value AotRuntime::string(const char* text, size_t length) noexcept {
+    return Value::of_object(new ObjectString{text, length});
+}
+
+int AotRuntime::finish() noexcept {
+    interpreter().output().flush();
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef AOT_RUNTIME_H_INCLUDED
+#define AOT_RUNTIME_H_INCLUDED
+
+#include "interpreter.hpp"
+
+// Linked into the programs CppEmitter writes (libruntime.a)
+// Generated code handles proven int and float operands inline, anything
+// else comes here and goes through the Interpreter kernels, so values,
+// output and error messages are the same as interpreting the source
+class AotRuntime {
+    static Interpreter& interpreter() noexcept;
+
+public:
+    // Ends the program like a runtime error ends an interpretation
+    [[noreturn]] static void fail(const std::string& msg) noexcept;
+
+    static Value unary(Unary* site, const Value& operand) noexcept;
+    static Value binary(Binary* site, const Value& left, const Value& right) noexcept;
+    static Value cast(const Type* target, const Value& value) noexcept;
+    static void store(const char* name, Slot& slot, const Value& value) noexcept;
+    static void print(const Value& value) noexcept;
+
+    // Literals the parser would have made, digits too long for i64
+    static Value big_integer(const char* digits) noexcept;
+    static Value string(const char* text, size_t length) noexcept;
+
+    // Exit status of main
+    static int finish() noexcept;
+};
+
+#endif
@@ -0,0 +1,291 @@
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <unistd.h>
+
+#include "../interpreter.hpp"
+#include "../parser.hpp"
+#include "../simplifier.hpp"
+#include "../type_checker.hpp"
+#include "harness.hpp"
+
+// ---- Workloads ----
+// Programs of n lines exercising one part of the language each, all of
+// them valid so any error aborts the run
+
+static std::string expression_workload(size_t n) {
+    std::string source = "int a := 7, b := 3;\nfloat f := 1.5;\nboolean c := false;\n";
+    for (size_t i = 0; i < n; i++) {
+        source += std::format(
+            "a = (a * {} + b) % 1000003 - (b << 2) // {};\n"
+            "b = (b + (a & 255) ^ a >> 3) % 65521 + -a * 2;\n"
+            "f = f * 0.5 + a / {}.0 - f ** 2 / 1000.0;\n"
+            "c = f > 100.0 and a != b or b < 0 xor c;\n",
+            31 + i % 7, 3 + i % 5, i + 1
+        );
+    }
+    return source;
+}
+
+// Identifiers are letters only, i spelled in base 26
+static std::string suffix(size_t i) {
+    std::string letters;
+    do {
+        letters.push_back(static_cast<char>('a' + i % 26));
+        i /= 26;
+    } while (i);
+    return letters;
+}
+
+static std::string declaration_workload(size_t n) {
+    std::string source = "int a := 1;\n";
+    for (size_t i = 0; i < n; i++) {
+        const std::string id = suffix(i);
+        source += std::format(
+            "int v_{} := a + {}, u_{} := v_{} * 2;\n"
+            "float w_{} := v_{} * 0.25;\n"
+            "boolean z_{} := v_{} > {};\n"
+            "string s_{} := \"s{}\";\n",
+            id, i, id, id, id, id, id, id, i % 17, id, i
+        );
+    }
+    return source;
+}
+
+static std::string block_workload(size_t n) {
+    std::string source = "int a := 1;\n";
+    for (size_t i = 0; i < n; i++) {
+        source += std::format(
+            "a = {{ int t := a + {}; int u := {{ return t * 3 % 101; }}; return (t + u) % 1009; }};\n"
+            "a = {{ a = a + 1; {{ a = a * 2 % 7919; }}; return a; }};\n",
+            i
+        );
+    }
+    return source;
+}
+
+static std::string cast_workload(size_t n) {
+    std::string source = "int a := 65;\nstring s := \"\";\nfloat f := 0.0;\nboolean b := false;\n";
+    for (size_t i = 0; i < n; i++) {
+        source += std::format(
+            "s = (string) a;\n"
+            "a = (int) s + {};\n"
+            "f = (float) a / 2.0;\n"
+            "a = (int) f % 1000003 + 64;\n"
+            "b = (boolean) a;\n",
+            i % 10
+        );
+    }
+    return source;
+}
+
+static std::string print_workload(size_t n) {
+    std::string source = "int a := 12345;\nfloat f := 2.5;\nstring s := \"row\";\nboolean b := true;\n";
+    for (size_t i = 0; i < n; i++) {
+        source += std::format(
+            "print a + {};\nprint f;\nprint s;\nprint b;\nprint \"line {}\";\n",
+            i, i
+        );
+    }
+    return source;
+}
+
+// ---- Benchmarks ----
+
+[[noreturn]] static void abort_run(const std::string& what, const std::string& msg) {
+    std::cerr << std::format("bench: {}: {}\n", what, msg);
+    std::exit(1);
+}
+
+static TreeBase* parse_or_abort(const std::string& name, std::string& source) {
+    Parser parser;
+    parser.init(source.data(), source.size());
+    ParseResult result = parser.parse_source();
+    if (result.is_error() || !result.unwrap() || parser.errors())
+        abort_run(name, "workload does not parse");
+    return result.unwrap();
+}
+
+static u64 count_tokens(std::string& source) {
+    Lexer lexer;
+    lexer.init(source.data(), source.size());
+    u64 tokens = 0;
+    while (lexer.generate_next_token().ttype != TokenType::END_OF_FILE)
+        tokens++;
+    return tokens;
+}
+
+// Keeps the compiler from dropping work whose result is unused
+static volatile u64 sink = 0;
+
+static void add_lexer(Harness& harness, const std::string& name, std::string& source) {
+    auto lexer = std::make_shared<std::optional<Lexer>>();
+    harness.add(Harness::Benchmark{
+        "lex/" + name,
+        count_tokens(source),
+        "tokens",
+        [lexer, &source]() {
+            lexer->emplace();
+            (*lexer)->init(source.data(), source.size());
+        },
+        [lexer]() {
+            u64 tokens = 0;
+            while ((*lexer)->generate_next_token().ttype != TokenType::END_OF_FILE)
+                tokens++;
+            sink = sink + tokens;
+        },
+    });
+}
+
+static void add_parser(Harness& harness, const std::string& name, std::string& source) {
+    auto parser = std::make_shared<std::optional<Parser>>();
+    const size_t statements =
+        static_cast<Program*>(parse_or_abort(name, source))->statements.size();
+    harness.add(Harness::Benchmark{
+        "parse/" + name,
+        statements,
+        "statements",
+        [parser, &source]() {
+            parser->emplace();
+            (*parser)->init(source.data(), source.size());
+        },
+        [parser, name]() {
+            ParseResult result = (*parser)->parse_source();
+            if (result.is_error() || !result.unwrap())
+                abort_run(name, "workload does not parse");
+        },
+    });
+}
+
+static void add_interpreter(Harness& harness, const std::string& name, std::string& source) {
+    // Each run gets a fresh tree, quickened nodes and globals would
+    // otherwise carry over
+    struct State {
+        std::unique_ptr<Interpreter> interpreter;
+        TreeBase* tree = nullptr;
+    };
+    auto state = std::make_shared<State>();
+    const size_t statements =
+        static_cast<Program*>(parse_or_abort(name, source))->statements.size();
+    harness.add(Harness::Benchmark{
+        "eval/" + name,
+        statements,
+        "statements",
+        [state, name, &source]() {
+            state->interpreter = std::make_unique<Interpreter>();
+            state->tree = parse_or_abort(name, source);
+            TypeChecker checker{state->interpreter->environment()};
+            if (checker.check(state->tree) != 0)
+                abort_run(name, "workload does not type check");
+            Simplifier{}.run(state->tree);
+        },
+        [state, name]() {
+            InterpreterResult result = state->interpreter->interpret(state->tree);
+            if (result.is_error())
+                abort_run(name, result.unwrap_error());
+            state->interpreter->output().flush();
+        },
+    });
+}
+
+// ---- Driver ----
+
+static bool parse_count(const char* arg, const char* option, size_t& out) {
+    const size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0)
+        return false;
+    out = std::strtoull(arg + length, nullptr, 10);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Harness::Options options;
+    // Lines of each workload
+    size_t size = 2000;
+    const char* json_path = nullptr;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        if (
+            parse_count(argv[i], "--warmup=", options.warmup) ||
+            parse_count(argv[i], "--repetitions=", options.repetitions) ||
+            parse_count(argv[i], "--size=", size)
+        ) {
+            continue;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            options.filter = argv[i] + 9;
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            options.memory = true;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            options.counters = true;
+        } else if (strncmp(argv[i], "--json=", 7) == 0) {
+            json_path = argv[i] + 7;
+        } else {
+            valid_arguments = false;
+        }
+    }
+    if (!valid_arguments || size == 0) {
+        std::cerr << "Usage:\n" ;
+        std::cerr << "   bench/run_benchmarks [options]\n" ;
+        std::cerr << "Options:\n" ;
+        std::cerr << "   --warmup=N        untimed runs before measuring, 3 by default\n" ;
+        std::cerr << "   --repetitions=N   timed runs, 30 by default\n" ;
+        std::cerr << "   --size=N          lines of each workload, 2000 by default\n" ;
+        std::cerr << "   --filter=text     only benchmarks whose name contains text\n" ;
+        std::cerr << "   --json=path       write results there instead of stdout\n" ;
+        std::cerr << "   --counters        also cycles, instructions, branch and cache misses\n" ;
+        std::cerr << "   --mem-stats       also allocations and their bytes, and the categories\n" ;
+        std::cerr << "                     of everything allocated on exit\n" ;
+        return 1;
+    }
+
+    // What print workloads print must not end up among the results
+    const int results_fd = dup(STDOUT_FILENO);
+    const int null_fd = open("/dev/null", O_WRONLY);
+    if (results_fd < 0 || null_fd < 0 || dup2(null_fd, STDOUT_FILENO) < 0) {
+        std::cerr << "bench: can not redirect stdout\n" ;
+        return 1;
+    }
+    close(null_fd);
+
+    // Referenced by the benchmarks, must outlive them
+    std::vector<std::pair<std::string, std::string>> workloads{
+        {"expression", expression_workload(size)},
+        {"declaration", declaration_workload(size)},
+        {"block", block_workload(size)},
+        {"cast", cast_workload(size)},
+        {"print", print_workload(size)},
+    };
+    std::string all;
+    for (const auto& [name, source] : workloads)
+        all += source;
+    Harness harness{options};
+    // Front end throughput on everything at once, what tokens and
+    // statements a real program mixes
+    add_lexer(harness, "all", all);
+    add_parser(harness, "all", all);
+    for (auto& [name, source] : workloads)
+        add_interpreter(harness, name, source);
+    harness.run();
+    if (harness.perf_counters() && !harness.perf_counters()->error().empty())
+        std::cerr << std::format("bench: counters unavailable: {}\n", harness.perf_counters()->error());
+    harness.report_table(std::cerr);
+    if (options.memory)
+        MemoryStats::report(std::cerr);
+
+    std::ostringstream json;
+    harness.report_json(json, {
+        {"size", std::to_string(size)},
+        {"warmup", std::to_string(options.warmup)},
+        {"repetitions", std::to_string(options.repetitions)},
+    });
+    if (json_path) {
+        std::ofstream{json_path} << json.str();
+    } else {
+        const std::string text = json.str();
+        if (::write(results_fd, text.data(), text.size()) < 0)
+            return 1;
+    }
+    return 0;
+}
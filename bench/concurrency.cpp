@@ -0,0 +1,61 @@
+#include <atomic>
+#include <thread>
+#include "../script.hpp"
+
+// Runs of one Script on many threads at once, built with -fsanitize=thread
+// by make concurrency so a data race fails it even when every value came
+// out right
+
+static constexpr int THREADS = 8;
+static constexpr int RUNS = 300;
+
+// Touches what runs share: the compiled tree or IR, interned types, small
+// integers, big integers past i64 and the allocation accounting the heap
+// limit reads
+static const char* const SOURCE =
+    "int a := n * 3 + n;\n"
+    "float g := f * 2.0 + f;\n"
+    "string s := \"x\" + (string) a;\n"
+    "int big := n * 9223372036854775807;\n"
+    "print s + (string) (big + a);\n"
+    "a + big;\n";
+
+static const char* engine_name(Script::Engine engine) {
+    return engine == Script::Engine::Tree ? "tree" : "ir";
+}
+
+int main() {
+    bool failed = false;
+    for (const Script::Engine engine : {Script::Engine::Tree, Script::Engine::Ir}) {
+        Script::Options options;
+        options.engine = engine;
+        options.inputs = {{"n", TypeInteger::get_type_object()}, {"f", TypeFloat::get_type_object()}};
+        Script::CompileResult compiled = Script::compile(SOURCE, options);
+        if (compiled.is_error()) {
+            std::cerr << compiled.unwrap_error();
+            return 1;
+        }
+        const std::shared_ptr<const Script> script = compiled.unwrap();
+        std::atomic<int> wrong{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < RUNS; i++) {
+                    // Some inputs differ between threads, most are the same
+                    const i64 n = i % 3 == 0 ? t * 1000 + i : i;
+                    const Script::Run run = script->run(
+                        {{"n", ObjectInteger::make(n)}, {"f", new ObjectFloat{1.5}}}, Budget::Limits{0, 0, 1 << 20}
+                    );
+                    const BigInteger expected = BigInteger{n} * BigInteger{INT64_MAX} + BigInteger{4 * n};
+                    if (!run.ok || run.value == nullptr || run.value->to_string() != expected.to_string())
+                        wrong++;
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        std::cout << std::format("{}: {} of {} runs wrong\n", engine_name(engine), wrong.load(), THREADS * RUNS);
+        failed = failed || wrong > 0;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+#include <filesystem>
+#include <fstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "generator.hpp"
+#include "process.hpp"
+
+// Corners of the language where engines went apart before, one program
+// each since a runtime error ends the program
+static const char* const EDGE_CASES[] = {
+    "int x := 1; x = x + 41; print x;",
+    "int x; float f; boolean b; string s; print x; print f; print b; print s;",
+    "float f := 3; f = f / 2; print f; print -f; print f > 1;",
+    "int x := 9223372036854775807; x = x + 1; print x; print x >> 2; print 1 << 70; print 5 & 3 | 8 ^ 1;",
+    "int a := 3; print a << 62; print a << 2; print (a & 1) | 4 ^ 2; print a >= 3; print a ** 3; print 10 % a;",
+    "print -(9223372036854775807) - 2; print 7.5 // 2; print 7 % -1; print 2 ** 100; print 2.0 ** 0.5;",
+    "int h := 3; h = h * 9223372036854775807; print h; print h / h; print -h % 7;",
+    "float big := 1.5; print big / 0.0; print -big / 0.0; print big * 0.0;",
+    "print (int) \"12\" + 1; print (float) 3 / 2; print (boolean) 2; print (string) 1.5; print (float) \"2.5\";",
+    "print 1 == 1.0; print \"a\" == \"a\"; print true != false; print 3 > 2 and 1 > 2; print 1 xor 0;",
+    "int a := 7; print -a % 3; print a / 2; print (a > 3) and (a < 10); print ~a; print !(a > 1);",
+    "string s := \"x\"; s = s + 1 + 2.5; print s; print 1 + \"y\";",
+    "int x := 2; print { int y := x; return y * 2.5; } + 1;",
+    "{ int a := 1; { int b := a + 1; print b; }; print a; };",
+    "print (int) \"x\";",
+    "int q := 1 // 0;",
+};
+
+// The tree engine is the reference the others are compared to
+struct Engine {
+    const char* name;
+    const char* flag;
+};
+
+static const Engine ENGINES[] = {
+    {"closure", "--engine=closure"},
+    {"ir", "--engine=ir"},
+    {"jit", "--jit"},
+};
+
+// What one engine made of one program
+struct Outcome {
+    std::string output{};
+    std::string errors{};
+    // As wait reports it
+    int status = 0;
+
+    inline bool operator==(const Outcome&) const = default;
+};
+
+static bool run(const std::vector<std::string>& arguments, Outcome& outcome) {
+    ProcessRun process;
+    if (!run_capturing(arguments, process, outcome.output))
+        return false;
+    outcome.errors = std::move(process.errors);
+    outcome.status = process.status;
+    return true;
+}
+
+// Built with --aot and then run, a failed build is reported as its errors
+static bool run_compiled(
+    const std::string& main_path, const std::string& program, const std::string& executable, Outcome& outcome
+) {
+    Outcome build;
+    if (!run({main_path, "--aot=" + executable, "--file", program}, build))
+        return false;
+    if (build.status != 0 || !build.errors.empty()) {
+        outcome.errors = "--aot failed:\n" + build.errors;
+        return true;
+    }
+    const bool ran = run({executable}, outcome);
+    std::filesystem::remove(executable);
+    // A runtime error ends a compiled program with 1 where main still
+    // exits with 0, only crashes count
+    if (!outcome.errors.empty() && WIFEXITED(outcome.status) && WEXITSTATUS(outcome.status) == 1)
+        outcome.status = 0;
+    return ran;
+}
+
+// First line where the two differ, to keep reports short
+static std::string first_difference(const std::string& expected, const std::string& actual) {
+    size_t line = 1, start = 0;
+    for (size_t i = 0; i < std::min(expected.size(), actual.size()); i++) {
+        if (expected[i] != actual[i])
+            break;
+        if (expected[i] == '\n') {
+            line++;
+            start = i + 1;
+        }
+    }
+    const auto line_of = [start](const std::string& text) {
+        const size_t end = text.find('\n', start);
+        return start >= text.size() ? std::string{"<end>"} : text.substr(start, end - start);
+    };
+    return std::format("line {}: expected {:?}, got {:?}", line, line_of(expected), line_of(actual));
+}
+
+static void report(const char* engine, const Outcome& expected, const Outcome& actual) {
+    if (expected.status != actual.status)
+        std::cout << std::format("   {} status, expected {}, got {}\n", engine, expected.status, actual.status);
+    if (expected.output != actual.output)
+        std::cout << std::format("   {} output, {}\n", engine, first_difference(expected.output, actual.output));
+    if (expected.errors != actual.errors)
+        std::cout << std::format("   {} errors, {}\n", engine, first_difference(expected.errors, actual.errors));
+}
+
+static bool parse_number(const char* arg, const char* option, double& out) {
+    const size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0)
+        return false;
+    out = std::strtod(arg + length, nullptr);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string main_path = "./main";
+    double generated = 8;
+    double size_kb = 8;
+    bool aot = true;
+    std::vector<std::string> files;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        if (parse_number(argv[i], "--generated=", generated) || parse_number(argv[i], "--size-kb=", size_kb)) {
+            continue;
+        } else if (strncmp(argv[i], "--main=", 7) == 0) {
+            main_path = argv[i] + 7;
+        } else if (strcmp(argv[i], "--no-aot") == 0) {
+            aot = false;
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else {
+            valid_arguments = false;
+        }
+    }
+    if (!valid_arguments || generated < 0 || size_kb <= 0) {
+        std::cerr << "Usage:\n" ;
+        std::cerr << "   bench/check_engines [options] [program.txt...]\n" ;
+        std::cerr << "Options:\n" ;
+        std::cerr << "   --main=path       interpreter to run, ./main by default\n" ;
+        std::cerr << "   --generated=N     generated programs checked on top, 8 by default\n" ;
+        std::cerr << "   --size-kb=X       size of each generated program, 8 by default\n" ;
+        std::cerr << "   --no-aot          skip --aot, it runs $CXX on every program\n" ;
+        return 1;
+    }
+
+    // Edge cases and generated programs are written there, with the
+    // executables --aot builds
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / std::format("check_engines_{}", getpid());
+    std::filesystem::create_directories(directory);
+    // Named in reports by their path, or how to get them back once the
+    // directory is gone
+    std::vector<std::pair<std::string, std::string>> programs;
+    for (const std::string& file : files)
+        programs.emplace_back(file, file);
+    for (size_t i = 0; i < std::size(EDGE_CASES); i++) {
+        const std::string path = (directory / std::format("edge_{}.txt", i)).string();
+        std::ofstream{path} << EDGE_CASES[i] << '\n';
+        programs.emplace_back(EDGE_CASES[i], path);
+    }
+    for (u64 seed = 1; seed <= static_cast<u64>(generated); seed++) {
+        ProgramGenerator::Options options;
+        options.seed = seed;
+        options.bytes = static_cast<u64>(size_kb * 1024);
+        const std::string path = (directory / std::format("generated_{}.txt", seed)).string();
+        std::ofstream{path} << ProgramGenerator{options}.generate();
+        programs.emplace_back(
+            std::format("bench/generate_program --seed={} --size-mb={}", seed, size_kb / 1024), path
+        );
+    }
+
+    size_t different = 0;
+    bool failed = false;
+    for (const auto& [name, program] : programs) {
+        Outcome expected;
+        if (!run({main_path, "--engine=tree", "--file", program}, expected)) {
+            std::cerr << std::format("check_engines: can not run {}\n", main_path);
+            failed = true;
+            break;
+        }
+        std::vector<std::pair<const char*, Outcome>> outcomes;
+        for (const Engine& engine : ENGINES) {
+            Outcome outcome;
+            if (!run({main_path, engine.flag, "--file", program}, outcome))
+                failed = true;
+            outcomes.emplace_back(engine.name, std::move(outcome));
+        }
+        if (aot) {
+            Outcome outcome;
+            if (!run_compiled(main_path, program, (directory / "compiled").string(), outcome))
+                failed = true;
+            outcomes.emplace_back("aot", std::move(outcome));
+        }
+        if (failed) {
+            std::cerr << std::format("check_engines: can not run {} on {}\n", main_path, name);
+            break;
+        }
+        bool same = true;
+        for (const auto& [engine, outcome] : outcomes)
+            same = same && outcome == expected;
+        if (same)
+            continue;
+        different++;
+        std::cout << std::format("{}\n", name);
+        for (const auto& [engine, outcome] : outcomes)
+            report(engine, expected, outcome);
+    }
+    std::filesystem::remove_all(directory);
+    if (failed)
+        return 1;
+    std::cout << std::format("{} of {} programs differ between engines\n", different, programs.size());
+    return different > 0 ? 1 : 0;
+}
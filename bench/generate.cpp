@@ -0,0 +1,83 @@
+#include <fstream>
+#include "generator.hpp"
+
+static bool parse_count(const char* arg, const char* option, u64& out) {
+    const size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0)
+        return false;
+    out = std::strtoull(arg + length, nullptr, 10);
+    return true;
+}
+
+// i:f:s:b, relative weights of each kind
+static bool parse_weights(const char* text, u32 (&weights)[ProgramGenerator::KINDS]) {
+    for (size_t i = 0; i < ProgramGenerator::KINDS; i++) {
+        char* end;
+        weights[i] = static_cast<u32>(std::strtoul(text, &end, 10));
+        if (end == text)
+            return false;
+        if (i + 1 < ProgramGenerator::KINDS && *end != ':')
+            return false;
+        text = end + 1;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    ProgramGenerator::Options options;
+    // Sizes are in MB but fractions are useful for quick runs
+    double size_mb = 1;
+    const char* output_path = nullptr;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        u64 depth = options.depth, nesting = options.nesting,
+            variables = options.variables, length = options.max_string_length;
+        if (parse_count(argv[i], "--seed=", options.seed)) {
+            continue;
+        } else if (parse_count(argv[i], "--depth=", depth)) {
+            options.depth = depth;
+        } else if (parse_count(argv[i], "--nesting=", nesting)) {
+            options.nesting = nesting;
+        } else if (parse_count(argv[i], "--variables=", variables)) {
+            options.variables = variables;
+        } else if (parse_count(argv[i], "--string-length=", length)) {
+            options.max_string_length = length;
+        } else if (strncmp(argv[i], "--size-mb=", 10) == 0) {
+            size_mb = std::strtod(argv[i] + 10, nullptr);
+        } else if (strncmp(argv[i], "--literals=", 11) == 0) {
+            valid_arguments = valid_arguments && parse_weights(argv[i] + 11, options.literal_weights);
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            output_path = argv[i] + 9;
+        } else {
+            valid_arguments = false;
+        }
+    }
+    if (!valid_arguments || size_mb <= 0 || options.variables == 0) {
+        std::cerr << "Usage:\n" ;
+        std::cerr << "   bench/generate_program [options]\n" ;
+        std::cerr << "Options:\n" ;
+        std::cerr << "   --seed=N             same seed and options, same program, 1 by default\n" ;
+        std::cerr << "   --size-mb=X          size of the program, 1 by default\n" ;
+        std::cerr << "   --depth=N            operators nested in an expression, 4 by default\n" ;
+        std::cerr << "   --nesting=N          blocks nested in a statement, 2 by default\n" ;
+        std::cerr << "   --variables=N        distinct global variables, 64 by default\n" ;
+        std::cerr << "   --literals=i:f:s:b   weights of int, float, string and boolean, 4:2:1:1 by default\n" ;
+        std::cerr << "   --string-length=N    longest string literal, 16 by default\n" ;
+        std::cerr << "   --output=path        write the program there instead of stdout\n" ;
+        return 1;
+    }
+    options.bytes = static_cast<u64>(size_mb * (1 << 20));
+
+    const std::string program = ProgramGenerator{options}.generate();
+    if (output_path) {
+        std::ofstream file{output_path};
+        file << program;
+        if (!file) {
+            std::cerr << std::format("generate_program: can not write {}\n", output_path);
+            return 1;
+        }
+    } else {
+        std::cout << program;
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include "generator.hpp"
+
+// Every int assignment is reduced modulo it, values never turn into
+// ever growing big integers
+static const char* MODULUS = "1000003";
+
+// Identifiers are letters only, i spelled in base 26
+static std::string identifier(const std::string& prefix, size_t i) {
+    std::string name = prefix;
+    do {
+        name.push_back(static_cast<char>('a' + i % 26));
+        i /= 26;
+    } while (i);
+    return name;
+}
+
+ProgramGenerator::ProgramGenerator(const Options& _options):
+    options{_options}, state{_options.seed} {}
+
+// splitmix64, same sequence for a seed on every platform
+u64 ProgramGenerator::next() noexcept {
+    u64 z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+ProgramGenerator::Kind ProgramGenerator::pick_kind() noexcept {
+    u64 total = 0;
+    for (u32 weight : options.literal_weights)
+        total += weight;
+    if (total == 0)
+        return INTEGER;
+    u64 roll = below(total);
+    for (u8 kind = 0; kind < KINDS; kind++) {
+        if (roll < options.literal_weights[kind])
+            return static_cast<Kind>(kind);
+        roll -= options.literal_weights[kind];
+    }
+    return INTEGER;
+}
+
+const ProgramGenerator::Variable* ProgramGenerator::pick_variable(Kind kind) noexcept {
+    std::vector<const Variable*> candidates;
+    for (const std::vector<Variable>& scope : locals) {
+        for (const Variable& variable : scope) {
+            if (variable.kind == kind)
+                candidates.push_back(&variable);
+        }
+    }
+    // A handful of tries beats scanning thousands of globals
+    for (size_t i = 0; i < 8 && !globals.empty(); i++) {
+        const Variable& variable = globals[below(globals.size())];
+        if (variable.kind == kind) {
+            candidates.push_back(&variable);
+            break;
+        }
+    }
+    if (candidates.empty())
+        return nullptr;
+    return candidates[below(candidates.size())];
+}
+
+void ProgramGenerator::literal(Kind kind) {
+    switch (kind) {
+        case INTEGER:
+            out += std::to_string(below(10000));
+            break;
+        case FLOAT:
+            out += std::format("{}.{}", below(1000), below(100));
+            break;
+        case STRING: {
+            out.push_back('"');
+            const size_t length = below(options.max_string_length + 1);
+            for (size_t i = 0; i < length; i++)
+                out.push_back(chance(15) ? ' ' : static_cast<char>('a' + below(26)));
+            out.push_back('"');
+            break;
+        }
+        default:
+            out += chance(50) ? "true" : "false";
+    }
+}
+
+void ProgramGenerator::expression(Kind kind, size_t depth, size_t nesting) {
+    // A block now and then, as any other operand
+    if (nesting > 0 && depth > 0 && chance(4)) {
+        block(kind, nesting - 1);
+        return;
+    }
+    switch (kind) {
+        case INTEGER:
+            integer_expression(depth, nesting);
+            break;
+        case FLOAT:
+            float_expression(depth, nesting);
+            break;
+        case STRING:
+            string_expression(depth, nesting);
+            break;
+        default:
+            boolean_expression(depth, nesting);
+    }
+}
+
+void ProgramGenerator::integer_expression(size_t depth, size_t nesting) {
+    if (depth == 0 || chance(30)) {
+        const Variable* variable = chance(60) ? pick_variable(INTEGER) : nullptr;
+        if (variable)
+            out += variable->name;
+        else
+            literal(INTEGER);
+        return;
+    }
+    static const char* OPERATORS[] = {" + ", " - ", " * ", " & ", " | ", " ^ "};
+    out.push_back('(');
+    switch (below(10)) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            integer_expression(depth - 1, nesting);
+            out += OPERATORS[below(std::size(OPERATORS))];
+            integer_expression(depth - 1, nesting);
+            break;
+        case 4:
+            // Divisors are never zero
+            integer_expression(depth - 1, nesting);
+            out += std::format("{}{}", chance(50) ? " % " : " // ", 1 + below(97));
+            break;
+        case 5:
+            integer_expression(depth - 1, nesting);
+            out += std::format("{}{}", chance(50) ? " << " : " >> ", 1 + below(8));
+            break;
+        case 6:
+            out += chance(50) ? "-" : "~";
+            integer_expression(depth - 1, nesting);
+            break;
+        case 7:
+            integer_expression(depth - 1, nesting);
+            out += std::format(" ** {}", below(4));
+            break;
+        case 8:
+            // Through a string and back, small enough to stay an int
+            out += "(int) ((string) (";
+            integer_expression(depth - 1, nesting);
+            out += std::format(" % {}))", MODULUS);
+            break;
+        default:
+            out += "(int) ";
+            literal(FLOAT);
+    }
+    out.push_back(')');
+}
+
+void ProgramGenerator::float_expression(size_t depth, size_t nesting) {
+    if (depth == 0 || chance(30)) {
+        const Variable* variable = chance(60) ? pick_variable(chance(70) ? FLOAT : INTEGER) : nullptr;
+        if (variable)
+            out += variable->name;
+        else
+            literal(FLOAT);
+        return;
+    }
+    static const char* OPERATORS[] = {" + ", " - ", " * "};
+    out.push_back('(');
+    switch (below(6)) {
+        case 0:
+        case 1:
+        case 2:
+            float_expression(depth - 1, nesting);
+            out += OPERATORS[below(std::size(OPERATORS))];
+            // Mixed with an int the result is still a float
+            expression(chance(70) ? FLOAT : INTEGER, depth - 1, nesting);
+            break;
+        case 3:
+            float_expression(depth - 1, nesting);
+            out += std::format(" / {}.5", below(100));
+            break;
+        case 4:
+            out.push_back('-');
+            float_expression(depth - 1, nesting);
+            break;
+        default:
+            out += "(float) ";
+            out.push_back('(');
+            integer_expression(depth - 1, nesting);
+            out.push_back(')');
+    }
+    out.push_back(')');
+}
+
+void ProgramGenerator::string_expression(size_t depth, size_t nesting) {
+    // String variables would make strings grow with every assignment
+    if (depth == 0 || chance(40)) {
+        literal(STRING);
+        return;
+    }
+    out.push_back('(');
+    switch (below(3)) {
+        case 0:
+            string_expression(depth - 1, nesting);
+            out += " + ";
+            string_expression(depth - 1, nesting);
+            break;
+        case 1:
+            string_expression(depth - 1, nesting);
+            out += " + ";
+            expression(pick_kind(), depth - 1, nesting);
+            break;
+        default: {
+            out += "(string) (";
+            // Only ever short
+            Kind kind = pick_kind();
+            if (kind == STRING)
+                kind = INTEGER;
+            expression(kind, depth - 1, nesting);
+            out.push_back(')');
+        }
+    }
+    out.push_back(')');
+}
+
+void ProgramGenerator::boolean_expression(size_t depth, size_t nesting) {
+    if (depth == 0 || chance(30)) {
+        const Variable* variable = chance(60) ? pick_variable(BOOLEAN) : nullptr;
+        if (variable)
+            out += variable->name;
+        else
+            literal(BOOLEAN);
+        return;
+    }
+    static const char* COMPARISONS[] = {" < ", " <= ", " > ", " >= "};
+    static const char* LOGICAL[] = {" and ", " or ", " xor "};
+    out.push_back('(');
+    switch (below(6)) {
+        case 0:
+        case 1:
+            expression(chance(50) ? INTEGER : FLOAT, depth - 1, nesting);
+            out += COMPARISONS[below(std::size(COMPARISONS))];
+            expression(chance(50) ? INTEGER : FLOAT, depth - 1, nesting);
+            break;
+        case 2: {
+            // Either side of the same kind, string variables included
+            const Kind kind = pick_kind();
+            const Variable* variable = pick_variable(kind);
+            if (variable)
+                out += variable->name;
+            else
+                expression(kind, depth - 1, nesting);
+            out += chance(50) ? " == " : " != ";
+            expression(kind, depth - 1, nesting);
+            break;
+        }
+        case 3:
+        case 4:
+            boolean_expression(depth - 1, nesting);
+            out += LOGICAL[below(std::size(LOGICAL))];
+            boolean_expression(depth - 1, nesting);
+            break;
+        default:
+            out.push_back('!');
+            boolean_expression(depth - 1, nesting);
+    }
+    out.push_back(')');
+}
+
+void ProgramGenerator::block(Kind kind, size_t nesting) {
+    out += "{ ";
+    locals.emplace_back();
+    const size_t statements = below(4);
+    for (size_t i = 0; i < statements; i++) {
+        statement(nesting);
+        out.push_back(' ');
+    }
+    out += "return ";
+    expression(kind, options.depth, nesting);
+    out += "; }";
+    locals.pop_back();
+}
+
+void ProgramGenerator::assignment(const Variable& variable, size_t nesting) {
+    if (variable.kind == INTEGER) {
+        out.push_back('(');
+        expression(INTEGER, options.depth, nesting);
+        out += std::format(") % {}", MODULUS);
+        return;
+    }
+    expression(variable.kind, options.depth, nesting);
+}
+
+void ProgramGenerator::statement(size_t nesting) {
+    const u64 roll = below(100);
+    if (!locals.empty() && roll < 15) {
+        // Named after the block depth, no enclosing block uses it
+        static const char* TYPES[] = {"int", "float", "string", "boolean"};
+        const Kind kind = pick_kind();
+        Variable variable{
+            identifier(identifier("l", locals.size()) + "_", locals.back().size()),
+            kind
+        };
+        out += std::format("{} {} := ", TYPES[kind], variable.name);
+        assignment(variable, nesting);
+        out.push_back(';');
+        locals.back().push_back(std::move(variable));
+        return;
+    }
+    if (roll < 35) {
+        out += "print ";
+        expression(pick_kind(), options.depth, nesting);
+        out.push_back(';');
+        return;
+    }
+    if (nesting > 0 && roll < 45) {
+        // Value unused, only what it assigns and prints matters
+        block(pick_kind(), nesting - 1);
+        out.push_back(';');
+        return;
+    }
+    const Variable* variable = pick_variable(pick_kind());
+    if (!variable) {
+        out += "print ";
+        literal(STRING);
+        out.push_back(';');
+        return;
+    }
+    // Copied, generating the value may grow the scope it lives in
+    const Variable target = *variable;
+    out += target.name + " = ";
+    assignment(target, nesting);
+    out.push_back(';');
+}
+
+std::string ProgramGenerator::generate() {
+    static const char* TYPES[] = {"int", "float", "string", "boolean"};
+    state = options.seed;
+    out.clear();
+    globals.clear();
+    locals.clear();
+    for (size_t i = 0; i < options.variables; i++) {
+        Variable variable{identifier("g_", i), pick_kind()};
+        out += std::format("{} {} := ", TYPES[variable.kind], variable.name);
+        literal(variable.kind);
+        out += ";\n";
+        globals.push_back(std::move(variable));
+    }
+    while (out.size() < options.bytes) {
+        statement(options.nesting);
+        out.push_back('\n');
+    }
+    return std::move(out);
+}
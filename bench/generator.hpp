@@ -0,0 +1,68 @@
+#ifndef BENCH_GENERATOR_H_INCLUDED
+#define BENCH_GENERATOR_H_INCLUDED
+
+#include <ostream>
+#include "../common.hpp"
+
+// Writes random programs following the grammar file that type check and
+// run without errors, the same seed and options give the same program
+// Values stay bounded however long the program is: ints are reduced
+// modulo a prime on every assignment, divisors and shift counts are
+// non-zero literals and strings are never built from string variables
+class ProgramGenerator {
+public:
+    enum Kind : u8 { INTEGER, FLOAT, STRING, BOOLEAN, KINDS };
+
+    struct Options {
+        u64 seed = 1;
+        // Stops after the first statement reaching it
+        u64 bytes = 1 << 20;
+        // Operators nested in an expression
+        size_t depth = 4;
+        // Blocks nested in a statement
+        size_t nesting = 2;
+        // Globals declared up front, every statement uses these
+        size_t variables = 64;
+        // Relative weights of int, float, string and boolean literals
+        // and variables
+        u32 literal_weights[KINDS] = {4, 2, 1, 1};
+        size_t max_string_length = 16;
+    };
+
+private:
+    struct Variable {
+        std::string name;
+        Kind kind;
+    };
+
+    Options options;
+    u64 state;
+    std::string out{};
+    std::vector<Variable> globals{};
+    // Locals of the blocks being generated, innermost last
+    std::vector<std::vector<Variable>> locals{};
+
+    u64 next() noexcept;
+    inline u64 below(u64 n) noexcept { return next() % n; }
+    inline bool chance(u32 percent) noexcept { return below(100) < percent; }
+
+    Kind pick_kind() noexcept;
+    const Variable* pick_variable(Kind kind) noexcept;
+    void literal(Kind kind);
+    void expression(Kind kind, size_t depth, size_t nesting);
+    void integer_expression(size_t depth, size_t nesting);
+    void float_expression(size_t depth, size_t nesting);
+    void string_expression(size_t depth, size_t nesting);
+    void boolean_expression(size_t depth, size_t nesting);
+    void block(Kind kind, size_t nesting);
+    void statement(size_t nesting);
+    void assignment(const Variable& variable, size_t nesting);
+
+public:
+    ProgramGenerator(const Options& _options);
+
+    // Source of a whole program
+    std::string generate();
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include "harness.hpp"
+
+void Harness::add(Benchmark benchmark) {
+    benchmarks.push_back(std::move(benchmark));
+}
+
+Harness::Measurement Harness::measure(const Benchmark& benchmark) const {
+    for (size_t i = 0; i < options.warmup; i++) {
+        if (benchmark.setup) benchmark.setup();
+        benchmark.run();
+    }
+    std::vector<double> samples;
+    samples.reserve(options.repetitions);
+    const bool counting = counters && counters->available();
+    PerfCounters::Reading counts{};
+    // Setup allocates too, only what the runs do is counted
+    u64 allocations = 0, allocated_bytes = 0;
+    for (size_t i = 0; i < options.repetitions; i++) {
+        if (benchmark.setup) benchmark.setup();
+        const MemoryStats::Entry start_memory = MemoryStats::total();
+        PerfCounters::Reading start_counts{};
+        if (counting) start_counts = counters->read();
+        const auto start = std::chrono::steady_clock::now();
+        benchmark.run();
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+        allocations += MemoryStats::total().count - start_memory.count;
+        allocated_bytes += MemoryStats::total().bytes - start_memory.bytes;
+        if (counting) {
+            const PerfCounters::Reading taken = PerfCounters::difference(counters->read(), start_counts);
+            for (size_t j = 0; j < PerfCounters::EVENTS; j++)
+                counts[j] += taken[j];
+        }
+    }
+    std::vector<std::pair<PerfCounters::Event, double>> means;
+    for (u8 i = 0; counting && i < PerfCounters::EVENTS; i++) {
+        const PerfCounters::Event event = static_cast<PerfCounters::Event>(i);
+        if (counters->has(event))
+            means.emplace_back(event, static_cast<double>(counts[i]) / options.repetitions);
+    }
+    std::ranges::sort(samples);
+    // Nearest rank
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * samples.size()));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+    const size_t middle = samples.size() / 2;
+    const double median = samples.size() % 2
+        ? samples[middle]
+        : (samples[middle - 1] + samples[middle]) / 2;
+    return Measurement{
+        benchmark.name,
+        benchmark.units,
+        benchmark.unit,
+        samples.size(),
+        samples.front(),
+        median,
+        percentile(99),
+        std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size(),
+        std::move(means),
+        static_cast<double>(allocations) / options.repetitions,
+        static_cast<double>(allocated_bytes) / options.repetitions,
+    };
+}
+
+void Harness::run() {
+    measurements.clear();
+    if (options.counters && !counters)
+        counters = std::make_unique<PerfCounters>();
+    if (options.memory)
+        MemoryStats::enable();
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        if (options.repetitions == 0)
+            continue;
+        measurements.push_back(measure(benchmark));
+    }
+}
+
+void Harness::report_table(std::ostream& os) const {
+    os << std::format(
+        "{:<28}{:>12}{:>12}{:>12}{:>16}\n",
+        "benchmark", "min ms", "median ms", "p99 ms", "throughput"
+    );
+    for (const Measurement& m : measurements) {
+        os << std::format(
+            "{:<28}{:>12.3f}{:>12.3f}{:>12.3f}{:>10.2f} M{}/s\n",
+            m.name, m.min_ns / 1e6, m.median_ns / 1e6, m.p99_ns / 1e6,
+            m.units_per_second() / 1e6, m.unit
+        );
+    }
+    if (options.memory && !measurements.empty()) {
+        os << std::format("\n{:<28}{:>16}{:>16}{:>16}\n", "allocations", "per run", "bytes per run", "bytes per unit");
+        for (const Measurement& m : measurements) {
+            os << std::format(
+                "{:<28}{:>16.1f}{:>16.0f}{:>16.1f}\n",
+                m.name, m.allocations, m.allocated_bytes, m.units ? m.allocated_bytes / m.units : 0
+            );
+        }
+    }
+    if (!counters || !counters->available() || measurements.empty())
+        return;
+    // Per unit of work, comparable across sizes
+    os << std::format("\n{:<28}", "per unit");
+    for (const auto& [event, mean] : measurements.front().counters)
+        os << std::format("{:>15}", PerfCounters::NAMES[event]);
+    os << std::format("{:>7}\n", "IPC");
+    for (const Measurement& m : measurements) {
+        os << std::format("{:<28}", m.name);
+        double cycles = 0, instructions = 0;
+        for (const auto& [event, mean] : m.counters) {
+            os << std::format("{:>15.1f}", m.units ? mean / m.units : mean);
+            if (event == PerfCounters::CYCLES) cycles = mean;
+            if (event == PerfCounters::INSTRUCTIONS) instructions = mean;
+        }
+        if (cycles > 0)
+            os << std::format("{:>7.2f}", instructions / cycles);
+        os << '\n';
+    }
+}
+
+void Harness::report_json(
+    std::ostream& os, const std::vector<std::pair<std::string, std::string>>& context
+) const {
+    os << "{\n  \"context\": {";
+    for (size_t i = 0; i < context.size(); i++)
+        os << std::format("{}\n    \"{}\": {}", i ? "," : "", context[i].first, context[i].second);
+    os << "\n  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < measurements.size(); i++) {
+        const Measurement& m = measurements[i];
+        os << std::format(
+            "{}\n    {{\"name\": \"{}\", \"units\": {}, \"unit\": \"{}\", \"repetitions\": {}, "
+            "\"min_ns\": {:.0f}, \"median_ns\": {:.0f}, \"p99_ns\": {:.0f}, \"mean_ns\": {:.0f}, "
+            "\"units_per_second\": {:.0f}",
+            i ? "," : "", m.name, m.units, m.unit, m.repetitions,
+            m.min_ns, m.median_ns, m.p99_ns, m.mean_ns, m.units_per_second()
+        );
+        if (options.memory) {
+            os << std::format(
+                ", \"allocations\": {:.1f}, \"allocated_bytes\": {:.0f}",
+                m.allocations, m.allocated_bytes
+            );
+        }
+        if (!m.counters.empty()) {
+            os << ", \"counters\": {";
+            for (size_t j = 0; j < m.counters.size(); j++) {
+                const auto& [event, mean] = m.counters[j];
+                os << std::format("{}\"{}\": {:.0f}", j ? ", " : "", PerfCounters::NAMES[event], mean);
+            }
+            os << '}';
+        }
+        os << '}';
+    }
+    os << "\n  ]\n}\n";
+}
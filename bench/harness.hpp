@@ -0,0 +1,80 @@
+#ifndef BENCH_HARNESS_H_INCLUDED
+#define BENCH_HARNESS_H_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include "../common.hpp"
+#include "../counters.hpp"
+#include "../memory_stats.hpp"
+
+// Runs registered benchmarks, each after a few untimed warmup runs, and
+// reports the distribution of their timed runs as a table and as JSON
+class Harness {
+public:
+    struct Options {
+        size_t warmup = 3;
+        size_t repetitions = 30;
+        // Only benchmarks whose name contains it run
+        std::string filter{};
+        // Hardware events of each timed run, where the kernel allows
+        bool counters = false;
+        // Allocations of each timed run, see MemoryStats
+        bool memory = false;
+    };
+
+    struct Benchmark {
+        std::string name;
+        // Work done by one run, throughput is measured in it
+        u64 units;
+        std::string unit;
+        // Untimed, prepares each run, may be empty
+        std::function<void()> setup;
+        std::function<void()> run;
+    };
+
+    struct Measurement {
+        std::string name;
+        u64 units;
+        std::string unit;
+        size_t repetitions;
+        double min_ns;
+        double median_ns;
+        double p99_ns;
+        double mean_ns;
+        // Mean of each event per run, only those that could be read
+        std::vector<std::pair<PerfCounters::Event, double>> counters;
+        // Means per run, zero unless memory was asked for
+        double allocations;
+        double allocated_bytes;
+
+        inline double units_per_second() const noexcept {
+            return median_ns > 0 ? units * 1e9 / median_ns : 0;
+        }
+    };
+
+private:
+    Options options;
+    std::vector<Benchmark> benchmarks{};
+    std::vector<Measurement> measurements{};
+    std::unique_ptr<PerfCounters> counters{};
+
+    Measurement measure(const Benchmark& benchmark) const;
+
+public:
+    Harness(const Options& _options): options{_options} {}
+
+    void add(Benchmark benchmark);
+    // Runs every benchmark passing the filter, in the order added
+    void run();
+
+    inline const std::vector<Measurement>& results() const noexcept { return measurements; }
+    // Null unless counters were asked for
+    inline const PerfCounters* perf_counters() const noexcept { return counters.get(); }
+    void report_table(std::ostream& os) const;
+    // context holds extra "key": value pairs describing the run, already
+    // formatted as JSON
+    void report_json(std::ostream& os, const std::vector<std::pair<std::string, std::string>>& context) const;
+};
+
+#endif
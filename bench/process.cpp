@@ -0,0 +1,126 @@
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "process.hpp"
+
+static double milliseconds(const timeval& time) {
+    return time.tv_sec * 1e3 + time.tv_usec / 1e3;
+}
+
+bool run_main(
+    const char* main_path, const char* program_path, ProcessRun& run,
+    const std::vector<std::string>& environment
+) {
+    int errors[2];
+    if (pipe(errors) < 0)
+        return false;
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        const int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(errors[1], STDERR_FILENO);
+        close(errors[0]);
+        for (const std::string& variable : environment)
+            putenv(const_cast<char*>(variable.c_str()));
+        execl(main_path, main_path, "--file", program_path, nullptr);
+        _exit(127);
+    }
+    close(errors[1]);
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(errors[0], buffer, sizeof(buffer))) > 0)
+        run.errors.append(buffer, n);
+    close(errors[0]);
+    int status;
+    rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0)
+        return false;
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    run.wall_ms = elapsed.count();
+    run.user_ms = milliseconds(usage.ru_utime);
+    run.system_ms = milliseconds(usage.ru_stime);
+    run.max_rss = usage.ru_maxrss;
+    run.status = status;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        run.errors += std::format("main exited with status {}\n", status);
+    return true;
+}
+
+bool run_capturing(
+    const std::vector<std::string>& arguments, ProcessRun& run, std::string& output,
+    const std::vector<std::string>& environment
+) {
+    int printed[2], errors[2];
+    if (pipe(printed) < 0)
+        return false;
+    if (pipe(errors) < 0) {
+        close(printed[0]);
+        close(printed[1]);
+        return false;
+    }
+    std::vector<char*> argv;
+    for (const std::string& argument : arguments)
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    argv.push_back(nullptr);
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        dup2(printed[1], STDOUT_FILENO);
+        dup2(errors[1], STDERR_FILENO);
+        close(printed[0]);
+        close(errors[0]);
+        for (const std::string& variable : environment)
+            putenv(const_cast<char*>(variable.c_str()));
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    close(printed[1]);
+    close(errors[1]);
+    // Both at once, a child filling the pipe not read would never exit
+    pollfd pipes[2] = {{printed[0], POLLIN, 0}, {errors[0], POLLIN, 0}};
+    std::string* into[2] = {&output, &run.errors};
+    size_t open_pipes = 2;
+    char buffer[4096];
+    while (open_pipes > 0) {
+        if (poll(pipes, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (size_t i = 0; i < 2; i++) {
+            if (pipes[i].fd < 0 || pipes[i].revents == 0)
+                continue;
+            const ssize_t n = read(pipes[i].fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                into[i]->append(buffer, n);
+            } else {
+                close(pipes[i].fd);
+                // poll skips negative descriptors
+                pipes[i].fd = -1;
+                open_pipes--;
+            }
+        }
+    }
+    int status;
+    rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0)
+        return false;
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    run.wall_ms = elapsed.count();
+    run.user_ms = milliseconds(usage.ru_utime);
+    run.system_ms = milliseconds(usage.ru_stime);
+    run.max_rss = usage.ru_maxrss;
+    run.status = status;
+    return true;
+}
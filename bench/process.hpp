@@ -0,0 +1,36 @@
+#ifndef BENCH_PROCESS_H_INCLUDED
+#define BENCH_PROCESS_H_INCLUDED
+
+#include "../common.hpp"
+
+// What running main on a program took
+struct ProcessRun {
+    double wall_ms = 0;
+    double user_ms = 0;
+    double system_ms = 0;
+    // Peak resident set, in KB
+    long max_rss = 0;
+    // What it wrote to stderr and how it exited when not with 0, a valid
+    // program leaves it empty
+    std::string errors{};
+    // As wait reports it, 0 when it exited with 0
+    int status = 0;
+};
+
+// Runs main_path --file program_path to completion with its output thrown
+// away, environment holds extra NAME=value pairs, false when it could not
+// be run at all
+bool run_main(
+    const char* main_path, const char* program_path, ProcessRun& run,
+    const std::vector<std::string>& environment = {}
+);
+
+// Runs arguments[0] with arguments to completion keeping what it printed
+// to stdout in output and to stderr in errors, only status tells how it
+// exited, false when it could not be run at all
+bool run_capturing(
+    const std::vector<std::string>& arguments, ProcessRun& run, std::string& output,
+    const std::vector<std::string>& environment = {}
+);
+
+#endif
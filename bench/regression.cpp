@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#include "process.hpp"
+
+// What one program costs, each figure summarizes all of its runs
+struct Metrics {
+    double wall_ms = 0;
+    // User and system time together, the kernel only estimates how they
+    // split
+    double cpu_ms = 0;
+    double max_rss = 0;
+    double allocations = 0;
+};
+
+struct Tolerances {
+    // Relative, 0.1 accepts up to 10% above the baseline
+    // CPU time, what main itself spent running
+    double time = 0.15;
+    double rss = 0.10;
+    double allocations = 0.02;
+    // Time differences below it are noise, whatever the ratio
+    double min_ms = 5;
+    // Likewise for allocations, a few more at startup are not a regression
+    double min_allocations = 100;
+};
+
+// ---- Statistics ----
+
+static double median(std::vector<double> samples) {
+    std::ranges::sort(samples);
+    const size_t middle = samples.size() / 2;
+    return samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+}
+
+// ---- Measuring ----
+
+// Every run of one program so far
+struct Samples {
+    std::vector<double> wall, cpu, rss, allocations;
+    // What main wrote to stderr when it did not run cleanly, no more runs
+    // are made then
+    std::string errors{};
+};
+
+static bool read_allocations(const std::string& path, double& allocations) {
+    std::ifstream file{path};
+    unsigned long long count = 0;
+    if (!(file >> count))
+        return false;
+    allocations = static_cast<double>(count);
+    return true;
+}
+
+// Runs main on program once, only recorded when timed
+static void run_once(
+    const char* main_path, const std::string& program, const std::vector<std::string>& environment,
+    const std::string& output, bool timed, Samples& samples
+) {
+    ProcessRun run;
+    if (!run_main(main_path, program.c_str(), run, environment)) {
+        samples.errors = std::format("can not run {}\n", main_path);
+        return;
+    }
+    if (!run.errors.empty()) {
+        samples.errors = run.errors;
+        return;
+    }
+    if (!timed)
+        return;
+    samples.wall.push_back(run.wall_ms);
+    samples.cpu.push_back(run.user_ms + run.system_ms);
+    samples.rss.push_back(run.max_rss);
+    double count = 0;
+    if (!output.empty() && read_allocations(output, count))
+        samples.allocations.push_back(count);
+}
+
+// The rest of the machine only ever adds time, so the fastest run is the
+// closest to what the program itself costs
+static Metrics summarize(const Samples& samples) {
+    Metrics metrics;
+    metrics.wall_ms = std::ranges::min(samples.wall);
+    metrics.cpu_ms = std::ranges::min(samples.cpu);
+    metrics.max_rss = median(samples.rss);
+    metrics.allocations = samples.allocations.empty() ? 0 : median(samples.allocations);
+    return metrics;
+}
+
+// ---- Baseline ----
+// {"context": {...}, "programs": [{"name": "...", "wall_ms": ..., ...}]},
+// only what write_baseline writes has to be read back
+
+class BaselineReader {
+    const std::string& text;
+    size_t position = 0;
+
+    inline void skip_spaces() noexcept {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+            position++;
+    }
+
+    inline bool consume(char c) noexcept {
+        skip_spaces();
+        if (position < text.size() && text[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool string(std::string& out) {
+        if (!consume('"'))
+            return false;
+        out.clear();
+        while (position < text.size() && text[position] != '"') {
+            if (text[position] == '\\' && position + 1 < text.size())
+                position++;
+            out.push_back(text[position++]);
+        }
+        return consume('"');
+    }
+
+    bool number(double& out) {
+        skip_spaces();
+        const char* start = text.c_str() + position;
+        char* end;
+        out = std::strtod(start, &end);
+        position += end - start;
+        return end != start;
+    }
+
+    // Any value, thrown away
+    bool skip() {
+        skip_spaces();
+        if (position >= text.size())
+            return false;
+        if (text[position] == '"') {
+            std::string ignored;
+            return string(ignored);
+        }
+        if (consume('{') || consume('[')) {
+            const char close = text[position - 1] == '{' ? '}' : ']';
+            if (consume(close))
+                return true;
+            do {
+                std::string ignored;
+                if (close == '}' && (!string(ignored) || !consume(':')))
+                    return false;
+                if (!skip())
+                    return false;
+            } while (consume(','));
+            return consume(close);
+        }
+        double ignored;
+        if (number(ignored))
+            return true;
+        while (position < text.size() && std::isalpha(static_cast<unsigned char>(text[position])))
+            position++;
+        return true;
+    }
+
+    bool program(std::string& name, Metrics& metrics) {
+        if (!consume('{'))
+            return false;
+        do {
+            std::string key;
+            if (!string(key) || !consume(':'))
+                return false;
+            bool read = true;
+            if (key == "name")
+                read = string(name);
+            else if (key == "wall_ms")
+                read = number(metrics.wall_ms);
+            else if (key == "cpu_ms")
+                read = number(metrics.cpu_ms);
+            else if (key == "max_rss_kb")
+                read = number(metrics.max_rss);
+            else if (key == "allocations")
+                read = number(metrics.allocations);
+            else
+                read = skip();
+            if (!read)
+                return false;
+        } while (consume(','));
+        return consume('}');
+    }
+
+public:
+    BaselineReader(const std::string& _text): text{_text} {}
+
+    bool read(std::map<std::string, Metrics>& programs) {
+        if (!consume('{'))
+            return false;
+        do {
+            std::string key;
+            if (!string(key) || !consume(':'))
+                return false;
+            if (key != "programs") {
+                if (!skip())
+                    return false;
+                continue;
+            }
+            if (!consume('['))
+                return false;
+            if (consume(']'))
+                continue;
+            do {
+                std::string name;
+                Metrics metrics;
+                if (!program(name, metrics))
+                    return false;
+                programs[name] = metrics;
+            } while (consume(','));
+            if (!consume(']'))
+                return false;
+        } while (consume(','));
+        return consume('}');
+    }
+};
+
+static void write_baseline(
+    std::ostream& os, const std::vector<std::pair<std::string, Metrics>>& programs, size_t runs
+) {
+    os << std::format("{{\n  \"context\": {{\n    \"runs\": {}\n  }},\n  \"programs\": [", runs);
+    for (size_t i = 0; i < programs.size(); i++) {
+        const auto& [name, metrics] = programs[i];
+        os << std::format(
+            "{}\n    {{\"name\": \"{}\", \"wall_ms\": {:.3f}, \"cpu_ms\": {:.3f}, "
+            "\"max_rss_kb\": {:.0f}, \"allocations\": {:.0f}}}",
+            i ? "," : "", name, metrics.wall_ms, metrics.cpu_ms, metrics.max_rss, metrics.allocations
+        );
+    }
+    os << "\n  ]\n}\n";
+}
+
+// ---- Comparing ----
+
+// Empty when within tolerance, what regressed otherwise. Wall time also
+// counts waiting for the rest of the machine, it is only reported
+static std::string compare(const Metrics& baseline, const Metrics& current, const Tolerances& tolerances) {
+    std::string regressions;
+    auto check = [&](const char* what, double before, double after, double tolerance, double floor) {
+        if (after > before * (1 + tolerance) && after - before > floor)
+            regressions += std::format("{}{}", regressions.empty() ? "" : ", ", what);
+    };
+    check("cpu", baseline.cpu_ms, current.cpu_ms, tolerances.time, tolerances.min_ms);
+    check("rss", baseline.max_rss, current.max_rss, tolerances.rss, 0);
+    // Not counted when either side ran without the preloaded counter
+    if (baseline.allocations > 0 && current.allocations > 0)
+        check("allocations", baseline.allocations, current.allocations, tolerances.allocations, tolerances.min_allocations);
+    return regressions;
+}
+
+static std::string change(double before, double after) {
+    if (before <= 0)
+        return "-";
+    const double percent = (after - before) / before * 100;
+    return std::format("{}{:.1f}%", percent < 0 ? "" : "+", percent);
+}
+
+// ---- Driver ----
+
+static bool parse_number(const char* arg, const char* option, double& out) {
+    const size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0)
+        return false;
+    out = std::strtod(arg + length, nullptr);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Tolerances tolerances;
+    const char* main_path = "./main";
+    const char* baseline_path = "bench/baseline.json";
+    std::string preload;
+    double runs = 5;
+    bool update = false;
+    std::vector<std::string> programs;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        if (
+            parse_number(argv[i], "--runs=", runs) ||
+            parse_number(argv[i], "--time-tolerance=", tolerances.time) ||
+            parse_number(argv[i], "--rss-tolerance=", tolerances.rss) ||
+            parse_number(argv[i], "--allocations-tolerance=", tolerances.allocations) ||
+            parse_number(argv[i], "--min-ms=", tolerances.min_ms) ||
+            parse_number(argv[i], "--min-allocations=", tolerances.min_allocations)
+        ) {
+            continue;
+        } else if (strncmp(argv[i], "--main=", 7) == 0) {
+            main_path = argv[i] + 7;
+        } else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline_path = argv[i] + 11;
+        } else if (strncmp(argv[i], "--count-allocations=", 20) == 0) {
+            // LD_PRELOAD only finds libraries by path when it has a slash
+            preload = std::filesystem::absolute(argv[i] + 20);
+        } else if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (argv[i][0] != '-') {
+            programs.push_back(argv[i]);
+        } else {
+            valid_arguments = false;
+        }
+    }
+    if (!valid_arguments || programs.empty() || runs < 1) {
+        std::cerr << "Usage:\n" ;
+        std::cerr << "   bench/check_regressions [options] program.txt...\n" ;
+        std::cerr << "Options:\n" ;
+        std::cerr << "   --main=path                  interpreter to run, ./main by default\n" ;
+        std::cerr << "   --baseline=path              bench/baseline.json by default\n" ;
+        std::cerr << "   --update                     write the baseline instead of comparing\n" ;
+        std::cerr << "   --runs=N                     timed runs of each program, 5 by default\n" ;
+        std::cerr << "   --count-allocations=path     library preloaded to count allocations\n" ;
+        std::cerr << "   --time-tolerance=X           accepted CPU time growth, 0.15 by default\n" ;
+        std::cerr << "   --rss-tolerance=X            accepted peak RSS growth, 0.10 by default\n" ;
+        std::cerr << "   --allocations-tolerance=X    accepted allocations growth, 0.02 by default\n" ;
+        std::cerr << "   --min-ms=X                   time differences below it pass, 5 by default\n" ;
+        std::cerr << "   --min-allocations=N          allocation differences below it pass, 100 by default\n" ;
+        return 1;
+    }
+
+    const std::string output = preload.empty() ? std::string{} :
+        (std::filesystem::temp_directory_path() / std::format("check_regressions_{}", getpid())).string();
+    std::vector<std::string> environment;
+    if (!preload.empty()) {
+        environment.push_back("LD_PRELOAD=" + preload);
+        environment.push_back("COUNT_ALLOCATIONS_OUTPUT=" + output);
+    }
+    std::vector<Samples> samples(programs.size());
+    // Round robin, so a slow stretch of the machine is spread over all
+    // programs instead of every run of one
+    auto run_rounds = [&](const std::vector<size_t>& which, size_t rounds, bool untimed_first) {
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t i : which) {
+                if (samples[i].errors.empty())
+                    run_once(main_path, programs[i], environment, output, round > 0 || !untimed_first, samples[i]);
+            }
+        }
+    };
+    std::vector<size_t> all(programs.size());
+    for (size_t i = 0; i < programs.size(); i++)
+        all[i] = i;
+    run_rounds(all, static_cast<size_t>(runs) + 1, true);
+    bool failed = false;
+    for (size_t i = 0; i < programs.size(); i++) {
+        if (!samples[i].errors.empty()) {
+            std::cerr << std::format("check_regressions: {}:\n{}", programs[i], samples[i].errors);
+            failed = true;
+        }
+    }
+    auto name_of = [&](size_t i) {
+        return std::filesystem::path{programs[i]}.filename().string();
+    };
+    if (update) {
+        if (!output.empty())
+            std::remove(output.c_str());
+        if (failed)
+            return 1;
+        std::vector<std::pair<std::string, Metrics>> measured;
+        for (size_t i = 0; i < programs.size(); i++)
+            measured.emplace_back(name_of(i), summarize(samples[i]));
+        std::ofstream file{baseline_path};
+        write_baseline(file, measured, static_cast<size_t>(runs));
+        if (!file) {
+            std::cerr << std::format("check_regressions: can not write {}\n", baseline_path);
+            return 1;
+        }
+        std::cout << std::format("{} programs written to {}\n", measured.size(), baseline_path);
+        return 0;
+    }
+
+    std::ifstream file{baseline_path};
+    std::stringstream text;
+    text << file.rdbuf();
+    std::map<std::string, Metrics> baseline;
+    if (!file || !BaselineReader{text.str()}.read(baseline)) {
+        std::cerr << std::format("check_regressions: can not read {}\n", baseline_path);
+        return 1;
+    }
+    // A program that looks worse gets more runs before it counts, up to
+    // three times. A slow stretch of the machine passes, a regression
+    // does not
+    for (size_t retry = 0; retry < 3; retry++) {
+        std::vector<size_t> suspects;
+        for (size_t i = 0; i < programs.size(); i++) {
+            const auto found = baseline.find(name_of(i));
+            if (
+                samples[i].errors.empty() && found != baseline.end() &&
+                !compare(found->second, summarize(samples[i]), tolerances).empty()
+            )
+                suspects.push_back(i);
+        }
+        if (suspects.empty())
+            break;
+        run_rounds(suspects, static_cast<size_t>(runs), false);
+    }
+    if (!output.empty())
+        std::remove(output.c_str());
+    std::cout << std::format(
+        "{:<28}{:>12}{:>9}{:>12}{:>9}{:>12}{:>9}{:>14}{:>9}  {}\n",
+        "program", "wall ms", "", "cpu ms", "", "rss KB", "", "allocations", "", ""
+    );
+    for (size_t i = 0; i < programs.size(); i++) {
+        if (!samples[i].errors.empty())
+            continue;
+        const std::string name = name_of(i);
+        const Metrics current = summarize(samples[i]);
+        const auto found = baseline.find(name);
+        std::string verdict = "new";
+        Metrics before;
+        if (found != baseline.end()) {
+            before = found->second;
+            verdict = compare(before, current, tolerances);
+            if (verdict.empty()) {
+                verdict = "ok";
+            } else {
+                verdict = "REGRESSION: " + verdict;
+                failed = true;
+            }
+        }
+        std::cout << std::format(
+            "{:<28}{:>12.1f}{:>9}{:>12.1f}{:>9}{:>12.0f}{:>9}{:>14.0f}{:>9}  {}\n",
+            name,
+            current.wall_ms, change(before.wall_ms, current.wall_ms),
+            current.cpu_ms, change(before.cpu_ms, current.cpu_ms),
+            current.max_rss, change(before.max_rss, current.max_rss),
+            current.allocations, change(before.allocations, current.allocations),
+            verdict
+        );
+    }
+    return failed ? 1 : 0;
+}
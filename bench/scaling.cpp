@@ -0,0 +1,136 @@
+#include <cmath>
+#include <fstream>
+#include "generator.hpp"
+#include "process.hpp"
+
+struct Run {
+    u64 bytes;
+    ProcessRun process;
+
+    inline double cpu_ms() const noexcept { return process.user_ms + process.system_ms; }
+};
+
+// How fast y grows against x between two runs, 1 is linear
+static double exponent(double x0, double x1, double y0, double y1) {
+    if (y0 <= 0 || y1 <= 0)
+        return 0;
+    return std::log(y1 / y0) / std::log(x1 / x0);
+}
+
+static bool parse_number(const char* arg, const char* option, double& out) {
+    const size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0)
+        return false;
+    out = std::strtod(arg + length, nullptr);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    ProgramGenerator::Options options;
+    const char* main_path = "./main";
+    const char* program_path = "/tmp/scaling_program.txt";
+    double min_mb = 0.125, max_mb = 4, tolerance = 1.25, seed = 1;
+    // Runs shorter than it are mostly process start up, too noisy to judge
+    double min_ms = 20;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        if (
+            parse_number(argv[i], "--min-mb=", min_mb) ||
+            parse_number(argv[i], "--max-mb=", max_mb) ||
+            parse_number(argv[i], "--tolerance=", tolerance) ||
+            parse_number(argv[i], "--min-ms=", min_ms) ||
+            parse_number(argv[i], "--seed=", seed)
+        ) {
+            continue;
+        } else if (strncmp(argv[i], "--main=", 7) == 0) {
+            main_path = argv[i] + 7;
+        } else if (strncmp(argv[i], "--program=", 10) == 0) {
+            program_path = argv[i] + 10;
+        } else {
+            valid_arguments = false;
+        }
+    }
+    if (!valid_arguments || min_mb <= 0 || max_mb < min_mb * 2 || tolerance <= 0) {
+        std::cerr << "Usage:\n" ;
+        std::cerr << "   bench/scaling_report [options]\n" ;
+        std::cerr << "Options:\n" ;
+        std::cerr << "   --main=path        interpreter to run, ./main by default\n" ;
+        std::cerr << "   --min-mb=X         smallest program, 0.125 by default\n" ;
+        std::cerr << "   --max-mb=X         largest program, sizes double up to it, 4 by default\n" ;
+        std::cerr << "   --tolerance=X      highest growth exponent accepted, 1.25 by default\n" ;
+        std::cerr << "   --min-ms=X         shorter runs are not judged, 20 by default\n" ;
+        std::cerr << "   --seed=N           seed of the generated programs, 1 by default\n" ;
+        std::cerr << "   --program=path     where programs are written, /tmp/scaling_program.txt by default\n" ;
+        return 1;
+    }
+    options.seed = static_cast<u64>(seed);
+
+    // What main takes with nothing to run, only memory on top of it is
+    // judged
+    ProcessRun empty;
+    if (!(std::ofstream{program_path} << "") || !run_main(main_path, program_path, empty)) {
+        std::cerr << std::format("scaling_report: can not run {}\n", main_path);
+        return 1;
+    }
+    std::vector<Run> runs;
+    for (double mb = min_mb; mb <= max_mb * 1.0001; mb *= 2) {
+        options.bytes = static_cast<u64>(mb * (1 << 20));
+        const std::string program = ProgramGenerator{options}.generate();
+        if (!(std::ofstream{program_path} << program)) {
+            std::cerr << std::format("scaling_report: can not write {}\n", program_path);
+            return 1;
+        }
+        Run run{program.size(), {}};
+        if (!run_main(main_path, program_path, run.process)) {
+            std::cerr << std::format("scaling_report: can not run {}\n", main_path);
+            return 1;
+        }
+        runs.push_back(std::move(run));
+    }
+    std::remove(program_path);
+
+    // Each size is judged against the previous one, the exponent is the
+    // slope of the log-log curve between them
+    bool failed = false;
+    std::cout << std::format(
+        "{:>12}{:>12}{:>12}{:>12}{:>10}{:>10}  {}\n",
+        "bytes", "wall ms", "cpu ms", "rss KB", "time exp", "rss exp", ""
+    );
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Run& run = runs[i];
+        std::string time_exponent = "-", rss_exponent = "-", verdict;
+        if (!run.process.errors.empty()) {
+            verdict = "ERRORS";
+            failed = true;
+        }
+        if (i > 0) {
+            const Run& previous = runs[i - 1];
+            const double time = exponent(previous.bytes, run.bytes, previous.cpu_ms(), run.cpu_ms());
+            const double rss = exponent(
+                previous.bytes, run.bytes,
+                previous.process.max_rss - empty.max_rss, run.process.max_rss - empty.max_rss
+            );
+            time_exponent = std::format("{:.2f}", time);
+            rss_exponent = std::format("{:.2f}", rss);
+            if (previous.cpu_ms() >= min_ms && time > tolerance) {
+                verdict += verdict.empty() ? "SUPERLINEAR TIME" : ", SUPERLINEAR TIME";
+                failed = true;
+            }
+            if (rss > tolerance) {
+                verdict += verdict.empty() ? "SUPERLINEAR MEMORY" : ", SUPERLINEAR MEMORY";
+                failed = true;
+            }
+        }
+        std::cout << std::format(
+            "{:>12}{:>12.1f}{:>12.1f}{:>12}{:>10}{:>10}  {}\n",
+            run.bytes, run.process.wall_ms, run.cpu_ms(), run.process.max_rss, time_exponent, rss_exponent, verdict
+        );
+    }
+    for (const Run& run : runs) {
+        if (!run.process.errors.empty()) {
+            std::cerr << std::format("{} bytes:\n{}", run.bytes, run.process.errors);
+            break;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,540 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include "bigint.hpp"
+
+using Limb = BigInteger::Limb;
+using Magnitude = std::vector<Limb>;
+
+// Below this many limbs schoolbook multiplication beats Karatsuba
+static constexpr size_t KARATSUBA_THRESHOLD = 32;
+static constexpr u64 LIMB_BASE = u64{1} << 32;
+// Largest power of ten in a limb, used for decimal conversion
+static constexpr Limb DECIMAL_BASE = 1000000000;
+static constexpr size_t DECIMAL_BASE_DIGITS = 9;
+
+// ------------------------- Magnitude -------------------------
+
+static void trim_magnitude(Magnitude& m) noexcept {
+    while (!m.empty() && m.back() == 0)
+        m.pop_back();
+}
+
+static int compare_magnitudes(const Magnitude& a, const Magnitude& b) noexcept {
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static Magnitude add_magnitudes(const Limb* a, size_t n, const Limb* b, size_t m) noexcept {
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    Magnitude sum(n + 1, 0);
+    u64 carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        u64 s = u64{a[i]} + (i < m ? b[i] : 0) + carry;
+        sum[i] = static_cast<Limb>(s);
+        carry = s >> 32;
+    }
+    sum[n] = static_cast<Limb>(carry);
+    trim_magnitude(sum);
+    return sum;
+}
+
+// a -= b, requires a >= b
+static void subtract_in_place(Magnitude& a, const Limb* b, size_t m) noexcept {
+    u64 borrow = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (i >= m && borrow == 0) break;
+        u64 d = u64{a[i]} - (i < m ? b[i] : 0) - borrow;
+        a[i] = static_cast<Limb>(d);
+        // A negative difference wraps around and sets the top bit
+        borrow = d >> 63;
+    }
+    trim_magnitude(a);
+}
+
+// r += b * base^offset, r must be wide enough to hold the sum
+static void add_in_place(Magnitude& r, size_t offset, const Limb* b, size_t m) noexcept {
+    u64 carry = 0;
+    for (size_t i = 0; i < m; i++) {
+        u64 s = u64{r[offset + i]} + b[i] + carry;
+        r[offset + i] = static_cast<Limb>(s);
+        carry = s >> 32;
+    }
+    for (size_t k = offset + m; carry && k < r.size(); k++) {
+        u64 s = u64{r[k]} + carry;
+        r[k] = static_cast<Limb>(s);
+        carry = s >> 32;
+    }
+}
+
+// out must hold n+m zeroed limbs
+static void multiply_schoolbook(const Limb* a, size_t n, const Limb* b, size_t m, Limb* out) noexcept {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] == 0) continue;
+        u64 carry = 0;
+        for (size_t j = 0; j < m; j++) {
+            // (2^32-1)^2 + 2*(2^32-1) still fits in 64 bits
+            u64 t = u64{a[i]} * b[j] + out[i + j] + carry;
+            out[i + j] = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+        out[i + m] = static_cast<Limb>(carry);
+    }
+}
+
+static Magnitude multiply_magnitudes(const Limb* a, size_t n, const Limb* b, size_t m) noexcept {
+    if (n == 0 || m == 0)
+        return Magnitude{};
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    // From here on n >= m
+    Magnitude product(n + m, 0);
+    if (m < KARATSUBA_THRESHOLD) {
+        multiply_schoolbook(a, n, b, m, product.data());
+        trim_magnitude(product);
+        return product;
+    }
+    if (2 * m <= n) {
+        // Unbalanced operands, multiply b by m limbs of a at a time
+        // so every recursive call splits evenly
+        for (size_t offset = 0; offset < n; offset += m) {
+            size_t length = std::min(m, n - offset);
+            Magnitude part = multiply_magnitudes(a + offset, length, b, m);
+            add_in_place(product, offset, part.data(), part.size());
+        }
+        trim_magnitude(product);
+        return product;
+    }
+    // Karatsuba: with x = x1*B^h + x0
+    // a*b = z2*B^2h + z1*B^h + z0 where
+    // z1 = (a0+a1)*(b0+b1) - z2 - z0
+    const size_t half = n / 2;
+    Magnitude z0 = multiply_magnitudes(a, half, b, half);
+    Magnitude z2 = multiply_magnitudes(a + half, n - half, b + half, m - half);
+    Magnitude a_sum = add_magnitudes(a, half, a + half, n - half);
+    Magnitude b_sum = add_magnitudes(b, half, b + half, m - half);
+    Magnitude z1 = multiply_magnitudes(a_sum.data(), a_sum.size(), b_sum.data(), b_sum.size());
+    subtract_in_place(z1, z0.data(), z0.size());
+    subtract_in_place(z1, z2.data(), z2.size());
+    add_in_place(product, 0, z0.data(), z0.size());
+    add_in_place(product, half, z1.data(), z1.size());
+    add_in_place(product, 2 * half, z2.data(), z2.size());
+    trim_magnitude(product);
+    return product;
+}
+
+// m = m * factor + addend
+static void multiply_add_small(Magnitude& m, Limb factor, Limb addend) noexcept {
+    u64 carry = addend;
+    for (Limb& limb : m) {
+        u64 t = u64{limb} * factor + carry;
+        limb = static_cast<Limb>(t);
+        carry = t >> 32;
+    }
+    if (carry)
+        m.push_back(static_cast<Limb>(carry));
+}
+
+// m /= divisor, returns remainder
+static Limb divide_small(Magnitude& m, Limb divisor) noexcept {
+    u64 remainder = 0;
+    for (size_t i = m.size(); i-- > 0;) {
+        u64 current = (remainder << 32) | m[i];
+        m[i] = static_cast<Limb>(current / divisor);
+        remainder = current % divisor;
+    }
+    trim_magnitude(m);
+    return static_cast<Limb>(remainder);
+}
+
+// Knuth's algorithm D, v must not be zero
+static void divide_magnitudes(
+    const Magnitude& u, const Magnitude& v,
+    Magnitude& quotient, Magnitude& remainder
+) noexcept {
+    if (compare_magnitudes(u, v) < 0) {
+        quotient.clear();
+        remainder = u;
+        return;
+    }
+    if (v.size() == 1) {
+        quotient = u;
+        Limb r = divide_small(quotient, v[0]);
+        remainder.clear();
+        if (r) remainder.push_back(r);
+        return;
+    }
+    const size_t n = v.size();
+    const size_t m = u.size() - n;
+    // Normalize so the divisor's top limb has its high bit set
+    const int s = std::countl_zero(v.back());
+    Magnitude vn(n), un(u.size() + 1);
+    for (size_t i = n - 1; i > 0; i--)
+        vn[i] = (v[i] << s) | (s ? static_cast<Limb>(u64{v[i - 1]} >> (32 - s)) : 0);
+    vn[0] = v[0] << s;
+    un[u.size()] = s ? static_cast<Limb>(u64{u.back()} >> (32 - s)) : 0;
+    for (size_t i = u.size() - 1; i > 0; i--)
+        un[i] = (u[i] << s) | (s ? static_cast<Limb>(u64{u[i - 1]} >> (32 - s)) : 0);
+    un[0] = u[0] << s;
+
+    quotient.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;) {
+        // Estimate this quotient limb from the top two limbs
+        u64 numerator = (u64{un[j + n]} << 32) | un[j + n - 1];
+        u64 qhat = numerator / vn[n - 1];
+        u64 rhat = numerator % vn[n - 1];
+        while (
+            qhat >= LIMB_BASE ||
+            qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])
+        ) {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >= LIMB_BASE) break;
+        }
+        // Multiply and subtract
+        i64 borrow = 0;
+        i64 t;
+        for (size_t i = 0; i < n; i++) {
+            u64 p = qhat * vn[i];
+            t = static_cast<i64>(un[i + j]) - borrow - static_cast<i64>(p & 0xFFFFFFFF);
+            un[i + j] = static_cast<Limb>(t);
+            borrow = static_cast<i64>(p >> 32) - (t >> 32);
+        }
+        t = static_cast<i64>(un[j + n]) - borrow;
+        un[j + n] = static_cast<Limb>(t);
+        quotient[j] = static_cast<Limb>(qhat);
+        if (t < 0) {
+            // Estimate was one too large, add back
+            quotient[j]--;
+            u64 carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                u64 sum = u64{un[i + j]} + vn[i] + carry;
+                un[i + j] = static_cast<Limb>(sum);
+                carry = sum >> 32;
+            }
+            un[j + n] += static_cast<Limb>(carry);
+        }
+    }
+    trim_magnitude(quotient);
+    // Denormalize remainder
+    remainder.assign(n, 0);
+    for (size_t i = 0; i < n; i++)
+        remainder[i] = (un[i] >> s) | (s ? static_cast<Limb>(u64{un[i + 1]} << (32 - s)) : 0);
+    trim_magnitude(remainder);
+}
+
+static Magnitude shift_left_magnitude(const Magnitude& m, u64 count) noexcept {
+    if (m.empty()) return Magnitude{};
+    const size_t limbs = count / 32;
+    const unsigned bits = count % 32;
+    Magnitude shifted(m.size() + limbs + 1, 0);
+    for (size_t i = 0; i < m.size(); i++) {
+        u64 wide = u64{m[i]} << bits;
+        shifted[i + limbs] |= static_cast<Limb>(wide);
+        shifted[i + limbs + 1] |= static_cast<Limb>(wide >> 32);
+    }
+    trim_magnitude(shifted);
+    return shifted;
+}
+
+static Magnitude shift_right_magnitude(const Magnitude& m, u64 count) noexcept {
+    const u64 limbs = count / 32;
+    const unsigned bits = count % 32;
+    if (limbs >= m.size()) return Magnitude{};
+    Magnitude shifted(m.size() - limbs, 0);
+    for (size_t i = 0; i < shifted.size(); i++) {
+        u64 wide = m[i + limbs];
+        if (i + limbs + 1 < m.size())
+            wide |= u64{m[i + limbs + 1]} << 32;
+        shifted[i] = static_cast<Limb>(wide >> bits);
+    }
+    trim_magnitude(shifted);
+    return shifted;
+}
+
+static Magnitude magnitude_of(u64 value) noexcept {
+    Magnitude m{static_cast<Limb>(value), static_cast<Limb>(value >> 32)};
+    trim_magnitude(m);
+    return m;
+}
+
+// ------------------------- Magnitude -------------------------
+
+// ------------------------- BigInteger -------------------------
+
+BigInteger::BigInteger(i64 value) {
+    negative = value < 0;
+    // Negating in unsigned arithmetic is fine for INT64_MIN too
+    u64 m = negative ? -static_cast<u64>(value) : static_cast<u64>(value);
+    limbs = magnitude_of(m);
+}
+
+void BigInteger::trim() noexcept {
+    trim_magnitude(limbs);
+    if (limbs.empty())
+        negative = false;
+}
+
+bool BigInteger::parse(std::string_view text, BigInteger& out) noexcept {
+    bool is_negative = false;
+    if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+        is_negative = text.front() == '-';
+        text.remove_prefix(1);
+    }
+    if (text.empty()) return false;
+    Magnitude m;
+    // Consume 9 digits at a time so each step is a single limb multiply
+    size_t first = text.size() % DECIMAL_BASE_DIGITS;
+    if (first == 0) first = DECIMAL_BASE_DIGITS;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t length = pos == 0 ? first : DECIMAL_BASE_DIGITS;
+        Limb chunk = 0, factor = 1;
+        for (size_t i = pos; i < pos + length; i++) {
+            if (text[i] < '0' || text[i] > '9') return false;
+            chunk = chunk * 10 + static_cast<Limb>(text[i] - '0');
+            factor *= 10;
+        }
+        multiply_add_small(m, factor, chunk);
+        pos += length;
+    }
+    out.limbs = std::move(m);
+    out.negative = is_negative;
+    out.trim();
+    return true;
+}
+
+BigInteger BigInteger::from_float64(float64 value) noexcept {
+    value = std::trunc(value);
+    if (value > -0x1p63L && value < 0x1p63L)
+        return BigInteger{static_cast<i64>(value)};
+    BigInteger result;
+    // Take the top 64 bits as an integer then scale them back up
+    const int shift = std::ilogb(value) - 63;
+    const float64 top = std::ldexp(std::fabs(value), -shift);
+    result.limbs = shift_left_magnitude(
+        magnitude_of(static_cast<u64>(top)), static_cast<u64>(shift)
+    );
+    result.negative = value < 0;
+    return result;
+}
+
+bool BigInteger::fits_i64() const noexcept {
+    if (limbs.size() > 2) return false;
+    u64 m = 0;
+    for (size_t i = limbs.size(); i-- > 0;)
+        m = (m << 32) | limbs[i];
+    const u64 limit = u64{1} << 63;
+    return negative ? m <= limit : m < limit;
+}
+
+i64 BigInteger::to_i64() const noexcept {
+    u64 m = 0;
+    for (size_t i = limbs.size(); i-- > 0;)
+        m = (m << 32) | limbs[i];
+    return static_cast<i64>(negative ? -m : m);
+}
+
+float64 BigInteger::to_float64() const noexcept {
+    // Three limbs carry more bits than any float64 mantissa
+    float64 result = 0.0;
+    const size_t used = std::min<size_t>(limbs.size(), 3);
+    for (size_t i = 0; i < used; i++)
+        result = result * static_cast<float64>(LIMB_BASE) + limbs[limbs.size() - 1 - i];
+    result = std::ldexp(result, static_cast<int>(32 * (limbs.size() - used)));
+    return negative ? -result : result;
+}
+
+u64 BigInteger::bit_length() const noexcept {
+    if (limbs.empty()) return 0;
+    return 32 * (limbs.size() - 1) + (32 - std::countl_zero(limbs.back()));
+}
+
+std::string BigInteger::to_string() const noexcept {
+    if (limbs.empty()) return std::string("0");
+    Magnitude m = limbs;
+    std::vector<Limb> chunks;
+    while (!m.empty())
+        chunks.push_back(divide_small(m, DECIMAL_BASE));
+    std::string digits;
+    if (negative) digits.push_back('-');
+    digits += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        std::string chunk = std::to_string(chunks[i]);
+        digits.append(DECIMAL_BASE_DIGITS - chunk.size(), '0');
+        digits += chunk;
+    }
+    return digits;
+}
+
+int BigInteger::compare(const BigInteger& other) const noexcept {
+    if (negative != other.negative)
+        return negative ? -1 : 1;
+    int c = compare_magnitudes(limbs, other.limbs);
+    return negative ? -c : c;
+}
+
+BigInteger BigInteger::operator-() const noexcept {
+    BigInteger result = *this;
+    if (!result.limbs.empty())
+        result.negative = !negative;
+    return result;
+}
+
+BigInteger BigInteger::operator~() const noexcept {
+    // ~x == -x - 1
+    return -(*this) - BigInteger{1};
+}
+
+BigInteger BigInteger::operator+(const BigInteger& other) const noexcept {
+    BigInteger result;
+    if (negative == other.negative) {
+        result.limbs = add_magnitudes(
+            limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size()
+        );
+        result.negative = negative;
+    } else if (compare_magnitudes(limbs, other.limbs) >= 0) {
+        result.limbs = limbs;
+        subtract_in_place(result.limbs, other.limbs.data(), other.limbs.size());
+        result.negative = negative;
+    } else {
+        result.limbs = other.limbs;
+        subtract_in_place(result.limbs, limbs.data(), limbs.size());
+        result.negative = other.negative;
+    }
+    result.trim();
+    return result;
+}
+
+BigInteger BigInteger::operator-(const BigInteger& other) const noexcept {
+    return *this + (-other);
+}
+
+BigInteger BigInteger::operator*(const BigInteger& other) const noexcept {
+    BigInteger result;
+    result.limbs = multiply_magnitudes(
+        limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size()
+    );
+    result.negative = negative != other.negative;
+    result.trim();
+    return result;
+}
+
+BigInteger BigInteger::operator<<(u64 count) const noexcept {
+    BigInteger result;
+    result.limbs = shift_left_magnitude(limbs, count);
+    result.negative = negative;
+    result.trim();
+    return result;
+}
+
+BigInteger BigInteger::operator>>(u64 count) const noexcept {
+    BigInteger result;
+    if (!negative) {
+        result.limbs = shift_right_magnitude(limbs, count);
+        return result;
+    }
+    // Round towards negative infinity: -(((|x| - 1) >> count) + 1)
+    Magnitude m = limbs;
+    const Limb one = 1;
+    subtract_in_place(m, &one, 1);
+    m = shift_right_magnitude(m, count);
+    result.limbs = add_magnitudes(m.data(), m.size(), &one, 1);
+    result.negative = true;
+    result.trim();
+    return result;
+}
+
+std::vector<Limb> BigInteger::to_twos_complement(size_t count) const noexcept {
+    std::vector<Limb> bits(count, 0);
+    std::copy(limbs.begin(), limbs.end(), bits.begin());
+    if (negative) {
+        u64 carry = 1;
+        for (Limb& limb : bits) {
+            u64 t = u64{static_cast<Limb>(~limb)} + carry;
+            limb = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+    }
+    return bits;
+}
+
+BigInteger BigInteger::from_twos_complement(std::vector<Limb>&& bits) noexcept {
+    BigInteger result;
+    result.negative = !bits.empty() && (bits.back() >> 31);
+    if (result.negative) {
+        u64 carry = 1;
+        for (Limb& limb : bits) {
+            u64 t = u64{static_cast<Limb>(~limb)} + carry;
+            limb = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+    }
+    result.limbs = std::move(bits);
+    result.trim();
+    return result;
+}
+
+BigInteger BigInteger::operator&(const BigInteger& other) const noexcept {
+    // One spare limb keeps the sign bit of either operand
+    const size_t count = std::max(limbs.size(), other.limbs.size()) + 1;
+    std::vector<Limb> a = to_twos_complement(count);
+    std::vector<Limb> b = other.to_twos_complement(count);
+    for (size_t i = 0; i < count; i++) a[i] &= b[i];
+    return from_twos_complement(std::move(a));
+}
+
+BigInteger BigInteger::operator|(const BigInteger& other) const noexcept {
+    const size_t count = std::max(limbs.size(), other.limbs.size()) + 1;
+    std::vector<Limb> a = to_twos_complement(count);
+    std::vector<Limb> b = other.to_twos_complement(count);
+    for (size_t i = 0; i < count; i++) a[i] |= b[i];
+    return from_twos_complement(std::move(a));
+}
+
+BigInteger BigInteger::operator^(const BigInteger& other) const noexcept {
+    const size_t count = std::max(limbs.size(), other.limbs.size()) + 1;
+    std::vector<Limb> a = to_twos_complement(count);
+    std::vector<Limb> b = other.to_twos_complement(count);
+    for (size_t i = 0; i < count; i++) a[i] ^= b[i];
+    return from_twos_complement(std::move(a));
+}
+
+BigInteger BigInteger::pow(u64 exponent) const noexcept {
+    // Exponentiation by squaring
+    BigInteger result{1};
+    BigInteger base = *this;
+    while (exponent) {
+        if (exponent & 1)
+            result = result * base;
+        exponent >>= 1;
+        if (exponent)
+            base = base * base;
+    }
+    return result;
+}
+
+void BigInteger::divmod(
+    const BigInteger& dividend, const BigInteger& divisor,
+    BigInteger& quotient, BigInteger& remainder
+) noexcept {
+    Magnitude q, r;
+    divide_magnitudes(dividend.limbs, divisor.limbs, q, r);
+    quotient.limbs = std::move(q);
+    quotient.negative = dividend.negative != divisor.negative;
+    quotient.trim();
+    remainder.limbs = std::move(r);
+    remainder.negative = dividend.negative;
+    remainder.trim();
+}
+
+// ------------------------- BigInteger -------------------------
@@ -0,0 +1,69 @@
+#ifndef BIGINT_H_INCLUDED
+#define BIGINT_H_INCLUDED
+
+#include <string_view>
+#include "common.hpp"
+
+// Arbitrary precision integer, sign and magnitude
+// Only reached once i64 arithmetic overflows
+class BigInteger {
+public:
+    using Limb = u32;
+    // Largest result size powers and shifts may produce
+    static constexpr u64 MAX_BITS = u64{1} << 26;
+
+private:
+    // Magnitude, least significant limb first, no leading zero limbs
+    // Zero is an empty vector and never negative
+    std::vector<Limb> limbs{};
+    bool negative = false;
+
+    void trim() noexcept;
+    static BigInteger from_twos_complement(std::vector<Limb>&& limbs) noexcept;
+    std::vector<Limb> to_twos_complement(size_t count) const noexcept;
+
+public:
+    BigInteger() = default;
+    BigInteger(i64 value);
+
+    // Parse an optionally signed decimal, false on malformed text
+    static bool parse(std::string_view text, BigInteger& out) noexcept;
+    // Truncates towards zero, value must be finite
+    static BigInteger from_float64(float64 value) noexcept;
+
+    inline bool is_zero() const noexcept { return limbs.empty(); }
+    inline bool is_negative() const noexcept { return negative; }
+    bool fits_i64() const noexcept;
+    i64 to_i64() const noexcept;
+    float64 to_float64() const noexcept;
+    u64 bit_length() const noexcept;
+    // Of the limbs, for allocation accounting
+    inline u64 heap_bytes() const noexcept { return limbs.capacity() * sizeof(Limb); }
+    std::string to_string() const noexcept;
+
+    int compare(const BigInteger& other) const noexcept;
+    inline bool operator==(const BigInteger& other) const noexcept {
+        return negative == other.negative && limbs == other.limbs;
+    }
+
+    BigInteger operator-() const noexcept;
+    BigInteger operator~() const noexcept;
+    BigInteger operator+(const BigInteger& other) const noexcept;
+    BigInteger operator-(const BigInteger& other) const noexcept;
+    BigInteger operator*(const BigInteger& other) const noexcept;
+    BigInteger operator<<(u64 count) const noexcept;
+    // Arithmetic shift, rounds towards negative infinity like i64 >>
+    BigInteger operator>>(u64 count) const noexcept;
+    BigInteger operator&(const BigInteger& other) const noexcept;
+    BigInteger operator|(const BigInteger& other) const noexcept;
+    BigInteger operator^(const BigInteger& other) const noexcept;
+    BigInteger pow(u64 exponent) const noexcept;
+
+    // Truncating division like i64 / and %, divisor must be non-zero
+    static void divmod(
+        const BigInteger& dividend, const BigInteger& divisor,
+        BigInteger& quotient, BigInteger& remainder
+    ) noexcept;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "budget.hpp"
+#include "memory_stats.hpp"
+
+void Budget::start(const Limits& _limits) noexcept {
+    start(_limits, MemoryStats::total().live);
+}
+
+void Budget::start(const Limits& _limits, u64 _heap_base) noexcept {
+    limits = _limits;
+    steps = 0;
+    heap_base = _heap_base;
+    error_message.clear();
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{limits.timeout_ms};
+    // Only counted while someone looks, nothing is live before that
+    if (limits.max_heap)
+        MemoryStats::enable();
+    if (!limits.max_steps && !limits.timeout_ms && !limits.max_heap)
+        interval = std::numeric_limits<u64>::max();
+    else if (limits.max_steps)
+        // The step after the last one allowed is checked
+        interval = std::min(CHECK_INTERVAL, limits.max_steps + 1);
+    else
+        interval = CHECK_INTERVAL;
+    countdown = interval;
+}
+
+bool Budget::fail(const std::string& msg) noexcept {
+    if (error_message.empty())
+        error_message = msg;
+    // Every step after fails as well
+    interval = countdown = 1;
+    return false;
+}
+
+bool Budget::check() noexcept {
+    if (exhausted())
+        return fail(error_message);
+    steps += interval;
+    if (limits.max_steps && steps > limits.max_steps)
+        return fail(std::format("Step limit of {} exceeded", limits.max_steps));
+    if (limits.timeout_ms && std::chrono::steady_clock::now() > deadline)
+        return fail(std::format("Time limit of {} ms exceeded", limits.timeout_ms));
+    if (!check_heap())
+        return false;
+    interval = limits.max_steps
+        ? std::min(CHECK_INTERVAL, limits.max_steps + 1 - steps)
+        : CHECK_INTERVAL;
+    countdown = interval;
+    return true;
+}
+
+bool Budget::check_heap() noexcept {
+    const u64 live = MemoryStats::total().live;
+    if (limits.max_heap && live - std::min(live, heap_base) > limits.max_heap)
+        return fail(std::format("Heap limit of {} bytes exceeded", limits.max_heap));
+    return !exhausted();
+}
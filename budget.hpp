@@ -0,0 +1,69 @@
+#ifndef BUDGET_H_INCLUDED
+#define BUDGET_H_INCLUDED
+
+#include <chrono>
+#include <limits>
+#include "common.hpp"
+
+// Limits on what one run of an untrusted program may take, for
+// --max-steps, --timeout-ms and --max-heap or set by whoever embeds the
+// interpreter, a limit of 0 is none
+// Every engine takes a step per node, closure statement or IR
+// instruction, a decrement and a branch; the clock and the heap are only
+// looked at every CHECK_INTERVAL steps, so a run may overshoot them by
+// that many steps' worth
+// The heap is what MemoryStats counts, syntax trees and objects included,
+// from the start of the run on. Operators producing strings and big
+// integers, which may grow a lot in one step, and the end of the run
+// check it as well
+class Budget {
+public:
+    struct Limits {
+        u64 max_steps = 0;
+        u64 timeout_ms = 0;
+        u64 max_heap = 0;
+    };
+
+    static constexpr u64 CHECK_INTERVAL = 1024;
+
+private:
+    Limits limits{};
+    // Steps left before check(), those of the interval before it
+    u64 countdown = std::numeric_limits<u64>::max();
+    u64 interval = std::numeric_limits<u64>::max();
+    u64 steps = 0;
+    // Live bytes not counted against the heap limit
+    u64 heap_base = 0;
+    std::chrono::steady_clock::time_point deadline{};
+    std::string error_message{};
+
+    bool check() noexcept;
+    bool fail(const std::string& msg) noexcept;
+
+public:
+    // Counts against limits from now on, steps, time and the heap start over
+    void start(const Limits& _limits) noexcept;
+    // Like start, but the heap counts from when heap_base bytes were live,
+    // to include what was allocated for the run before it started
+    void start(const Limits& _limits, u64 _heap_base) noexcept;
+    inline const Limits& current() const noexcept { return limits; }
+
+    // false once a limit is exceeded, and from then on
+    inline bool step() noexcept {
+        return --countdown != 0 || check();
+    }
+    // The heap limit alone, for allocations made outside a run
+    bool check_heap() noexcept;
+    // check_heap() after an operation that may have allocated a lot,
+    // nearly free without a heap limit
+    inline bool check_allocation() noexcept {
+        return !limits.max_heap || check_heap();
+    }
+
+    inline bool exhausted() const noexcept { return !error_message.empty(); }
+    // Which limit was exceeded, empty while none is
+    inline const std::string& error() const noexcept { return error_message; }
+    inline u64 steps_taken() const noexcept { return steps + interval - countdown; }
+};
+
+#endif
@@ -0,0 +1,402 @@
+#include "closure_compiler.hpp"
+#include "trace.hpp"
+
+using Closure = ClosureCompiler::Closure;
+
+Closure ClosureCompiler::compile(TreeBase* tree) {
+    scopes.clear();
+    // Globals declared by tree
+    scopes.emplace_back();
+    return compile_node(tree);
+}
+
+InterpreterResult ClosureCompiler::run(const Closure& program) {
+    Value value;
+    if (!program(value))
+        return interpreter.fail(error_message);
+    return interpreter.finish(InterpreterResult::Ok(value.box()));
+}
+
+bool ClosureCompiler::fail(const std::string& msg) noexcept {
+    error_message = msg;
+    return false;
+}
+
+bool ClosureCompiler::unwrap(const ValueResult& result, Value& value) noexcept {
+    if (result.is_error())
+        return fail(result.unwrap_error());
+    value = result.unwrap();
+    return true;
+}
+
+Slot** ClosureCompiler::resolve(const std::string& name) noexcept {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); scope++) {
+        auto entry = scope->find(name);
+        if (entry != scope->end())
+            return entry->second;
+    }
+    // Defined by an earlier run
+    SlotResult slot = interpreter.environment().lookup(name);
+    if (slot.is_error())
+        return nullptr;
+    cells.push_back(slot.unwrap());
+    return &cells.back();
+}
+
+Closure ClosureCompiler::compile_node(TreeBase* tree) {
+    switch (tree->kind) {
+        case TreeKind::Unary:
+        case TreeKind::Comparison:
+        case TreeKind::Shift:
+        case TreeKind::Term:
+        case TreeKind::Factor:
+        case TreeKind::Bitwise:
+            if (jit) {
+                if (Closure native = compile_native(tree))
+                    return native;
+            }
+            break;
+        default: {}
+    }
+    switch (tree->kind) {
+        case TreeKind::Program:
+            return compile_program(static_cast<Program*>(tree));
+        case TreeKind::Block:
+            return compile_block(static_cast<Block*>(tree));
+        case TreeKind::VariableDeclaration:
+            return compile_variable_declaration(static_cast<VariableDeclaration*>(tree));
+        case TreeKind::Assignment:
+            return compile_assignment(static_cast<Assignment*>(tree));
+        case TreeKind::Print:
+            return compile_print(static_cast<Print*>(tree));
+        case TreeKind::Return:
+            return compile_node(static_cast<Return*>(tree)->expr);
+        case TreeKind::GroupedExpression:
+            return compile_node(static_cast<GroupedExpression*>(tree)->grouped_expr);
+        case TreeKind::Literal: {
+            const Value literal =
+                Value::unbox(static_cast<Literal*>(tree)->value_object);
+            return [literal](Value& value) {
+                value = literal;
+                return true;
+            };
+        }
+        case TreeKind::Name:
+            return compile_name(static_cast<Name*>(tree));
+        case TreeKind::Cast:
+            return compile_cast(static_cast<Cast*>(tree));
+        case TreeKind::Unary:
+            return compile_unary(static_cast<Unary*>(tree));
+        case TreeKind::Equality:
+            return compile_equality(static_cast<Equality*>(tree));
+        case TreeKind::Logical:
+            return compile_logical(static_cast<Logical*>(tree));
+        default: {}
+    }
+    return compile_binary(static_cast<Binary*>(tree));
+}
+
+Closure ClosureCompiler::compile_native(TreeBase* tree) {
+    JitCompiler::Function function =
+        jit->compile(tree, [this](const std::string& name) { return resolve(name); });
+    if (!function)
+        return nullptr;
+    // Native code gives up on overflow and big integers, these trees have
+    // no side effects so the closures can evaluate them again from scratch
+    JitCompiler* saved = jit;
+    jit = nullptr;
+    Closure fallback = compile_node(tree);
+    jit = saved;
+    const bool boolean = tree->kind == TreeKind::Comparison;
+    return [function, fallback = std::move(fallback), boolean](Value& value) {
+        i64 result;
+        if (!function(&result))
+            return fallback(value);
+        value = boolean ? Value::of_boolean(result) : Value::of_integer(result);
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_program(Program* tree) {
+    std::vector<Closure> statements;
+    std::vector<size_t> lines;
+    for (Statement* stmt : tree->statements) {
+        statements.push_back(compile_node(stmt));
+        lines.push_back(stmt->line);
+    }
+    return [this, statements = std::move(statements), lines = std::move(lines)](Value& value) {
+        Budget& budget = interpreter.budget();
+        // Value of the program is the value of its last statement
+        value = Value::of_object(nullptr);
+        for (size_t i = 0; i < statements.size(); i++) {
+            TRACE_STATEMENT(lines[i]);
+            if (!budget.step()) [[unlikely]]
+                return fail(budget.error());
+            if (!statements[i](value))
+                return false;
+        }
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_block(Block* tree) {
+    if (tree->statements.empty()) {
+        return [](Value& value) {
+            value = Value::of_object(nullptr);
+            return true;
+        };
+    }
+    if (tree->declares_variables)
+        scopes.emplace_back();
+    std::vector<Closure> statements;
+    bool returns = false;
+    for (Statement* stmt : tree->statements) {
+        statements.push_back(compile_node(stmt));
+        // Nothing after the first return ever runs
+        if (stmt->kind == TreeKind::Return) {
+            returns = true;
+            break;
+        }
+    }
+    if (tree->declares_variables)
+        scopes.pop_back();
+    return [this, statements = std::move(statements), returns](Value& value) {
+        Budget& budget = interpreter.budget();
+        for (const Closure& stmt : statements) {
+            if (!budget.step()) [[unlikely]]
+                return fail(budget.error());
+            if (!stmt(value))
+                return false;
+        }
+        if (!returns)
+            value = Value::of_object(ObjectVoid::VOID_OBJECT);
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_variable_declaration(VariableDeclaration* tree) {
+    struct Declaration {
+        std::string name;
+        Slot** cell;
+        bool global;
+        Closure initializer;
+    };
+    std::vector<Declaration> declarations;
+    Type* type = tree->target_type;
+    const bool global = scopes.size() == 1;
+    for (const auto& [name, initializer] : tree->pairs) {
+        if (global) {
+            cells.push_back(nullptr);
+        } else {
+            locals.emplace_back();
+            locals.back().type = type;
+            cells.push_back(&locals.back());
+        }
+        // Visible to its own initializer, like Interpreter does
+        scopes.back()[name] = &cells.back();
+        declarations.push_back(Declaration{
+            name,
+            &cells.back(),
+            global,
+            initializer ? compile_node(initializer) : nullptr
+        });
+    }
+    Environment& env = interpreter.environment();
+    return [this, &env, type, declarations = std::move(declarations)](Value& value) {
+        for (const Declaration& declaration : declarations) {
+            if (declaration.global) {
+                SlotResult slot = env.define(declaration.name, type);
+                if (slot.is_error())
+                    return fail(slot.unwrap_error());
+                *declaration.cell = slot.unwrap();
+            } else {
+                (*declaration.cell)->value = Environment::zero_value(type);
+            }
+            if (declaration.initializer) {
+                Value initial;
+                if (!declaration.initializer(initial))
+                    return false;
+                EnvironmentResult stored =
+                    Environment::store(declaration.name, *declaration.cell, initial);
+                if (stored.is_error())
+                    return fail(stored.unwrap_error());
+            }
+        }
+        value = Value::of_object(nullptr);
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_assignment(Assignment* tree) {
+    Slot** cell = resolve(tree->name.value);
+    Closure expr = compile_node(tree->expr);
+    std::string name = tree->name.value;
+    if (!cell) {
+        return [this, name](Value&) {
+            return fail(std::format("Name `{}` not defined!", name));
+        };
+    }
+    return [this, cell, expr = std::move(expr), name](Value& value) {
+        if (!expr(value))
+            return false;
+        EnvironmentResult stored = Environment::store(name, *cell, value);
+        if (stored.is_error())
+            return fail(stored.unwrap_error());
+        // Assignments produce no value
+        value = Value::of_object(nullptr);
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_print(Print* tree) {
+    Closure expr = tree->expr ? compile_node(tree->expr) : nullptr;
+    OutputSink& out = interpreter.output();
+    const bool interactive = interpreter.interactive();
+    return [expr = std::move(expr), &out, interactive](Value& value) {
+        if (expr) {
+            if (!expr(value))
+                return false;
+            value.box()->format_to(out);
+        }
+        if (interactive)
+            out.write('\n');
+        value = Value::of_object(nullptr);
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_name(Name* tree) {
+    Slot** cell = resolve(tree->name_str);
+    if (!cell) {
+        std::string name = tree->name_str;
+        return [this, name](Value&) {
+            return fail(std::format("Name `{}` not defined!", name));
+        };
+    }
+    return [cell](Value& value) {
+        value = (*cell)->value;
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_cast(Cast* tree) {
+    Closure operand = compile_node(tree->casted_expr);
+    const Type* target = tree->target_type;
+    return [this, operand = std::move(operand), target](Value& value) {
+        if (!operand(value))
+            return false;
+        CastResult cast = target->cast(value.box());
+        if (cast.is_error())
+            return fail(cast.unwrap_error());
+        value = Value::unbox(cast.unwrap());
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_unary(Unary* tree) {
+    Closure operand = compile_node(tree->expr);
+    if (tree->operands == Operands::Floats && tree->unary_op.ttype == TokenType::MINUS) {
+        return [operand = std::move(operand)](Value& value) {
+            if (!operand(value))
+                return false;
+            value = Value::of_float(-value.real);
+            return true;
+        };
+    }
+    return [this, tree, operand = std::move(operand)](Value& value) {
+        Value expr;
+        if (!operand(expr))
+            return false;
+        return unwrap(interpreter.apply_unary(tree, expr), value);
+    };
+}
+
+Closure ClosureCompiler::compile_binary(Binary* tree) {
+    Closure left = compile_node(tree->left);
+    Closure right = compile_node(tree->right);
+    if (tree->operands == Operands::Floats) {
+        Binary::Kernel kernel =
+            select_kernel(tree->op.ttype, ValueTag::FLOAT, ValueTag::FLOAT);
+        if (kernel) {
+            // Float values are never boxed, no guard needed
+            return [this, tree, left = std::move(left), right = std::move(right), kernel](Value& value) {
+                Value l, r;
+                if (!left(l) || !right(r))
+                    return false;
+                if (kernel(l, r, value))
+                    return true;
+                return unwrap(interpreter.apply_binary(tree, l, r), value);
+            };
+        }
+    } else if (tree->operands == Operands::Integers) {
+        Binary::Kernel kernel =
+            select_kernel(tree->op.ttype, ValueTag::INTEGER, ValueTag::INTEGER);
+        if (kernel) {
+            // Guarded, int values may be big integers
+            return [this, tree, left = std::move(left), right = std::move(right), kernel](Value& value) {
+                Value l, r;
+                if (!left(l) || !right(r))
+                    return false;
+                if (
+                    l.tag == ValueTag::INTEGER && r.tag == ValueTag::INTEGER &&
+                    kernel(l, r, value)
+                ) {
+                    return true;
+                }
+                return unwrap(interpreter.apply_binary(tree, l, r), value);
+            };
+        }
+    }
+    return [this, tree, left = std::move(left), right = std::move(right)](Value& value) {
+        Value l, r;
+        if (!left(l) || !right(r))
+            return false;
+        return unwrap(interpreter.apply_binary(tree, l, r), value);
+    };
+}
+
+Closure ClosureCompiler::compile_equality(Equality* tree) {
+    Closure left = compile_node(tree->left);
+    Closure right = compile_node(tree->right);
+    const bool negated = tree->op.ttype == TokenType::LOGICAL_NOT_EQUAL;
+    return [left = std::move(left), right = std::move(right), negated](Value& value) {
+        Value l, r;
+        if (!left(l) || !right(r))
+            return false;
+        value = Value::of_boolean(l.equals(r) != negated);
+        return true;
+    };
+}
+
+Closure ClosureCompiler::compile_logical(Logical* tree) {
+    Closure left = compile_node(tree->left);
+    Closure right = compile_node(tree->right);
+    switch (tree->op.ttype) {
+        case TokenType::KEYWORD_AND:
+            return [left = std::move(left), right = std::move(right)](Value& value) {
+                if (!left(value))
+                    return false;
+                if (value.to_boolean() && !right(value))
+                    return false;
+                value = Value::of_boolean(value.to_boolean());
+                return true;
+            };
+        case TokenType::KEYWORD_OR:
+            return [left = std::move(left), right = std::move(right)](Value& value) {
+                if (!left(value))
+                    return false;
+                if (!value.to_boolean() && !right(value))
+                    return false;
+                value = Value::of_boolean(value.to_boolean());
+                return true;
+            };
+        default: {}
+    }
+    return [left = std::move(left), right = std::move(right)](Value& value) {
+        Value l, r;
+        if (!left(l) || !right(r))
+            return false;
+        value = Value::of_boolean(l.to_boolean() != r.to_boolean());
+        return true;
+    };
+}
@@ -0,0 +1,61 @@
+#ifndef CLOSURE_COMPILER_H_INCLUDED
+#define CLOSURE_COMPILER_H_INCLUDED
+
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include "interpreter.hpp"
+#include "jit.hpp"
+
+// Second execution engine, compiles a type checked tree once into nested
+// closures with operator kernels, variable slots and literal values
+// already resolved, running it involves no visitor dispatch or Token
+// inspection
+// Globals, output and the slow operator paths are shared with interpreter
+class ClosureCompiler {
+public:
+    // false on a runtime error, see run()
+    using Closure = std::function<bool(Value& value)>;
+
+private:
+    Interpreter& interpreter;
+    std::string error_message{};
+    // Variables declared inside blocks, one slot per declaration
+    // No block ever runs twice so slots are never shared
+    std::deque<Slot> locals{};
+    // Where each variable lives, globals declared by the compiled
+    // program only get their slot once the declaration runs
+    std::deque<Slot*> cells{};
+    std::vector<std::unordered_map<std::string, Slot**>> scopes{};
+    // Native code for int expressions, none when nullptr
+    JitCompiler* jit = nullptr;
+
+    Slot** resolve(const std::string& name) noexcept;
+    bool fail(const std::string& msg) noexcept;
+    bool unwrap(const ValueResult& result, Value& value) noexcept;
+
+    Closure compile_node(TreeBase* tree);
+    Closure compile_native(TreeBase* tree);
+    Closure compile_program(Program* tree);
+    Closure compile_block(Block* tree);
+    Closure compile_variable_declaration(VariableDeclaration* tree);
+    Closure compile_assignment(Assignment* tree);
+    Closure compile_print(Print* tree);
+    Closure compile_name(Name* tree);
+    Closure compile_cast(Cast* tree);
+    Closure compile_unary(Unary* tree);
+    Closure compile_binary(Binary* tree);
+    Closure compile_equality(Equality* tree);
+    Closure compile_logical(Logical* tree);
+
+public:
+    ClosureCompiler(Interpreter& _interpreter): interpreter{_interpreter} {}
+
+    inline void use_jit(JitCompiler* _jit) noexcept { jit = _jit; }
+
+    // tree must have passed the TypeChecker
+    Closure compile(TreeBase* tree);
+    InterpreterResult run(const Closure& program);
+};
+
+#endif
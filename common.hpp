@@ -37,24 +37,6 @@ public:
     static bool is_keyword(const std::string& s) {
         return KEYWORDS.find(s) != KEYWORDS.end();
     }
-
-    static Mode* get_mode() {
-        static Mode* m = new Mode;
-        return m;
-    }
-
-    static std::string* get_filename() {
-        static std::string* filename = new std::string{};
-        return filename;
-    }
-
-    static bool is_mode_interactive() {
-        return *Common::get_mode() == Mode::Interactive;
-    }
-
-    static bool is_mode_file() {
-        return *Common::get_mode() == Mode::File;
-    }
 };
 
 using i8 = int8_t;
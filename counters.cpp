@@ -0,0 +1,96 @@
+#include "counters.hpp"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static perf_event_attr attributes(PerfCounters::Event event) noexcept {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // Last level and L1 data cache read misses
+    constexpr u64 READ_MISS =
+        PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    switch (event) {
+        case PerfCounters::CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfCounters::INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfCounters::BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PerfCounters::L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | READ_MISS;
+            break;
+        default:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | READ_MISS;
+    }
+    return attr;
+}
+
+PerfCounters::PerfCounters() {
+    for (u8 i = 0; i < EVENTS; i++) {
+        const Event event = static_cast<Event>(i);
+        perf_event_attr attr = attributes(event);
+        const int leader = opened.empty() ? -1 : fds[opened.front()];
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            error_message += std::format(
+                "{}{}: {}", error_message.empty() ? "" : ", ", NAMES[i], strerror(errno)
+            );
+            continue;
+        }
+        fds[i] = fd;
+        opened.push_back(event);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+PerfCounters::Reading PerfCounters::read() const noexcept {
+    Reading reading{};
+    if (opened.empty())
+        return reading;
+    // nr, time enabled, time running, then a value per event
+    u64 data[3 + EVENTS];
+    if (::read(fds[opened.front()], data, sizeof(data)) < 0)
+        return reading;
+    const u64 enabled = data[1], running = data[2];
+    for (size_t i = 0; i < data[0] && i < opened.size(); i++) {
+        u64 value = data[3 + i];
+        if (running && running < enabled)
+            value = static_cast<u64>(static_cast<double>(value) * enabled / running);
+        reading[opened[i]] = value;
+    }
+    return reading;
+}
+
+#else
+
+PerfCounters::PerfCounters(): error_message{"not supported on this platform"} {}
+
+PerfCounters::~PerfCounters() {}
+
+PerfCounters::Reading PerfCounters::read() const noexcept {
+    return Reading{};
+}
+
+#endif
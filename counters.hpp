@@ -0,0 +1,60 @@
+#ifndef COUNTERS_H_INCLUDED
+#define COUNTERS_H_INCLUDED
+
+#include <array>
+#include "common.hpp"
+
+// Hardware performance counters of this process through perf_event_open,
+// for --counters and the benchmark harness
+// Events the kernel or the machine refuses are left out, possibly all of
+// them (perf_event_paranoid, containers, virtual machines without a
+// PMU), error() says why; other platforms never have any
+class PerfCounters {
+public:
+    enum Event : u8 {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_MISSES,
+        LLC_MISSES,
+        EVENTS,
+    };
+
+    static constexpr const char* NAMES[EVENTS] = {
+        "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses",
+    };
+
+    // Counts since the counters were opened, user space only, scaled up
+    // when the kernel had to multiplex them
+    using Reading = std::array<u64, EVENTS>;
+
+private:
+    // In the order they joined the group, its leader first
+    std::vector<Event> opened{};
+    int fds[EVENTS] = {-1, -1, -1, -1, -1};
+    std::string error_message{};
+
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete; // No copy constructor
+    PerfCounters& operator=(const PerfCounters&) = delete; // No copy assignment
+
+    inline bool available() const noexcept { return !opened.empty(); }
+    inline bool has(Event event) const noexcept { return fds[event] >= 0; }
+    // Why some or all events are missing, empty when none is
+    inline const std::string& error() const noexcept { return error_message; }
+
+    // All zeros when unavailable
+    Reading read() const noexcept;
+
+    static inline Reading difference(const Reading& end, const Reading& start) noexcept {
+        Reading result{};
+        for (size_t i = 0; i < EVENTS; i++)
+            result[i] = end[i] - start[i];
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,434 @@
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <spawn.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cpp_emitter.hpp"
+
+// Expression yielding the type object in generated code
+static const char* type_object(const Type* type) noexcept {
+    switch (type->kind) {
+        case TypeKind::VOID:
+            return "TypeVoid::get_type_object()";
+        case TypeKind::BOOLEAN:
+            return "TypeBoolean::get_type_object()";
+        case TypeKind::INTEGER:
+            return "TypeInteger::get_type_object()";
+        case TypeKind::FLOAT:
+            return "TypeFloat::get_type_object()";
+        case TypeKind::STRING:
+            return "TypeString::get_type_object()";
+        default: {}
+    }
+    return "Type::get_type_object()";
+}
+
+// Bytes of s as a C++ string literal
+static std::string quote(const std::string& s) {
+    std::string quoted{"\""};
+    for (const unsigned char c : s) {
+        if (c == '"' || c == '\\' || c == '?' || c < ' ' || c > '~')
+            quoted += std::format("\\{:03o}", c);
+        else
+            quoted += static_cast<char>(c);
+    }
+    return quoted + '"';
+}
+
+static std::string token(const Token& op) {
+    return std::format(
+        "Token{{static_cast<TokenType>({}), {}, 0, 0}}",
+        static_cast<int>(op.ttype), quote(op.value)
+    );
+}
+
+void CppEmitter::line(const std::string& text) {
+    body.append(4 * depth, ' ');
+    body += text;
+    body += '\n';
+}
+
+std::string CppEmitter::temporary() {
+    return std::format("t{}", temporaries_count++);
+}
+
+std::string CppEmitter::lookup(const std::string& name) const noexcept {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); scope++) {
+        auto entry = scope->find(name);
+        if (entry != scope->end())
+            return entry->second;
+    }
+    return "";
+}
+
+std::string CppEmitter::site(Binary* tree) {
+    const char* node_class;
+    switch (tree->kind) {
+        case TreeKind::Term: node_class = "Term"; break;
+        case TreeKind::Factor: node_class = "Factor"; break;
+        case TreeKind::Comparison: node_class = "Comparison"; break;
+        case TreeKind::Shift: node_class = "Shift"; break;
+        case TreeKind::Bitwise: node_class = "Bitwise"; break;
+        default: node_class = "Exponential";
+    }
+    std::string name = std::format("s{}", sites_count++);
+    sites += std::format(
+        "static {} {}{{nullptr, {}, nullptr}};\n", node_class, name, token(tree->op)
+    );
+    return name;
+}
+
+std::string CppEmitter::site(Unary* tree) {
+    std::string name = std::format("s{}", sites_count++);
+    sites += std::format("static Unary {}{{{}, nullptr}};\n", name, token(tree->unary_op));
+    return name;
+}
+
+std::string CppEmitter::emit(TreeBase* tree) {
+    sites.clear();
+    body.clear();
+    temporaries_count = variables_count = sites_count = 0;
+    depth = 1;
+    scopes.clear();
+    scopes.emplace_back();
+    if (tree->kind == TreeKind::Program) {
+        for (Statement* stmt : static_cast<Program*>(tree)->statements)
+            statement(stmt);
+    } else {
+        statement(tree);
+    }
+    return std::format(
+        "// Generated by --emit-cpp, build against libruntime.a\n"
+        "#include \"aot_runtime.hpp\"\n"
+        "\n"
+        "{}\n"
+        "int main() {{\n"
+        "    std::ios::sync_with_stdio(false);\n"
+        "{}"
+        "    return AotRuntime::finish();\n"
+        "}}\n",
+        sites, body
+    );
+}
+
+BuildResult CppEmitter::build(
+    const std::string& source, const std::string& executable
+) noexcept {
+    char path[PATH_MAX];
+    const ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length < 0)
+        return BuildResult::Error("Can not locate the runtime library");
+    std::string runtime{path, static_cast<size_t>(length)};
+    runtime.erase(runtime.find_last_of('/'));
+    // CXX may carry flags, split on spaces like make does
+    std::vector<std::string> arguments;
+    std::istringstream compiler{std::getenv("CXX") ? std::getenv("CXX") : "g++"};
+    for (std::string word; compiler >> word;)
+        arguments.push_back(word);
+    if (arguments.empty())
+        arguments.push_back("g++");
+    arguments.insert(arguments.end(), {
+        "-std=c++23", "-O2", "-Wno-psabi", "-I" + runtime, source,
+        runtime + "/libruntime.a", "-lm", "-o", executable
+    });
+    std::string command;
+    std::vector<char*> argv;
+    for (std::string& argument : arguments) {
+        command += (command.empty() ? "" : " ") + argument;
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+    // No shell in between, paths are passed as they are
+    pid_t pid;
+    if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+        return BuildResult::Error(std::format("Can not run `{}`", argv[0]));
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return BuildResult::Error(std::format("`{}` failed", command));
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return BuildResult::Error(std::format("`{}` failed", command));
+    return BuildResult::Ok(true);
+}
+
+// ------------------------- Statements -------------------------
+
+void CppEmitter::statement(TreeBase* tree) {
+    switch (tree->kind) {
+        case TreeKind::VariableDeclaration:
+            variable_declaration(static_cast<VariableDeclaration*>(tree));
+            return;
+        case TreeKind::Assignment: {
+            Assignment* assignment = static_cast<Assignment*>(tree);
+            const std::string& name = assignment->name.value;
+            std::string value = expression(assignment->expr);
+            line(std::format(
+                "AotRuntime::store({}, {}, {});", quote(name), lookup(name), value
+            ));
+            return;
+        }
+        case TreeKind::Print: {
+            Print* print = static_cast<Print*>(tree);
+            // Without a value print only ends lines in interactive mode
+            if (print->expr)
+                line(std::format("AotRuntime::print({});", expression(print->expr)));
+            return;
+        }
+        case TreeKind::Return:
+            // Outside blocks a return is evaluated and nothing else
+            expression(static_cast<Return*>(tree)->expr);
+            return;
+        default: {}
+    }
+    expression(tree);
+}
+
+void CppEmitter::variable_declaration(VariableDeclaration* tree) {
+    const char* type = type_object(tree->target_type);
+    for (const auto& [name, initializer] : tree->pairs) {
+        std::string variable = std::format("v{}", variables_count++);
+        line(std::format(
+            "Slot {}{{{}, Environment::zero_value({})}};", variable, type, type
+        ));
+        scopes.back()[name] = variable;
+        if (initializer) {
+            std::string value = expression(initializer);
+            line(std::format("AotRuntime::store({}, {}, {});", quote(name), variable, value));
+        }
+    }
+}
+
+// ------------------------- Expressions -------------------------
+
+std::string CppEmitter::expression(TreeBase* tree) {
+    switch (tree->kind) {
+        case TreeKind::Literal:
+            return literal(static_cast<Literal*>(tree));
+        case TreeKind::Name: {
+            std::string value = temporary();
+            line(std::format(
+                "Value {} = {}.value;", value, lookup(static_cast<Name*>(tree)->name_str)
+            ));
+            return value;
+        }
+        case TreeKind::GroupedExpression:
+            return expression(static_cast<GroupedExpression*>(tree)->grouped_expr);
+        case TreeKind::Cast: {
+            Cast* cast = static_cast<Cast*>(tree);
+            std::string operand = expression(cast->casted_expr);
+            std::string value = temporary();
+            line(std::format(
+                "Value {} = AotRuntime::cast({}, {});",
+                value, type_object(cast->target_type), operand
+            ));
+            return value;
+        }
+        case TreeKind::Block:
+            return block(static_cast<Block*>(tree));
+        case TreeKind::Unary:
+            return unary(static_cast<Unary*>(tree));
+        case TreeKind::Equality: {
+            Equality* equality = static_cast<Equality*>(tree);
+            std::string left = expression(equality->left);
+            std::string right = expression(equality->right);
+            std::string value = temporary();
+            line(std::format(
+                "Value {} = Value::of_boolean({}{}.equals({}));", value,
+                equality->op.ttype == TokenType::LOGICAL_NOT_EQUAL ? "!" : "",
+                left, right
+            ));
+            return value;
+        }
+        case TreeKind::Logical:
+            return logical(static_cast<Logical*>(tree));
+        default: {}
+    }
+    return binary(static_cast<Binary*>(tree));
+}
+
+std::string CppEmitter::literal(Literal* tree) {
+    Object* obj = tree->value_object;
+    std::string initializer;
+    if (ObjectInteger* int_obj = exact_cast<ObjectInteger>(obj)) {
+        initializer = std::format("Value::of_integer({})", int_obj->value);
+    } else if (ObjectFloat* float_obj = exact_cast<ObjectFloat>(obj)) {
+        // Hexadecimal keeps every bit of the long double
+        char digits[64];
+        std::snprintf(digits, sizeof(digits), "%La", float_obj->value);
+        initializer = std::format("Value::of_float({}L)", digits);
+    } else if (ObjectBoolean* bool_obj = exact_cast<ObjectBoolean>(obj)) {
+        initializer = std::format("Value::of_boolean({})", bool_obj->value);
+    } else if (ObjectString* string_obj = exact_cast<ObjectString>(obj)) {
+        initializer = std::format(
+            "AotRuntime::string({}, {})",
+            quote(*string_obj), string_obj->size()
+        );
+    } else if (exact_cast<ObjectBigInteger>(obj)) {
+        initializer = std::format("AotRuntime::big_integer({})", quote(obj->to_string()));
+    } else {
+        initializer = "Value::of_object(ObjectVoid::VOID_OBJECT)";
+    }
+    std::string value = temporary();
+    line(std::format("Value {} = {};", value, initializer));
+    return value;
+}
+
+std::string CppEmitter::block(Block* tree) {
+    std::string value = temporary();
+    if (tree->statements.empty()) {
+        line(std::format("Value {} = Value::of_object(nullptr);", value));
+        return value;
+    }
+    line(std::format("Value {} = [&]() -> Value {{", value));
+    depth++;
+    if (tree->declares_variables)
+        scopes.emplace_back();
+    bool returns = false;
+    for (Statement* stmt : tree->statements) {
+        if (stmt->kind == TreeKind::Return) {
+            line(std::format("return {};", expression(static_cast<Return*>(stmt)->expr)));
+            returns = true;
+            break;
+        }
+        statement(stmt);
+    }
+    if (!returns)
+        line("return Value::of_object(ObjectVoid::VOID_OBJECT);");
+    if (tree->declares_variables)
+        scopes.pop_back();
+    depth--;
+    line("}();");
+    return value;
+}
+
+std::string CppEmitter::unary(Unary* tree) {
+    std::string operand = expression(tree->expr);
+    std::string value = temporary();
+    const TokenType op = tree->unary_op.ttype;
+    if (tree->operands == Operands::Floats && op == TokenType::MINUS) {
+        line(std::format("Value {} = Value::of_float(-{}.real);", value, operand));
+    } else if (tree->operands == Operands::Floats && op == TokenType::PLUS) {
+        line(std::format("Value {} = {};", value, operand));
+    } else if (tree->operands == Operands::Integers && op == TokenType::MINUS) {
+        line(std::format(
+            "Value {} = {}.tag == ValueTag::INTEGER && {}.integer != INT64_MIN ? "
+            "Value::of_integer(-{}.integer) : AotRuntime::unary(&{}, {});",
+            value, operand, operand, operand, site(tree), operand
+        ));
+    } else if (tree->operands == Operands::Integers && op == TokenType::TILDE) {
+        line(std::format(
+            "Value {} = {}.tag == ValueTag::INTEGER ? "
+            "Value::of_integer(~{}.integer) : AotRuntime::unary(&{}, {});",
+            value, operand, operand, site(tree), operand
+        ));
+    } else {
+        line(std::format("Value {} = AotRuntime::unary(&{}, {});", value, site(tree), operand));
+    }
+    return value;
+}
+
+std::string CppEmitter::binary(Binary* tree) {
+    std::string left = expression(tree->left);
+    std::string right = expression(tree->right);
+    std::string value = temporary();
+    auto slow = [&] {
+        return std::format("AotRuntime::binary(&{}, {}, {})", site(tree), left, right);
+    };
+    std::string op;
+    switch (tree->op.ttype) {
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+        case TokenType::STAR:
+        case TokenType::SLASH:
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL:
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+        case TokenType::BITWISE_AND:
+        case TokenType::BITWISE_OR:
+        case TokenType::BITWISE_XOR:
+            op = tree->op.value;
+            break;
+        default: {}
+    }
+    const bool compares = tree->kind == TreeKind::Comparison;
+    const bool bitwise = tree->kind == TreeKind::Bitwise;
+    if (tree->operands == Operands::Floats && !op.empty() && !bitwise) {
+        if (compares) {
+            line(std::format(
+                "Value {} = Value::of_boolean({}.real {} {}.real);", value, left, op, right
+            ));
+        } else if (tree->op.ttype == TokenType::SLASH) {
+            line(std::format(
+                "Value {} = {}.real != 0 ? Value::of_float({}.real / {}.real) : {};",
+                value, right, left, right, slow()
+            ));
+        } else {
+            line(std::format(
+                "Value {} = Value::of_float({}.real {} {}.real);", value, left, op, right
+            ));
+        }
+        return value;
+    }
+    if (tree->operands != Operands::Integers || op.empty() || op == "/") {
+        line(std::format("Value {} = {};", value, slow()));
+        return value;
+    }
+    // int operands may still be big integers, guard the tags
+    const std::string integers = std::format(
+        "{}.tag == ValueTag::INTEGER && {}.tag == ValueTag::INTEGER", left, right
+    );
+    const char* builtin = nullptr;
+    switch (tree->op.ttype) {
+        case TokenType::PLUS: builtin = "__builtin_add_overflow"; break;
+        case TokenType::MINUS: builtin = "__builtin_sub_overflow"; break;
+        case TokenType::STAR: builtin = "__builtin_mul_overflow"; break;
+        default: {}
+    }
+    if (builtin) {
+        line(std::format("Value {};", value));
+        line(std::format(
+            "if ({} && !{}({}.integer, {}.integer, &{}.integer))",
+            integers, builtin, left, right, value
+        ));
+        line(std::format("    {}.tag = ValueTag::INTEGER;", value));
+        line("else");
+        line(std::format("    {} = {};", value, slow()));
+    } else {
+        line(std::format(
+            "Value {} = {} ? Value::of_{}({}.integer {} {}.integer) : {};",
+            value, integers, compares ? "boolean" : "integer", left, op, right, slow()
+        ));
+    }
+    return value;
+}
+
+std::string CppEmitter::logical(Logical* tree) {
+    std::string left = expression(tree->left);
+    std::string value = temporary();
+    if (tree->op.ttype == TokenType::KEYWORD_XOR) {
+        std::string right = expression(tree->right);
+        line(std::format(
+            "Value {} = Value::of_boolean({}.to_boolean() != {}.to_boolean());",
+            value, left, right
+        ));
+        return value;
+    }
+    line(std::format("Value {} = {};", value, left));
+    // Right operand only runs when it decides the result
+    line(std::format(
+        "if ({}{}.to_boolean()) {{",
+        tree->op.ttype == TokenType::KEYWORD_AND ? "" : "!", value
+    ));
+    depth++;
+    std::string right = expression(tree->right);
+    line(std::format("{} = {};", value, right));
+    depth--;
+    line("}");
+    line(std::format("{} = Value::of_boolean({}.to_boolean());", value, value));
+    return value;
+}
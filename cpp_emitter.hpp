@@ -0,0 +1,53 @@
+#ifndef CPP_EMITTER_H_INCLUDED
+#define CPP_EMITTER_H_INCLUDED
+
+#include <unordered_map>
+#include "result.hpp"
+#include "syntax_tree.hpp"
+
+using BuildResult = Result<bool/*value type*/, std::string/*error type*/>;
+
+// Ahead of time compilation, lowers a type checked program to one C++
+// translation unit built against libruntime.a (see AotRuntime)
+// Values stay unboxed, operators with proven int or float operands are
+// emitted inline, blocks become immediately invoked lambdas
+class CppEmitter {
+    // Operator nodes the runtime's slow paths get, at file scope
+    std::string sites{};
+    std::string body{};
+    size_t temporaries_count = 0;
+    size_t variables_count = 0;
+    size_t sites_count = 0;
+    size_t depth = 1;
+    // C++ variable of every visible name
+    std::vector<std::unordered_map<std::string, std::string>> scopes{};
+
+    void line(const std::string& text);
+    std::string temporary();
+    std::string lookup(const std::string& name) const noexcept;
+    std::string site(Binary* tree);
+    std::string site(Unary* tree);
+
+    void statement(TreeBase* tree);
+    void variable_declaration(VariableDeclaration* tree);
+    // Each returns the temporary holding the value
+    std::string expression(TreeBase* tree);
+    std::string literal(Literal* tree);
+    std::string block(Block* tree);
+    std::string unary(Unary* tree);
+    std::string binary(Binary* tree);
+    std::string logical(Logical* tree);
+
+public:
+    // tree must have passed the TypeChecker
+    std::string emit(TreeBase* tree);
+
+    // Compiles an emitted source with $CXX when set, g++ otherwise
+    // Runtime headers and libruntime.a are looked up next to the running
+    // executable
+    static BuildResult build(
+        const std::string& source, const std::string& executable
+    ) noexcept;
+};
+
+#endif
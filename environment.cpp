@@ -2,42 +2,130 @@
 
 Environment::Environment() {
     // Globals
+    MemoryStats::allocated(MemoryStats::ENVIRONMENT_TABLE, sizeof(Table));
     scopes.push_back(new Table{});
+    stats.tables_allocated++;
 }
 
-EnvironmentResult Environment::define(const std::string& s) noexcept {
+void Environment::report_statistics(std::ostream& os) const noexcept {
+    os << std::format(
+        "scopes entered: {}\n"
+        "scopes elided: {}\n"
+        "scope tables allocated: {}\n"
+        "scope tables reused: {}\n"
+        "peak scope depth: {}\n",
+        stats.scopes_entered,
+        stats.scopes_elided,
+        stats.tables_allocated,
+        stats.tables_reused,
+        stats.peak_depth
+    );
+}
+
+Value Environment::zero_value(const Type* type) noexcept {
+    switch (type->kind) {
+        case TypeKind::INTEGER:
+            return Value::of_integer(0);
+        case TypeKind::FLOAT:
+            return Value::of_float(0.0);
+        case TypeKind::BOOLEAN:
+            return Value::of_boolean(false);
+        case TypeKind::STRING:
+            return Value::of_object(new ObjectString{});
+        case TypeKind::TYPE:
+            return Value::of_object(TypeVoid::get_type_object());
+        default: {}
+    }
+    return Value::of_object(ObjectVoid::VOID_OBJECT);
+}
+
+SlotResult Environment::define(const std::string& s, Type* type) noexcept {
     if (resolved_names.contains(s)) {
-        return EnvironmentResult::Error(
+        return SlotResult::Error(
             std::format("Name `{}` already defined!", s)
         );
     }
     resolved_names[s] = scopes.size()-1;
-    (*get_current_scope())[s] = nullptr;
-    return EnvironmentResult::Ok(nullptr);
+    MemoryStats::allocated(MemoryStats::ENVIRONMENT_SLOT, SLOT_BYTES);
+    Slot& slot = (*get_current_scope())[s];
+    slot.type = type;
+    slot.value = zero_value(type);
+    return SlotResult::Ok(&slot);
 }
 
-EnvironmentResult Environment::set(const std::string& s, Object* value) noexcept {
+SlotResult Environment::lookup(const std::string& s) noexcept {
     auto name_depth_ptr =
         resolved_names.find(s);
     if (name_depth_ptr == resolved_names.end()) {
-        return EnvironmentResult::Error(
+        return SlotResult::Error(
             std::format("Name `{}` not defined!", s)
         );
     }
-    Table* name_scope = scopes.at(name_depth_ptr->second);
-    (*name_scope)[s] = value;
-    return EnvironmentResult::Ok(nullptr);
+    return SlotResult::Ok(
+        &scopes[name_depth_ptr->second]->at(s)
+    );
 }
 
-EnvironmentResult Environment::get(const std::string& s) const noexcept {
+const Slot* Environment::find(const std::string& s) const noexcept {
     auto name_depth_ptr =
         resolved_names.find(s);
-    if (name_depth_ptr == resolved_names.end()) {
-        return EnvironmentResult::Error(
-            std::format("Name `{}` not defined!", s)
-        );
+    if (name_depth_ptr == resolved_names.end())
+        return nullptr;
+    return &scopes[name_depth_ptr->second]->at(s);
+}
+
+EnvironmentResult Environment::store(
+    const std::string& s, Slot* slot, Value value
+) noexcept {
+    const TypeKind kind = slot->type->kind;
+    switch (value.tag) {
+        case ValueTag::INTEGER:
+            if (kind == TypeKind::INTEGER) {
+                slot->value = value;
+                return EnvironmentResult::Ok(nullptr);
+            }
+            if (kind == TypeKind::FLOAT) {
+                slot->value = Value::of_float(value.as_float64());
+                return EnvironmentResult::Ok(nullptr);
+            }
+            break;
+        case ValueTag::FLOAT:
+            if (kind == TypeKind::FLOAT) {
+                slot->value = value;
+                return EnvironmentResult::Ok(nullptr);
+            }
+            break;
+        case ValueTag::BOOLEAN:
+            if (kind == TypeKind::BOOLEAN) {
+                slot->value = value;
+                return EnvironmentResult::Ok(nullptr);
+            }
+            break;
+        case ValueTag::OBJECT: {
+            if (!value.object) {
+                return EnvironmentResult::Error(
+                    std::format("Assigning an expression without a value to `{}`", s)
+                );
+            }
+            const ObjectBigInteger* big =
+                dynamic_cast<const ObjectBigInteger*>(value.object);
+            if (big && kind == TypeKind::FLOAT) {
+                slot->value = Value::of_float(big->value.to_float64());
+                return EnvironmentResult::Ok(nullptr);
+            }
+            // Big integers stay boxed in int variables
+            if (value.object->type_info->kind == kind) {
+                slot->value = value;
+                return EnvironmentResult::Ok(nullptr);
+            }
+            break;
+        }
     }
-    return EnvironmentResult::Ok(
-        scopes.at(name_depth_ptr->second)->at(s)
+    const Object* boxed = value.box();
+    return EnvironmentResult::Error(
+        std::format(
+            "Can not assign value of type `{}` to `{}` variable `{}`",
+            boxed->type_info->type_name, slot->type->type_name, s
+        )
     );
 }
@@ -1,37 +1,95 @@
 #ifndef ENVIRONMENT_H_INCLUDED
 #define ENVIRONMENT_H_INCLUDED
 
+#include <algorithm>
 #include <unordered_map>
+#include "memory_stats.hpp"
 #include "object.hpp"
 #include "result.hpp"
+#include "typing.hpp"
+#include "value.hpp"
 
 using EnvironmentResult =
     PointerValueResult<Object*/*value type*/, std::string/*error type*/>;
 
+// Storage of a single variable, its value always matches the declared type
+// int, float and boolean variables hold their value unboxed
+struct Slot {
+    Type* type = nullptr;
+    Value value{};
+};
+
+using SlotResult =
+    PointerValueResult<Slot*/*value type*/, std::string/*error type*/>;
+
 class Environment {
 public:
     using depth = std::uint64_t;
-    using Table = std::unordered_map<std::string, Object*>;
+    // Slot addresses stay valid until their scope ends
+    using Table = std::unordered_map<std::string, Slot>;
     using Names = std::unordered_map<std::string, depth>;
+    // Map node of a slot, its name and the next pointer and hash beside
+    static constexpr u64 SLOT_BYTES = sizeof(Table::value_type) + 2 * sizeof(void*);
+
+    struct Statistics {
+        u64 scopes_entered = 0;
+        u64 scopes_elided = 0;
+        u64 tables_allocated = 0;
+        u64 tables_reused = 0;
+        u64 peak_depth = 1;
+    };
 
 private:
     std::vector<Table*> scopes{};
+    // Tables of exited scopes, emptied and ready for reuse
+    std::vector<Table*> free_tables{};
     Names resolved_names{};
 
 public:
+    Statistics stats{};
+
     Environment();
 
     inline Table* get_current_scope() const noexcept { return scopes.back(); }
     inline Table* globals() const noexcept { return scopes[0]; }
-    inline void begin_scope() noexcept { scopes.push_back(new Table{}); }
+    inline void begin_scope() noexcept {
+        stats.scopes_entered++;
+        if (free_tables.empty()) {
+            stats.tables_allocated++;
+            MemoryStats::allocated(MemoryStats::ENVIRONMENT_TABLE, sizeof(Table));
+            scopes.push_back(new Table{});
+        } else {
+            stats.tables_reused++;
+            scopes.push_back(free_tables.back());
+            free_tables.pop_back();
+        }
+        stats.peak_depth = std::max<u64>(stats.peak_depth, scopes.size());
+    }
     inline void end_scope() noexcept {
-        for (const auto& [key, _] : *scopes.back())
+        Table* scope = scopes.back();
+        for (const auto& [key, _] : *scope) {
             resolved_names.erase(key);
+            MemoryStats::freed(MemoryStats::ENVIRONMENT_SLOT, SLOT_BYTES);
+        }
+        // clear() keeps the bucket array, so the next scope
+        // using this table doesn't allocate one again
+        scope->clear();
+        free_tables.push_back(scope);
         scopes.pop_back();
     }
-    EnvironmentResult define(const std::string& s) noexcept;
-    EnvironmentResult set(const std::string& s, Object* value) noexcept;
-    EnvironmentResult get(const std::string& s) const noexcept;
+    void report_statistics(std::ostream& os) const noexcept;
+    // Initial value of variables declared without an initializer
+    static Value zero_value(const Type* type) noexcept;
+    // New slot holding the zero value of type
+    SlotResult define(const std::string& s, Type* type) noexcept;
+    SlotResult lookup(const std::string& s) noexcept;
+    // nullptr when s is not defined
+    const Slot* find(const std::string& s) const noexcept;
+    // Store value in slot if it fits the declared type, an int
+    // stored in a float variable is converted
+    static EnvironmentResult store(
+        const std::string& s, Slot* slot, Value value
+    ) noexcept;
 };
 
 #endif
@@ -3,10 +3,242 @@
 #include "common.hpp"
 #include "object.hpp"
 #include "token.hpp"
+#include "trace.hpp"
 #include "visitor.hpp"
 
+// ------------------------- Big integers -------------------------
+
+static bool as_big_integer(const Object* obj, BigInteger& out) noexcept {
+    const ObjectInteger* int_obj = dynamic_cast<const ObjectInteger*>(obj);
+    if (int_obj) {
+        out = BigInteger{int_obj->value};
+        return true;
+    }
+    const ObjectBigInteger* big_obj = dynamic_cast<const ObjectBigInteger*>(obj);
+    if (big_obj) {
+        out = big_obj->value;
+        return true;
+    }
+    return false;
+}
+
+static bool as_float64(const Object* obj, float64& out) noexcept {
+    const ObjectFloat* float_obj = dynamic_cast<const ObjectFloat*>(obj);
+    if (float_obj) {
+        out = float_obj->value;
+        return true;
+    }
+    BigInteger big;
+    if (!as_big_integer(obj, big))
+        return false;
+    out = big.to_float64();
+    return true;
+}
+
+// Slow path of binary operators once an operand is an ObjectBigInteger
+// Mixed with a float the integer side is converted, otherwise exact
+static InterpreterResult big_integer_binary(
+    const Token& op, const Object* left, const Object* right
+) {
+    BigInteger left_big, right_big;
+    float64 left_float, right_float;
+    const bool left_is_integer = as_big_integer(left, left_big);
+    const bool right_is_integer = as_big_integer(right, right_big);
+    if (!left_is_integer && !as_float64(left, left_float)) {
+        return InterpreterResult::Error(
+            "Left operand of operator " + op.value + " is not numeric"
+        );
+    }
+    if (!right_is_integer && !as_float64(right, right_float)) {
+        return InterpreterResult::Error(
+            "right operand of operator " + op.value + " is not numeric"
+        );
+    }
+    if (!left_is_integer || !right_is_integer) {
+        if (left_is_integer) left_float = left_big.to_float64();
+        if (right_is_integer) right_float = right_big.to_float64();
+        switch (op.ttype) {
+            case TokenType::PLUS:
+                return InterpreterResult::Ok(ObjectFloat::make(left_float + right_float));
+            case TokenType::MINUS:
+                return InterpreterResult::Ok(ObjectFloat::make(left_float - right_float));
+            case TokenType::STAR:
+                return InterpreterResult::Ok(ObjectFloat::make(left_float * right_float));
+            case TokenType::SLASH:
+                if (right_float == 0)
+                    return InterpreterResult::Error("Division by zero");
+                return InterpreterResult::Ok(ObjectFloat::make(left_float / right_float));
+            case TokenType::DOUBLE_SLASH: {
+                ObjectFloat dividend{left_float}, divisor{right_float};
+                Object* value = dividend.integer_div(&divisor);
+                if (!value)
+                    return InterpreterResult::Error("Division by zero");
+                return InterpreterResult::Ok(value);
+            }
+            case TokenType::EXPONENT:
+                return InterpreterResult::Ok(ObjectFloat::make(std::pow(left_float, right_float)));
+            case TokenType::GREATER:
+                return InterpreterResult::Ok(ObjectBoolean::as_object(left_float > right_float));
+            case TokenType::GREATER_EQUAL:
+                return InterpreterResult::Ok(ObjectBoolean::as_object(left_float >= right_float));
+            case TokenType::LESS:
+                return InterpreterResult::Ok(ObjectBoolean::as_object(left_float < right_float));
+            case TokenType::LESS_EQUAL:
+                return InterpreterResult::Ok(ObjectBoolean::as_object(left_float <= right_float));
+            case TokenType::PERCENT:
+                return InterpreterResult::Error(
+                    "Applying mod operator % with a non-integer operand"
+                );
+            case TokenType::LEFT_SHIFT:
+            case TokenType::RIGHT_SHIFT:
+                return InterpreterResult::Error("Can not shift a non-integer value");
+            case TokenType::BITWISE_AND:
+            case TokenType::BITWISE_OR:
+            case TokenType::BITWISE_XOR:
+                return InterpreterResult::Error(
+                    "Applying bitwise `" + op.value + "` to non-integer operands"
+                );
+            default: {}
+        }
+        return InterpreterResult::Error(
+            "Invalid binary operator " + op.value + " for numeric operands"
+        );
+    }
+    switch (op.ttype) {
+        case TokenType::PLUS:
+            return InterpreterResult::Ok(ObjectBigInteger::from(left_big + right_big));
+        case TokenType::MINUS:
+            return InterpreterResult::Ok(ObjectBigInteger::from(left_big - right_big));
+        case TokenType::STAR: {
+            // Same limit as shifts, the simplifier turns x * 2**k into x << k
+            if (left_big.bit_length() + right_big.bit_length() > BigInteger::MAX_BITS + 1)
+                return InterpreterResult::Error("Integer result too large");
+            BigInteger product = left_big * right_big;
+            if (product.bit_length() > BigInteger::MAX_BITS)
+                return InterpreterResult::Error("Integer result too large");
+            return InterpreterResult::Ok(ObjectBigInteger::from(std::move(product)));
+        }
+        case TokenType::SLASH:
+            if (right_big.is_zero())
+                return InterpreterResult::Error("Division by zero");
+            return InterpreterResult::Ok(
+                ObjectFloat::make(left_big.to_float64() / right_big.to_float64())
+            );
+        case TokenType::DOUBLE_SLASH:
+        case TokenType::PERCENT: {
+            if (right_big.is_zero()) {
+                return InterpreterResult::Error(
+                    op.ttype == TokenType::PERCENT ? "Zero modulus" : "Division by zero"
+                );
+            }
+            BigInteger quotient, remainder;
+            BigInteger::divmod(left_big, right_big, quotient, remainder);
+            return InterpreterResult::Ok(ObjectBigInteger::from(
+                std::move(op.ttype == TokenType::PERCENT ? remainder : quotient)
+            ));
+        }
+        case TokenType::EXPONENT: {
+            if (right_big.fits_i64()) {
+                ObjectInteger exponent{right_big.to_i64()};
+                if (left_big.fits_i64()) {
+                    Object* value = ObjectInteger{left_big.to_i64()}.power(&exponent);
+                    if (value) return InterpreterResult::Ok(value);
+                    if (left_big.is_zero())
+                        return InterpreterResult::Error("Zero raised to a negative power");
+                    return InterpreterResult::Error("Integer result too large");
+                }
+                // A big base has magnitude above one, negative powers truncate to zero
+                if (exponent.value < 0)
+                    return InterpreterResult::Ok(ObjectInteger::make(0));
+                if (static_cast<u64>(exponent.value) > BigInteger::MAX_BITS / left_big.bit_length())
+                    return InterpreterResult::Error("Integer result too large");
+                return InterpreterResult::Ok(
+                    ObjectBigInteger::from(left_big.pow(static_cast<u64>(exponent.value)))
+                );
+            }
+            // Huge exponent, only trivial bases stay representable
+            BigInteger one{1};
+            if (left_big.is_zero() && right_big.is_negative())
+                return InterpreterResult::Error("Zero raised to a negative power");
+            if (left_big.is_zero() || left_big == one)
+                return InterpreterResult::Ok(ObjectInteger::make(left_big.to_i64()));
+            if (left_big == -one) {
+                const bool odd = !(right_big & one).is_zero();
+                return InterpreterResult::Ok(ObjectInteger::make(odd ? -1 : 1));
+            }
+            if (right_big.is_negative())
+                return InterpreterResult::Ok(ObjectInteger::make(0));
+            return InterpreterResult::Error("Integer result too large");
+        }
+        case TokenType::GREATER:
+            return InterpreterResult::Ok(ObjectBoolean::as_object(left_big.compare(right_big) > 0));
+        case TokenType::GREATER_EQUAL:
+            return InterpreterResult::Ok(ObjectBoolean::as_object(left_big.compare(right_big) >= 0));
+        case TokenType::LESS:
+            return InterpreterResult::Ok(ObjectBoolean::as_object(left_big.compare(right_big) < 0));
+        case TokenType::LESS_EQUAL:
+            return InterpreterResult::Ok(ObjectBoolean::as_object(left_big.compare(right_big) <= 0));
+        case TokenType::LEFT_SHIFT:
+        case TokenType::RIGHT_SHIFT: {
+            if (right_big.is_negative())
+                return InterpreterResult::Error("Shift count is negative");
+            const bool left_shift = op.ttype == TokenType::LEFT_SHIFT;
+            if (left_big.is_zero())
+                return InterpreterResult::Ok(ObjectInteger::make(0));
+            if (!right_big.fits_i64()) {
+                if (left_shift)
+                    return InterpreterResult::Error("Shift count too large");
+                return InterpreterResult::Ok(ObjectInteger::make(left_big.is_negative() ? -1 : 0));
+            }
+            const u64 count = static_cast<u64>(right_big.to_i64());
+            if (!left_shift)
+                return InterpreterResult::Ok(ObjectBigInteger::from(left_big >> count));
+            if (count > BigInteger::MAX_BITS - left_big.bit_length())
+                return InterpreterResult::Error("Integer result too large");
+            return InterpreterResult::Ok(ObjectBigInteger::from(left_big << count));
+        }
+        case TokenType::BITWISE_AND:
+            return InterpreterResult::Ok(ObjectBigInteger::from(left_big & right_big));
+        case TokenType::BITWISE_OR:
+            return InterpreterResult::Ok(ObjectBigInteger::from(left_big | right_big));
+        case TokenType::BITWISE_XOR:
+            return InterpreterResult::Ok(ObjectBigInteger::from(left_big ^ right_big));
+        default: {}
+    }
+    return InterpreterResult::Error(
+        "Invalid binary operator " + op.value + " for numeric operands"
+    );
+}
+
+// ------------------------- Big integers -------------------------
+
+void Interpreter::report_statistics(std::ostream& os) const noexcept {
+    env.report_statistics(os);
+    os << std::format(
+        "nodes quickened: {}\n"
+        "nodes despecialized: {}\n",
+        stats.quickened,
+        stats.despecialized
+    );
+}
+
 InterpreterResult Interpreter::interpret(TreeBase* tree) {
-    return tree->accept(this);
+    return finish(evaluate(tree));
+}
+
+InterpreterResult Interpreter::finish(const InterpreterResult& result) noexcept {
+    if (result.is_error())
+        return fail(result.unwrap_error());
+    // Allocations since the last check may have gone over the limit
+    if (!run_budget.check_allocation())
+        return fail(run_budget.error());
+    return result;
+}
+
+InterpreterResult Interpreter::fail(const std::string& msg) noexcept {
+    // Whatever got printed before the error must precede its message
+    out.flush();
+    return InterpreterResult::Error(msg);
 }
 
 InterpreterResult Interpreter::visit_program(Program* tree) {
@@ -17,10 +249,12 @@ InterpreterResult Interpreter::visit_program(Program* tree) {
         stmt_ptr != tree->statements.end()-1;
         stmt_ptr++
     ) {
-        InterpreterResult r = (*stmt_ptr)->accept(this);
+        TRACE_STATEMENT((*stmt_ptr)->line);
+        InterpreterResult r = evaluate(*stmt_ptr);
         if (r.is_error()) return r;
     }
-    return tree->statements.back()->accept(this);
+    TRACE_STATEMENT(tree->statements.back()->line);
+    return evaluate(tree->statements.back());
 }
 
 InterpreterResult Interpreter::visit_literal(Literal* tree) {
@@ -28,14 +262,17 @@ InterpreterResult Interpreter::visit_literal(Literal* tree) {
 }
 
 InterpreterResult Interpreter::visit_grouped_expression(GroupedExpression* tree) {
-    return tree->grouped_expr->accept(this);
+    return evaluate(tree->grouped_expr);
 }
 
 InterpreterResult Interpreter::visit_unary(Unary* tree) {
-    InterpreterResult expr_result = tree->expr->accept(this);
-    if (expr_result.is_error())
-        return expr_result;
-    Object* expr = expr_result.unwrap();
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
+
+InterpreterResult Interpreter::unary_object(Unary* tree, Object* expr) {
     switch (tree->unary_op.ttype) {
         case TokenType::BANG: {
             ObjectBoolean* obj = dynamic_cast<ObjectBoolean*>(expr);
@@ -52,6 +289,10 @@ InterpreterResult Interpreter::visit_unary(Unary* tree) {
             if (float_obj)
                 return InterpreterResult::Ok(-(*float_obj));
 
+            ObjectBigInteger* big_obj = dynamic_cast<ObjectBigInteger*>(expr);
+            if (big_obj)
+                return InterpreterResult::Ok(ObjectBigInteger::from(-big_obj->value));
+
             return InterpreterResult::Error("Unary arithmetic operator - applied to non-numeric") ;
         }
         case TokenType::PLUS: {
@@ -63,13 +304,19 @@ InterpreterResult Interpreter::visit_unary(Unary* tree) {
             if (float_obj)
                 return InterpreterResult::Ok(float_obj);
 
+            if (dynamic_cast<ObjectBigInteger*>(expr))
+                return InterpreterResult::Ok(expr);
+
             return InterpreterResult::Error("Unary arithmetic operator + applied to non-numeric") ;
         }
         case TokenType::TILDE: {
             ObjectInteger* int_obj = dynamic_cast<ObjectInteger*>(expr);
-            if (!int_obj)
-                return InterpreterResult::Error("Unary bitwise operator ~ applied to non-integer") ;
-            return InterpreterResult::Ok(~(*int_obj));
+            if (int_obj)
+                return InterpreterResult::Ok(~(*int_obj));
+            ObjectBigInteger* big_obj = dynamic_cast<ObjectBigInteger*>(expr);
+            if (big_obj)
+                return InterpreterResult::Ok(ObjectBigInteger::from(~big_obj->value));
+            return InterpreterResult::Error("Unary bitwise operator ~ applied to non-integer") ;
         }
         default: {}
     }
@@ -79,71 +326,79 @@ InterpreterResult Interpreter::visit_unary(Unary* tree) {
 }
 
 InterpreterResult Interpreter::visit_exponential(Exponential* tree) {
-    InterpreterResult base_result = tree->left->accept(this);
-    if (base_result.is_error())
-        return base_result;
-    Object* base = base_result.unwrap();
-
-    InterpreterResult exponent_result = tree->right->accept(this);
-    if (exponent_result.is_error())
-        return exponent_result;
-    Object* exponent = exponent_result.unwrap();
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
 
+InterpreterResult Interpreter::exponential_objects(Exponential* tree, Object* base, Object* exponent) {
     ObjectInteger *int_base, *int_exponent;
-    ObjectFloat *float_base, *float_exponent;
+    ObjectFloat *float_base = nullptr, *float_exponent = nullptr;
 
     int_base = dynamic_cast<ObjectInteger*>(base);
     if (int_base) goto FIND_EXPONENT;
     float_base = dynamic_cast<ObjectFloat*>(base);
-    if (!float_base)
+    if (!float_base) {
+        if (dynamic_cast<ObjectBigInteger*>(base))
+            goto BIG_INTEGER;
         return InterpreterResult::Error("Numeric operator ** used with non-numeric base");
+    }
 FIND_EXPONENT:
     int_exponent = dynamic_cast<ObjectInteger*>(exponent);
     if (int_exponent) goto EVALUATE;
     float_exponent = dynamic_cast<ObjectFloat*>(exponent);
-    if (!float_exponent)
+    if (!float_exponent) {
+        if (dynamic_cast<ObjectBigInteger*>(exponent))
+            goto BIG_INTEGER;
         return InterpreterResult::Error("Numeric operator ** used with non-numeric exponent");
+    }
 EVALUATE:
     Object* value;
     if (int_base && int_exponent) {
-        value = new ObjectInteger{
-            static_cast<i64>(std::powl(int_base->value, int_exponent->value))
-        };
+        // Exact, promotes to a big integer when needed
+        value = int_base->power(int_exponent);
+        if (!value) {
+            if (int_base->value == 0)
+                return InterpreterResult::Error("Zero raised to a negative power");
+            return InterpreterResult::Error("Integer result too large");
+        }
     } else if (int_base && float_exponent) {
-        value = new ObjectFloat{
+        value = ObjectFloat::make(
             static_cast<float64>(std::pow(int_base->value, float_exponent->value))
-        };
+        );
     } else if (float_base && int_exponent) {
-        value = new ObjectFloat{
+        value = ObjectFloat::make(
             static_cast<float64>(std::pow(float_base->value, int_exponent->value))
-        };
+        );
     } else {
         // float base && float_exponent
-        value = new ObjectFloat{
+        value = ObjectFloat::make(
             static_cast<float64>(std::pow(float_base->value, float_exponent->value))
-        };
+        );
     }
     return InterpreterResult::Ok(value);
+BIG_INTEGER:
+    return big_integer_binary(tree->op, base, exponent);
 }
 
 InterpreterResult Interpreter::visit_factor(Factor* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
-    if (left_result.is_error())
-        return left_result;
-    Object* left = left_result.unwrap();
-
-    InterpreterResult right_result = tree->right->accept(this);
-    if (right_result.is_error())
-        return right_result;
-    Object* right = right_result.unwrap();
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
 
+InterpreterResult Interpreter::factor_objects(Factor* tree, Object* left, Object* right) {
     ObjectInteger *left_int, *right_int;
-    ObjectFloat *left_float, *right_float;
+    ObjectFloat *left_float = nullptr, *right_float = nullptr;
 
     left_int = dynamic_cast<ObjectInteger*>(left);
     if (left_int) goto FIND_RIGHT;
     left_float = dynamic_cast<ObjectFloat*>(left);
     if (!left_float) {
+        if (dynamic_cast<ObjectBigInteger*>(left))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "Left operand of operator " +
             tree->op.value +
@@ -155,6 +410,8 @@ FIND_RIGHT:
     if (right_int) goto EVALUATE;
     right_float = dynamic_cast<ObjectFloat*>(right);
     if (!right_float) {
+        if (dynamic_cast<ObjectBigInteger*>(right))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "right operand of operator " +
             tree->op.value +
@@ -197,6 +454,8 @@ EVALUATE:
                 value = left_float->integer_div(right_int);
             else
                 value = left_float->integer_div(right_float);
+            if (!value)
+                return InterpreterResult::Error("Division by zero");
             break;
         }
         case TokenType::PERCENT: {
@@ -219,16 +478,13 @@ EVALUATE:
 }
 
 InterpreterResult Interpreter::visit_term(Term* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
-    if (left_result.is_error())
-        return left_result;
-    Object* left = left_result.unwrap();
-
-    InterpreterResult right_result = tree->right->accept(this);
-    if (right_result.is_error())
-        return right_result;
-    Object* right = right_result.unwrap();
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
 
+InterpreterResult Interpreter::term_objects(Term* tree, Object* left, Object* right) {
     ObjectString* left_str = dynamic_cast<ObjectString*>(left);
     if (left_str) {
         return InterpreterResult::Ok(
@@ -243,12 +499,14 @@ InterpreterResult Interpreter::visit_term(Term* tree) {
     }
 
     ObjectInteger *left_int, *right_int;
-    ObjectFloat *left_float, *right_float;
+    ObjectFloat *left_float = nullptr, *right_float = nullptr;
 
     left_int = dynamic_cast<ObjectInteger*>(left);
     if (left_int) goto FIND_RIGHT;
     left_float = dynamic_cast<ObjectFloat*>(left);
     if (!left_float) {
+        if (dynamic_cast<ObjectBigInteger*>(left))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "Left operand of operator " +
             tree->op.value +
@@ -260,6 +518,8 @@ FIND_RIGHT:
     if (right_int) goto EVALUATE;
     right_float = dynamic_cast<ObjectFloat*>(right);
     if (!right_float) {
+        if (dynamic_cast<ObjectBigInteger*>(right))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "right operand of operator " +
             tree->op.value +
@@ -300,23 +560,22 @@ EVALUATE:
 }
 
 InterpreterResult Interpreter::visit_comparison(Comparison* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
-    if (left_result.is_error())
-        return left_result;
-    Object* left = left_result.unwrap();
-
-    InterpreterResult right_result = tree->right->accept(this);
-    if (right_result.is_error())
-        return right_result;
-    Object* right = right_result.unwrap();
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
 
+InterpreterResult Interpreter::compare_objects(Comparison* tree, Object* left, Object* right) {
     ObjectInteger *left_int, *right_int;
-    ObjectFloat *left_float, *right_float;
+    ObjectFloat *left_float = nullptr, *right_float = nullptr;
 
     left_int = dynamic_cast<ObjectInteger*>(left);
     if (left_int) goto FIND_RIGHT;
     left_float = dynamic_cast<ObjectFloat*>(left);
     if (!left_float) {
+        if (dynamic_cast<ObjectBigInteger*>(left))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "Left operand of operator " +
             tree->op.value +
@@ -328,6 +587,8 @@ FIND_RIGHT:
     if (right_int) goto EVALUATE;
     right_float = dynamic_cast<ObjectFloat*>(right);
     if (!right_float) {
+        if (dynamic_cast<ObjectBigInteger*>(right))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "right operand of operator " +
             tree->op.value +
@@ -390,24 +651,25 @@ EVALUATE:
 }
 
 InterpreterResult Interpreter::visit_shift(Shift* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
-    if (left_result.is_error())
-        return left_result;
-    Object* left = left_result.unwrap();
-
-    InterpreterResult right_result = tree->right->accept(this);
-    if (right_result.is_error())
-        return right_result;
-    Object* right = right_result.unwrap();
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
 
+InterpreterResult Interpreter::shift_objects(Shift* tree, Object* left, Object* right) {
     ObjectInteger* value = dynamic_cast<ObjectInteger*>(left);
     if (!value) {
+        if (dynamic_cast<ObjectBigInteger*>(left))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "Can not shift a non-integer value"
         );
     }
     ObjectInteger* count = dynamic_cast<ObjectInteger*>(right);
     if (!count || count->value < 0) {
+        if (dynamic_cast<ObjectBigInteger*>(right))
+            return big_integer_binary(tree->op, left, right);
         return InterpreterResult::Error(
             "Shift count is negative"
         );
@@ -415,8 +677,12 @@ InterpreterResult Interpreter::visit_shift(Shift* tree) {
     switch (tree->op.ttype) {
         case TokenType::RIGHT_SHIFT:
             return InterpreterResult::Ok((*value) >> count);
-        case TokenType::LEFT_SHIFT:
-            return InterpreterResult::Ok((*value) << count);
+        case TokenType::LEFT_SHIFT: {
+            Object* shifted = (*value) << count;
+            if (!shifted)
+                return InterpreterResult::Error("Integer result too large");
+            return InterpreterResult::Ok(shifted);
+        }
         default: {}
     }
     return InterpreterResult::Error(
@@ -425,12 +691,12 @@ InterpreterResult Interpreter::visit_shift(Shift* tree) {
 }
 
 InterpreterResult Interpreter::visit_equality(Equality* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
+    InterpreterResult left_result = evaluate(tree->left);
     if (left_result.is_error())
         return left_result;
     const Object* left = left_result.unwrap();
 
-    InterpreterResult right_result = tree->right->accept(this);
+    InterpreterResult right_result = evaluate(tree->right);
     if (right_result.is_error())
         return right_result;
     const Object* right = right_result.unwrap();
@@ -454,19 +720,23 @@ InterpreterResult Interpreter::visit_equality(Equality* tree) {
 }
 
 InterpreterResult Interpreter::visit_bitwise(Bitwise* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
-    if (left_result.is_error())
-        return left_result;
-    const ObjectInteger* left =
-        dynamic_cast<const ObjectInteger*>(left_result.unwrap());
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(value.unwrap().box());
+}
 
-    InterpreterResult right_result = tree->right->accept(this);
-    if (right_result.is_error())
-        return right_result;
-    const ObjectInteger* right =
-        dynamic_cast<const ObjectInteger*>(right_result.unwrap());
+InterpreterResult Interpreter::bitwise_objects(Bitwise* tree, Object* left_obj, Object* right_obj) {
+    const ObjectInteger* left = dynamic_cast<const ObjectInteger*>(left_obj);
+    const ObjectInteger* right = dynamic_cast<const ObjectInteger*>(right_obj);
 
     if (!left || !right) {
+        if (
+            dynamic_cast<const ObjectBigInteger*>(left_obj) ||
+            dynamic_cast<const ObjectBigInteger*>(right_obj)
+        ) {
+            return big_integer_binary(tree->op, left_obj, right_obj);
+        }
         return InterpreterResult::Error(
             "Applying bitwise `"
             + tree->op.value
@@ -496,77 +766,593 @@ InterpreterResult Interpreter::visit_bitwise(Bitwise* tree) {
 }
 
 InterpreterResult Interpreter::visit_logical(Logical* tree) {
-    InterpreterResult left_result = tree->left->accept(this);
-    if (left_result.is_error())
-        return left_result;
-    const ObjectBoolean* left =
-        left_result.unwrap()->to_boolean();
+    ConditionResult condition = evaluate_condition(tree);
+    if (condition.is_error())
+        return InterpreterResult::Error(condition.unwrap_error());
+    return InterpreterResult::Ok(
+        ObjectBoolean::as_object(condition.unwrap())
+    );
+}
 
-    InterpreterResult right_result = tree->right->accept(this);
-    if (right_result.is_error())
-        return right_result;
-    const ObjectBoolean* right =
-        right_result.unwrap()->to_boolean();
+template <typename L, typename R>
+static inline bool compare_numbers(TokenType op, L left, R right) noexcept {
+    switch (op) {
+        case TokenType::GREATER:
+            return left > right;
+        case TokenType::GREATER_EQUAL:
+            return left >= right;
+        case TokenType::LESS:
+            return left < right;
+        default:
+            return left <= right;
+    }
+}
 
-    Object* value = nullptr;
-    switch (tree->op.ttype) {
-        case TokenType::KEYWORD_XOR: {
-            value = left->xor_with(right);
+// Binary operators on unboxed numbers, false leaves the operation to
+// the Object kernels, which handle overflow, big integers and errors
+static inline bool integer_binary(TokenType op, i64 a, i64 b, Value& value) noexcept {
+    i64 result;
+    switch (op) {
+        case TokenType::PLUS:
+            if (__builtin_add_overflow(a, b, &result)) return false;
+            value = Value::of_integer(result);
+            return true;
+        case TokenType::MINUS:
+            if (__builtin_sub_overflow(a, b, &result)) return false;
+            value = Value::of_integer(result);
+            return true;
+        case TokenType::STAR:
+            if (__builtin_mul_overflow(a, b, &result)) return false;
+            value = Value::of_integer(result);
+            return true;
+        case TokenType::SLASH:
+            if (!b) return false;
+            value = Value::of_float(static_cast<float64>(a) / static_cast<float64>(b));
+            return true;
+        case TokenType::DOUBLE_SLASH:
+            if (!b || (a == INT64_MIN && b == -1)) return false;
+            value = Value::of_integer(a / b);
+            return true;
+        case TokenType::PERCENT:
+            if (!b) return false;
+            // INT64_MIN % -1 traps on some targets
+            value = Value::of_integer(b == -1 ? 0 : a % b);
+            return true;
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL:
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+            value = Value::of_boolean(compare_numbers(op, a, b));
+            return true;
+        case TokenType::LEFT_SHIFT:
+            if (b < 0 || b >= 64) return false;
+            result = static_cast<i64>(static_cast<u64>(a) << b);
+            // Bits shifted out need a big integer
+            if ((result >> b) != a) return false;
+            value = Value::of_integer(result);
+            return true;
+        case TokenType::RIGHT_SHIFT:
+            if (b < 0) return false;
+            value = Value::of_integer(b >= 64 ? (a < 0 ? -1 : 0) : a >> b);
+            return true;
+        case TokenType::BITWISE_AND:
+            value = Value::of_integer(a & b);
+            return true;
+        case TokenType::BITWISE_OR:
+            value = Value::of_integer(a | b);
+            return true;
+        case TokenType::BITWISE_XOR:
+            value = Value::of_integer(a ^ b);
+            return true;
+        default: {}
+    }
+    return false;
+}
+
+static inline bool float_binary(TokenType op, float64 a, float64 b, Value& value) noexcept {
+    switch (op) {
+        case TokenType::PLUS:
+            value = Value::of_float(a + b);
+            return true;
+        case TokenType::MINUS:
+            value = Value::of_float(a - b);
+            return true;
+        case TokenType::STAR:
+            value = Value::of_float(a * b);
+            return true;
+        case TokenType::SLASH:
+            if (b == 0) return false;
+            value = Value::of_float(a / b);
+            return true;
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL:
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+            value = Value::of_boolean(compare_numbers(op, a, b));
+            return true;
+        default: {}
+    }
+    return false;
+}
+
+static inline bool native_binary(
+    const Binary* tree, const Value& left, const Value& right, Value& value
+) noexcept {
+    const TokenType op = tree->op.ttype;
+    switch (tree->operands) {
+        case Operands::Floats:
+            // Proven by the TypeChecker, float values are never boxed
+            return float_binary(op, left.real, right.real, value);
+        case Operands::Integers:
+            // Still needs the tag test, big integers stay boxed
+            if (left.tag != ValueTag::INTEGER || right.tag != ValueTag::INTEGER)
+                return false;
+            return integer_binary(op, left.integer, right.integer, value);
+        default: {}
+    }
+    if (left.tag == ValueTag::INTEGER && right.tag == ValueTag::INTEGER)
+        return integer_binary(op, left.integer, right.integer, value);
+    if (!left.is_number() || !right.is_number())
+        return false;
+    return float_binary(op, left.as_float64(), right.as_float64(), value);
+}
+
+// ------------------------- Quickening -------------------------
+
+template <TokenType OP>
+static bool integers_kernel(const Value& left, const Value& right, Value& value) noexcept {
+    return integer_binary(OP, left.integer, right.integer, value);
+}
+
+template <TokenType OP>
+static bool floats_kernel(const Value& left, const Value& right, Value& value) noexcept {
+    return float_binary(OP, left.real, right.real, value);
+}
+
+template <TokenType OP>
+static bool integer_float_kernel(const Value& left, const Value& right, Value& value) noexcept {
+    return float_binary(OP, static_cast<float64>(left.integer), right.real, value);
+}
+
+template <TokenType OP>
+static bool float_integer_kernel(const Value& left, const Value& right, Value& value) noexcept {
+    return float_binary(OP, left.real, static_cast<float64>(right.integer), value);
+}
+
+// string + any and any + string, same conversions as term_objects
+static bool concat_kernel(const Value& left, const Value& right, Value& value) noexcept {
+    if (left.tag == ValueTag::OBJECT && left.object) {
+        if (const ObjectString* left_str = exact_cast<ObjectString>(left.object)) {
+            value = Value::of_object(new ObjectString{*left_str + right.box()->to_string()});
+            return true;
+        }
+    }
+    if (right.tag == ValueTag::OBJECT && right.object) {
+        if (const ObjectString* right_str = exact_cast<ObjectString>(right.object)) {
+            value = Value::of_object(new ObjectString{left.box()->to_string() + *right_str});
+            return true;
+        }
+    }
+    return false;
+}
+
+template <TokenType OP>
+static Binary::Kernel numeric_kernel(ValueTag left, ValueTag right) noexcept {
+    if (left == ValueTag::INTEGER && right == ValueTag::INTEGER)
+        return integers_kernel<OP>;
+    if (left == ValueTag::FLOAT && right == ValueTag::FLOAT)
+        return floats_kernel<OP>;
+    if (left == ValueTag::INTEGER && right == ValueTag::FLOAT)
+        return integer_float_kernel<OP>;
+    if (left == ValueTag::FLOAT && right == ValueTag::INTEGER)
+        return float_integer_kernel<OP>;
+    return nullptr;
+}
+
+template <TokenType OP>
+static Binary::Kernel integer_only_kernel(ValueTag left, ValueTag right) noexcept {
+    if (left == ValueTag::INTEGER && right == ValueTag::INTEGER)
+        return integers_kernel<OP>;
+    return nullptr;
+}
+
+Binary::Kernel select_kernel(TokenType op, ValueTag left, ValueTag right) noexcept {
+    switch (op) {
+        case TokenType::PLUS:
+            if (left == ValueTag::OBJECT || right == ValueTag::OBJECT)
+                return concat_kernel;
+            return numeric_kernel<TokenType::PLUS>(left, right);
+        case TokenType::MINUS:
+            return numeric_kernel<TokenType::MINUS>(left, right);
+        case TokenType::STAR:
+            return numeric_kernel<TokenType::STAR>(left, right);
+        case TokenType::SLASH:
+            return numeric_kernel<TokenType::SLASH>(left, right);
+        case TokenType::GREATER:
+            return numeric_kernel<TokenType::GREATER>(left, right);
+        case TokenType::GREATER_EQUAL:
+            return numeric_kernel<TokenType::GREATER_EQUAL>(left, right);
+        case TokenType::LESS:
+            return numeric_kernel<TokenType::LESS>(left, right);
+        case TokenType::LESS_EQUAL:
+            return numeric_kernel<TokenType::LESS_EQUAL>(left, right);
+        case TokenType::DOUBLE_SLASH:
+            return integer_only_kernel<TokenType::DOUBLE_SLASH>(left, right);
+        case TokenType::PERCENT:
+            return integer_only_kernel<TokenType::PERCENT>(left, right);
+        case TokenType::LEFT_SHIFT:
+            return integer_only_kernel<TokenType::LEFT_SHIFT>(left, right);
+        case TokenType::RIGHT_SHIFT:
+            return integer_only_kernel<TokenType::RIGHT_SHIFT>(left, right);
+        case TokenType::BITWISE_AND:
+            return integer_only_kernel<TokenType::BITWISE_AND>(left, right);
+        case TokenType::BITWISE_OR:
+            return integer_only_kernel<TokenType::BITWISE_OR>(left, right);
+        case TokenType::BITWISE_XOR:
+            return integer_only_kernel<TokenType::BITWISE_XOR>(left, right);
+        default: {}
+    }
+    return nullptr;
+}
+
+bool Interpreter::run_quickened(
+    Binary* tree, const Value& left, const Value& right, Value& value
+) noexcept {
+    if (tree->kernel) {
+        if (left.tag == tree->left_tag && right.tag == tree->right_tag) [[likely]]
+            return tree->kernel(left, right, value);
+        // Frozen nodes may be shared by concurrent runs
+        if (tree->specializations == Binary::FROZEN)
+            return false;
+        // Guard miss, back to the generic path until re-specialized
+        tree->kernel = nullptr;
+        stats.despecialized++;
+    }
+    if (tree->specializations >= Binary::MAX_SPECIALIZATIONS)
+        return false;
+    tree->specializations++;
+    tree->kernel = select_kernel(tree->op.ttype, left.tag, right.tag);
+    if (!tree->kernel) {
+        // Nothing to gain for these operands, stay generic
+        tree->specializations = Binary::MAX_SPECIALIZATIONS;
+        return false;
+    }
+    tree->left_tag = left.tag;
+    tree->right_tag = right.tag;
+    stats.quickened++;
+    return tree->kernel(left, right, value);
+}
+
+void Interpreter::freeze(TreeBase* tree) noexcept {
+    switch (tree->kind) {
+        case TreeKind::Program:
+            for (Statement* stmt : static_cast<Program*>(tree)->statements)
+                freeze(stmt);
+            break;
+        case TreeKind::Block:
+            for (Statement* stmt : static_cast<Block*>(tree)->statements)
+                freeze(stmt);
+            break;
+        case TreeKind::VariableDeclaration:
+            for (const auto& [name, initializer] : static_cast<VariableDeclaration*>(tree)->pairs) {
+                if (initializer)
+                    freeze(initializer);
+            }
+            break;
+        case TreeKind::Assignment:
+            freeze(static_cast<Assignment*>(tree)->expr);
+            break;
+        case TreeKind::Print:
+            if (static_cast<Print*>(tree)->expr)
+                freeze(static_cast<Print*>(tree)->expr);
+            break;
+        case TreeKind::Return:
+            if (static_cast<Return*>(tree)->expr)
+                freeze(static_cast<Return*>(tree)->expr);
+            break;
+        case TreeKind::Cast:
+            freeze(static_cast<Cast*>(tree)->casted_expr);
+            break;
+        case TreeKind::GroupedExpression:
+            freeze(static_cast<GroupedExpression*>(tree)->grouped_expr);
+            break;
+        case TreeKind::Unary:
+            freeze(static_cast<Unary*>(tree)->expr);
+            break;
+        case TreeKind::Logical:
+        case TreeKind::Bitwise:
+        case TreeKind::Equality:
+        case TreeKind::Comparison:
+        case TreeKind::Shift:
+        case TreeKind::Term:
+        case TreeKind::Factor:
+        case TreeKind::Exponential: {
+            Binary* binary = static_cast<Binary*>(tree);
+            freeze(binary->left);
+            freeze(binary->right);
+            // Operands the TypeChecker proved, other nodes stay generic
+            ValueTag tag = ValueTag::OBJECT;
+            if (binary->operands == Operands::Integers)
+                tag = ValueTag::INTEGER;
+            else if (binary->operands == Operands::Floats)
+                tag = ValueTag::FLOAT;
+            if (tag != ValueTag::OBJECT) {
+                binary->kernel = select_kernel(binary->op.ttype, tag, tag);
+                binary->left_tag = binary->right_tag = tag;
+            }
+            binary->specializations = Binary::FROZEN;
             break;
         }
-        case TokenType::KEYWORD_OR: {
-            value = *left || right;
+        default: {}
+    }
+}
+
+// ------------------------- Quickening -------------------------
+
+ValueResult Interpreter::apply_unary(Unary* tree, const Value& operand) {
+    if (tree->operands == Operands::Floats) {
+        // Proven float, - and + can not fail
+        if (tree->unary_op.ttype == TokenType::MINUS)
+            return ValueResult::Ok(Value::of_float(-operand.real));
+        return ValueResult::Ok(operand);
+    }
+    switch (tree->unary_op.ttype) {
+        case TokenType::MINUS:
+            if (operand.tag == ValueTag::INTEGER && operand.integer != INT64_MIN)
+                return ValueResult::Ok(Value::of_integer(-operand.integer));
+            if (operand.tag == ValueTag::FLOAT)
+                return ValueResult::Ok(Value::of_float(-operand.real));
+            break;
+        case TokenType::PLUS:
+            if (operand.is_number())
+                return ValueResult::Ok(operand);
+            break;
+        case TokenType::BANG:
+            if (operand.tag == ValueTag::BOOLEAN)
+                return ValueResult::Ok(Value::of_boolean(!operand.boolean));
+            break;
+        case TokenType::TILDE:
+            if (operand.tag == ValueTag::INTEGER)
+                return ValueResult::Ok(Value::of_integer(~operand.integer));
+            break;
+        default: {}
+    }
+    InterpreterResult result = unary_object(tree, operand.box());
+    if (result.is_error())
+        return ValueResult::Error(result.unwrap_error());
+    if (!run_budget.check_allocation()) [[unlikely]]
+        return ValueResult::Error(run_budget.error());
+    return ValueResult::Ok(Value::unbox(result.unwrap()));
+}
+
+ValueResult Interpreter::apply_binary(Binary* tree, const Value& left, const Value& right) {
+    Value value;
+    if (
+        run_quickened(tree, left, right, value) ||
+        native_binary(tree, left, right, value)
+    ) {
+        // Strings and big integers may grow a lot in a single operation
+        if (value.tag == ValueTag::OBJECT && !run_budget.check_allocation()) [[unlikely]]
+            return ValueResult::Error(run_budget.error());
+        return ValueResult::Ok(value);
+    }
+    InterpreterResult result;
+    switch (tree->kind) {
+        case TreeKind::Term:
+            result = term_objects(static_cast<Term*>(tree), left.box(), right.box());
+            break;
+        case TreeKind::Factor:
+            result = factor_objects(static_cast<Factor*>(tree), left.box(), right.box());
+            break;
+        case TreeKind::Comparison:
+            result = compare_objects(static_cast<Comparison*>(tree), left.box(), right.box());
+            break;
+        case TreeKind::Shift:
+            result = shift_objects(static_cast<Shift*>(tree), left.box(), right.box());
+            break;
+        case TreeKind::Bitwise:
+            result = bitwise_objects(static_cast<Bitwise*>(tree), left.box(), right.box());
             break;
+        default:
+            result = exponential_objects(static_cast<Exponential*>(tree), left.box(), right.box());
+    }
+    if (result.is_error())
+        return ValueResult::Error(result.unwrap_error());
+    if (!run_budget.check_allocation()) [[unlikely]]
+        return ValueResult::Error(run_budget.error());
+    return ValueResult::Ok(Value::unbox(result.unwrap()));
+}
+
+ValueResult Interpreter::evaluate_value(TreeBase* tree) {
+    if (!run_budget.step()) [[unlikely]]
+        return ValueResult::Error(run_budget.error());
+    Sampler::Scope sampled{tree};
+    Profiler::Scope profiled{profiler, tree};
+    switch (tree->kind) {
+        case TreeKind::Literal:
+            return ValueResult::Ok(
+                Value::unbox(static_cast<Literal*>(tree)->value_object)
+            );
+        case TreeKind::Name: {
+            SlotResult slot = env.lookup(static_cast<Name*>(tree)->name_str);
+            if (slot.is_error())
+                return ValueResult::Error(slot.unwrap_error());
+            return ValueResult::Ok(slot.unwrap()->value);
+        }
+        case TreeKind::GroupedExpression:
+            return evaluate_value(
+                static_cast<GroupedExpression*>(tree)->grouped_expr
+            );
+        case TreeKind::Unary: {
+            Unary* unary = static_cast<Unary*>(tree);
+            ValueResult operand_result = evaluate_value(unary->expr);
+            if (operand_result.is_error())
+                return operand_result;
+            return apply_unary(unary, operand_result.unwrap());
+        }
+        case TreeKind::Term:
+        case TreeKind::Factor:
+        case TreeKind::Comparison:
+        case TreeKind::Shift:
+        case TreeKind::Bitwise:
+        case TreeKind::Exponential: {
+            Binary* binary = static_cast<Binary*>(tree);
+            ValueResult left_result = evaluate_value(binary->left);
+            if (left_result.is_error())
+                return left_result;
+            ValueResult right_result = evaluate_value(binary->right);
+            if (right_result.is_error())
+                return right_result;
+            return apply_binary(binary, left_result.unwrap(), right_result.unwrap());
         }
-        case TokenType::KEYWORD_AND: {
-            value = *left && right;
+        case TreeKind::Assignment: {
+            Assignment* assignment = static_cast<Assignment*>(tree);
+            ValueResult value = evaluate_value(assignment->expr);
+            if (value.is_error())
+                return value;
+            SlotResult slot = env.lookup(assignment->name.value);
+            if (slot.is_error())
+                return ValueResult::Error(slot.unwrap_error());
+            EnvironmentResult stored =
+                Environment::store(assignment->name.value, slot.unwrap(), value.unwrap());
+            if (stored.is_error())
+                return ValueResult::Error(stored.unwrap_error());
+            // Assignments produce no value
+            return ValueResult::Ok(Value::of_object(nullptr));
+        }
+        default: {}
+    }
+    InterpreterResult result = tree->accept(this);
+    if (result.is_error())
+        return ValueResult::Error(result.unwrap_error());
+    return ValueResult::Ok(Value::unbox(result.unwrap()));
+}
+
+ConditionResult Interpreter::evaluate_condition(TreeBase* tree) {
+    if (!run_budget.step()) [[unlikely]]
+        return ConditionResult::Error(run_budget.error());
+    Sampler::Scope sampled{tree};
+    Profiler::Scope profiled{profiler, tree};
+    switch (tree->kind) {
+        case TreeKind::Logical: {
+            Logical* logical = static_cast<Logical*>(tree);
+            ConditionResult left = evaluate_condition(logical->left);
+            if (left.is_error())
+                return left;
+            switch (logical->op.ttype) {
+                case TokenType::KEYWORD_AND:
+                    // Right side only runs when it decides the result
+                    if (!left.unwrap())
+                        return ConditionResult::Ok(false);
+                    return evaluate_condition(logical->right);
+                case TokenType::KEYWORD_OR:
+                    if (left.unwrap())
+                        return ConditionResult::Ok(true);
+                    return evaluate_condition(logical->right);
+                case TokenType::KEYWORD_XOR: {
+                    // Always needs both sides
+                    ConditionResult right = evaluate_condition(logical->right);
+                    if (right.is_error())
+                        return right;
+                    return ConditionResult::Ok(left.unwrap() != right.unwrap());
+                }
+                default: {}
+            }
+            return ConditionResult::Error(
+                "Invalid logical operator `" + logical->op.value
+            );
+        }
+        case TreeKind::Comparison: {
+            ValueResult value = evaluate_value(tree);
+            if (value.is_error())
+                return ConditionResult::Error(value.unwrap_error());
+            return ConditionResult::Ok(value.unwrap().boolean);
+        }
+        case TreeKind::Equality: {
+            Equality* equality = static_cast<Equality*>(tree);
+            InterpreterResult left_result = evaluate(equality->left);
+            if (left_result.is_error())
+                return ConditionResult::Error(left_result.unwrap_error());
+            InterpreterResult right_result = evaluate(equality->right);
+            if (right_result.is_error())
+                return ConditionResult::Error(right_result.unwrap_error());
+            const bool equal =
+                left_result.unwrap()->equals(right_result.unwrap())->value;
+            switch (equality->op.ttype) {
+                case TokenType::LOGICAL_EQUAL:
+                    return ConditionResult::Ok(equal);
+                case TokenType::LOGICAL_NOT_EQUAL:
+                    return ConditionResult::Ok(!equal);
+                default: {}
+            }
+            return ConditionResult::Error(
+                "Invalid equality operator " + equality->op.value
+            );
+        }
+        case TreeKind::Unary: {
+            Unary* unary = static_cast<Unary*>(tree);
+            if (unary->unary_op.ttype != TokenType::BANG)
+                break;
+            // Only conditions are known to yield booleans, anything
+            // else must be checked like visit_unary does
+            switch (unary->expr->kind) {
+                case TreeKind::Logical:
+                case TreeKind::Comparison:
+                case TreeKind::Equality: {
+                    ConditionResult operand = evaluate_condition(unary->expr);
+                    if (operand.is_error())
+                        return operand;
+                    return ConditionResult::Ok(!operand.unwrap());
+                }
+                default: {}
+            }
             break;
         }
+        case TreeKind::GroupedExpression:
+            return evaluate_condition(
+                static_cast<GroupedExpression*>(tree)->grouped_expr
+            );
         default: {}
     }
-    if (value) return InterpreterResult::Ok(value);
-    return InterpreterResult::Error(
-        "Invalid logical operator `" + tree->op.value
-    );
+    // Any other expression counts by its truthiness
+    ValueResult result = evaluate_value(tree);
+    if (result.is_error())
+        return ConditionResult::Error(result.unwrap_error());
+    return ConditionResult::Ok(result.unwrap().to_boolean());
 }
 
 InterpreterResult Interpreter::visit_block(Block* tree) {
     if (!tree || tree->statements.empty())
         return InterpreterResult::Ok(nullptr);
-    env.begin_scope();
-    Object* return_value = ObjectVoid::VOID_OBJECT;
+    const bool scoped = tree->declares_variables;
+    if (scoped)
+        env.begin_scope();
+    else
+        env.stats.scopes_elided++;
+    Object* value = nullptr;
     for (Statement* stmt : tree->statements) {
-        InterpreterResult stmt_result = stmt->accept(this);
-        if (stmt_result.is_error())
+        InterpreterResult stmt_result = evaluate(stmt);
+        if (stmt_result.is_error()) {
+            if (scoped) env.end_scope();
             return stmt_result;
-        if (dynamic_cast<Return*>(stmt)) {
-            return_value = stmt_result.unwrap();
-            break;
         }
+        value = stmt_result.unwrap();
+        // Only a tree the Simplifier skipped goes on past the return
+        if (stmt->kind == TreeKind::Return)
+            break;
     }
-    env.end_scope();
-    return InterpreterResult::Ok(return_value);
+    if (scoped)
+        env.end_scope();
+    // The last value is the returned one
+    return InterpreterResult::Ok(tree->has_return ? value : ObjectVoid::VOID_OBJECT);
 }
 
 InterpreterResult Interpreter::visit_cast(Cast* tree) {
     InterpreterResult expr_result =
-        tree->casted_expr->accept(this);
+        evaluate(tree->casted_expr);
     if (expr_result.is_error())
         return expr_result;
-    Object* cast_return =
-        tree->target_type->cast(
-            expr_result.unwrap()
-        );
-    if (!cast_return) {
-        return InterpreterResult::Error(
-            std::format(
-                "Object of type `{}` can not be casted to object of type `{}`",
-                expr_result.unwrap()->type_info->to_string(),
-                tree->target_type->to_string()
-            )
-        );
-    }
-    return InterpreterResult::Ok(cast_return);
+    return tree->target_type->cast(expr_result.unwrap());
 }
 
 InterpreterResult Interpreter::visit_variable_declaration(VariableDeclaration* tree) {
@@ -577,21 +1363,19 @@ InterpreterResult Interpreter::visit_variable_declaration(VariableDeclaration* t
     ) {
         std::pair<std::string, TreeBase*> p = *stmt_ptr;
         std::string name = p.first;
-        EnvironmentResult r = env.define(name);
-        if (r.is_error())
-            return InterpreterResult::Error(r.unwrap_error());
-        Object* value = ObjectVoid::VOID_OBJECT;
+        SlotResult slot = env.define(name, tree->target_type);
+        if (slot.is_error())
+            return InterpreterResult::Error(slot.unwrap_error());
         if (p.second) {
-            InterpreterResult initializer_result =
-                p.second->accept(this);
+            ValueResult initializer_result =
+                evaluate_value(p.second);
             if (initializer_result.is_error())
-                return initializer_result;
-            else
-                value = initializer_result.unwrap();
+                return InterpreterResult::Error(initializer_result.unwrap_error());
+            EnvironmentResult r =
+                Environment::store(name, slot.unwrap(), initializer_result.unwrap());
+            if (r.is_error())
+                return InterpreterResult::Error(r.unwrap_error());
         }
-        r = env.set(name, value);
-        if (r.is_error())
-            return InterpreterResult::Error(r.unwrap_error());
     }
     return InterpreterResult::Ok(nullptr);
 }
@@ -599,32 +1383,30 @@ InterpreterResult Interpreter::visit_variable_declaration(VariableDeclaration* t
 InterpreterResult Interpreter::visit_print(Print* tree) {
     if (tree->expr) {
         InterpreterResult expr_result =
-            tree->expr->accept(this);
+            evaluate(tree->expr);
         if (expr_result.is_error())
             return expr_result;
-        std::string expr_str =
-            expr_result.unwrap()->to_string();
-        std::cout << expr_str ;
+        expr_result.unwrap()->format_to(out);
     }
-    if (Common::is_mode_interactive())
-        std::cout << '\n' ;
+    if (interactive())
+        out.write('\n');
     return InterpreterResult::Ok(nullptr);
 }
 
 InterpreterResult Interpreter::visit_return(Return* tree) {
-    return tree->expr->accept(this);
+    return evaluate(tree->expr);
 }
 
 InterpreterResult Interpreter::visit_name(Name* tree) {
-    EnvironmentResult get_result = env.get(tree->name_str);
-    if (get_result.is_error())
-        return InterpreterResult::Error(get_result.unwrap_error());
-    return InterpreterResult::Ok(get_result.unwrap());
+    SlotResult slot = env.lookup(tree->name_str);
+    if (slot.is_error())
+        return InterpreterResult::Error(slot.unwrap_error());
+    return InterpreterResult::Ok(slot.unwrap()->value.box());
 }
 
 InterpreterResult Interpreter::visit_assignment(Assignment* tree) {
-    InterpreterResult expr_result = tree->expr->accept(this);
-    if (expr_result.is_error())
-        return expr_result;
-    return env.set(tree->name.value, expr_result.unwrap());
+    ValueResult value = evaluate_value(tree);
+    if (value.is_error())
+        return InterpreterResult::Error(value.unwrap_error());
+    return InterpreterResult::Ok(nullptr);
 }
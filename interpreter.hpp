@@ -1,13 +1,70 @@
 #ifndef INTERPRETER_H_INCLUDED
 #define INTERPRETER_H_INCLUDED
 
+#include "budget.hpp"
 #include "environment.hpp"
+#include "output.hpp"
+#include "profiler.hpp"
+#include "sampler.hpp"
 #include "syntax_tree.hpp"
 
+using ConditionResult = Result<bool/*value type*/, std::string/*error type*/>;
+using ValueResult = Result<Value/*value type*/, std::string/*error type*/>;
+
+// Kernel specialized for op on operands tagged left and right
+// nullptr when none beats the generic path
+Binary::Kernel select_kernel(TokenType op, ValueTag left, ValueTag right) noexcept;
+
 class Interpreter: public Visitor {
+public:
+    struct Statistics {
+        u64 quickened = 0;
+        u64 despecialized = 0;
+    };
+
+private:
     Environment env{};
+    OutputSink out{};
+    Statistics stats{};
+    // Interactive runs end every print with a line break
+    Mode mode = Mode::File;
+    // Shared with the other engines, see Budget
+    Budget run_budget{};
+    // Only while profiling
+    Profiler* profiler = nullptr;
+
+    // Evaluate tree with its specialized kernel, installing one first
+    // if needed, false when the generic path has to run
+    bool run_quickened(Binary* tree, const Value& left, const Value& right, Value& value) noexcept;
+
+    // Operators applied to already evaluated operands
+    InterpreterResult unary_object(Unary* tree, Object* expr);
+    InterpreterResult exponential_objects(Exponential* tree, Object* base, Object* exponent);
+    InterpreterResult factor_objects(Factor* tree, Object* left, Object* right);
+    InterpreterResult term_objects(Term* tree, Object* left, Object* right);
+    InterpreterResult compare_objects(Comparison* tree, Object* left, Object* right);
+    InterpreterResult shift_objects(Shift* tree, Object* left, Object* right);
+    InterpreterResult bitwise_objects(Bitwise* tree, Object* left, Object* right);
 public:
+    inline OutputSink& output() noexcept { return out; }
+    inline Environment& environment() noexcept { return env; }
+    inline Budget& budget() noexcept { return run_budget; }
+    inline void set_mode(Mode _mode) noexcept { mode = _mode; }
+    inline bool interactive() const noexcept { return mode == Mode::Interactive; }
+    inline const Environment& environment() const noexcept { return env; }
+    void report_statistics(std::ostream& os) const noexcept;
+    // Every node run afterwards is counted and timed by it
+    inline void use_profiler(Profiler* _profiler) noexcept { profiler = _profiler; }
     InterpreterResult interpret(TreeBase* tree);
+    // Error result for msg, output so far is flushed first
+    InterpreterResult fail(const std::string& msg) noexcept;
+    // What a run of any engine returns for result, failing it when its
+    // last allocations went over the heap limit
+    InterpreterResult finish(const InterpreterResult& result) noexcept;
+    // Fixes the kernels of the operators in a type checked tree from the
+    // operands proven, runs never write to it afterwards, so any number of
+    // them may share it
+    static void freeze(TreeBase* tree) noexcept;
     InterpreterResult visit_program(Program* tree);
     InterpreterResult visit_literal(Literal* tree);
     InterpreterResult visit_grouped_expression(GroupedExpression* tree);
@@ -27,6 +84,24 @@ public:
     InterpreterResult visit_return(Return* tree);
     InterpreterResult visit_name(Name* tree);
     InterpreterResult visit_assignment(Assignment* tree);
+
+    // accept() of a child node, seen by the profilers and counted as a
+    // step of the budget
+    inline InterpreterResult evaluate(TreeBase* tree) {
+        if (!run_budget.step()) [[unlikely]]
+            return InterpreterResult::Error(run_budget.error());
+        Sampler::Scope sampled{tree};
+        Profiler::Scope profiled{profiler, tree};
+        return tree->accept(this);
+    }
+    // Truth value of tree without going through ObjectBoolean results,
+    // `and`/`or` short-circuit, `xor` evaluates both sides
+    ConditionResult evaluate_condition(TreeBase* tree);
+    // Like accept() but int, float and boolean results stay unboxed
+    ValueResult evaluate_value(TreeBase* tree);
+    // Operator of tree applied to evaluated operands, fast paths first
+    ValueResult apply_unary(Unary* tree, const Value& operand);
+    ValueResult apply_binary(Binary* tree, const Value& left, const Value& right);
 };
 
 #endif
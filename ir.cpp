@@ -0,0 +1,501 @@
+#include <unordered_set>
+#include "ir.hpp"
+
+Type* type_of(const Value& value) noexcept {
+    switch (value.tag) {
+        case ValueTag::INTEGER:
+            return TypeInteger::get_type_object();
+        case ValueTag::FLOAT:
+            return TypeFloat::get_type_object();
+        case ValueTag::BOOLEAN:
+            return TypeBoolean::get_type_object();
+        default: {}
+    }
+    return value.object ? value.object->type_info : nullptr;
+}
+
+static inline bool has_kind(const Type* type, TypeKind kind) noexcept {
+    return type && type->kind == kind;
+}
+
+// A constant right operand that can not make / // % >> or ** fail
+static bool safe_right_operand(const IrInstruction* right, TokenType op) noexcept {
+    if (right->opcode != IrOpcode::Constant)
+        return false;
+    const Value& value = right->constant;
+    switch (op) {
+        case TokenType::RIGHT_SHIFT:
+        case TokenType::EXPONENT:
+            return value.tag == ValueTag::INTEGER && value.integer >= 0;
+        default: {}
+    }
+    return value.is_number() && value.as_float64() != 0;
+}
+
+bool IrInstruction::may_fail() const noexcept {
+    switch (opcode) {
+        case IrOpcode::Assign: {
+            const Type* source = operands[0]->type;
+            if (!source)
+                return true;
+            return !(
+                source->kind == type->kind ||
+                (source->kind == TypeKind::INTEGER && type->kind == TypeKind::FLOAT)
+            );
+        }
+        case IrOpcode::Cast:
+            return !operands[0]->type || operands[0]->type->kind != type->kind;
+        case IrOpcode::Unary: {
+            const Unary* tree = static_cast<const Unary*>(origin);
+            if (tree->unary_op.ttype == TokenType::BANG)
+                return !has_kind(operands[0]->type, TypeKind::BOOLEAN);
+            return tree->operands != Operands::Integers && tree->operands != Operands::Floats;
+        }
+        case IrOpcode::Binary: {
+            const Binary* tree = static_cast<const Binary*>(origin);
+            if (tree->operands == Operands::Unknown)
+                return true;
+            switch (tree->op.ttype) {
+                case TokenType::PLUS:
+                case TokenType::MINUS:
+                case TokenType::GREATER:
+                case TokenType::GREATER_EQUAL:
+                case TokenType::LESS:
+                case TokenType::LESS_EQUAL:
+                    return false;
+                case TokenType::BITWISE_AND:
+                case TokenType::BITWISE_OR:
+                case TokenType::BITWISE_XOR:
+                    return tree->operands != Operands::Integers;
+                case TokenType::PERCENT:
+                case TokenType::RIGHT_SHIFT:
+                    return tree->operands != Operands::Integers ||
+                        !safe_right_operand(operands[1], tree->op.ttype);
+                case TokenType::STAR:
+                    return tree->operands == Operands::Integers;
+                case TokenType::LEFT_SHIFT:
+                    // Big integer results have a bit limit
+                    return true;
+                case TokenType::EXPONENT:
+                    // Likewise int powers
+                    if (tree->operands == Operands::Integers)
+                        return true;
+                    return tree->operands != Operands::Floats &&
+                        !safe_right_operand(operands[1], tree->op.ttype);
+                default: {}
+            }
+            return !safe_right_operand(operands[1], tree->op.ttype);
+        }
+        case IrOpcode::DefineGlobal:
+        case IrOpcode::LoadGlobal:
+            // Names are checked, but the Environment is still asked
+            return true;
+        default: {}
+    }
+    return false;
+}
+
+std::vector<IrBlock*> IrBlock::successors() const noexcept {
+    const IrInstruction* last = terminator();
+    if (!last)
+        return {};
+    switch (last->opcode) {
+        case IrOpcode::Branch:
+            return {last->targets[0], last->targets[1]};
+        case IrOpcode::Jump:
+            return {last->targets[0]};
+        default: {}
+    }
+    return {};
+}
+
+// ------------------------- IrFunction -------------------------
+
+IrInstruction* IrFunction::make(IrOpcode opcode) noexcept {
+    IrInstruction* instruction = &instruction_pool.emplace_back(opcode);
+    instruction->id = values_count++;
+    return instruction;
+}
+
+IrBlock* IrFunction::make_block() noexcept {
+    IrBlock* block = &block_pool.emplace_back(static_cast<u32>(blocks.size()));
+    blocks.push_back(block);
+    return block;
+}
+
+size_t IrFunction::size() const noexcept {
+    size_t count = 0;
+    for (const IrBlock* block : blocks)
+        count += block->instructions.size();
+    return count;
+}
+
+std::vector<IrBlock*> IrFunction::reverse_postorder() const noexcept {
+    std::vector<IrBlock*> order;
+    std::unordered_set<const IrBlock*> visited;
+    // Explicit stack of blocks and the next successor to visit
+    std::vector<std::pair<IrBlock*, size_t>> stack{{blocks[0], 0}};
+    visited.insert(blocks[0]);
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        std::vector<IrBlock*> successors = block->successors();
+        if (next < successors.size()) {
+            IrBlock* successor = successors[next++];
+            if (visited.insert(successor).second)
+                stack.emplace_back(successor, 0);
+        } else {
+            order.push_back(block);
+            stack.pop_back();
+        }
+    }
+    return {order.rbegin(), order.rend()};
+}
+
+void IrFunction::replace_uses(
+    const std::unordered_map<IrInstruction*, IrInstruction*>& replacements
+) noexcept {
+    if (replacements.empty())
+        return;
+    auto resolve = [&](IrInstruction* instruction) {
+        for (auto it = replacements.find(instruction); it != replacements.end(); it = replacements.find(instruction))
+            instruction = it->second;
+        return instruction;
+    };
+    for (IrBlock* block : blocks) {
+        std::erase_if(block->instructions, [&](IrInstruction* instruction) {
+            return replacements.contains(instruction);
+        });
+        for (IrInstruction* instruction : block->instructions) {
+            for (IrInstruction*& operand : instruction->operands)
+                operand = resolve(operand);
+        }
+    }
+}
+
+void IrFunction::renumber() noexcept {
+    values_count = 0;
+    for (IrBlock* block : blocks) {
+        for (IrInstruction* instruction : block->instructions)
+            instruction->id = values_count++;
+    }
+}
+
+static const char* mnemonic(IrOpcode opcode) noexcept {
+    switch (opcode) {
+        case IrOpcode::Constant: return "const";
+        case IrOpcode::Copy: return "copy";
+        case IrOpcode::Phi: return "phi";
+        case IrOpcode::LoadGlobal: return "load";
+        case IrOpcode::DefineGlobal: return "define";
+        case IrOpcode::StoreGlobal: return "store";
+        case IrOpcode::Assign: return "assign";
+        case IrOpcode::Unary: return "unary";
+        case IrOpcode::Binary: return "binary";
+        case IrOpcode::Equality: return "equality";
+        case IrOpcode::Xor: return "xor";
+        case IrOpcode::ToBoolean: return "to_boolean";
+        case IrOpcode::Cast: return "cast";
+        case IrOpcode::Print: return "print";
+        case IrOpcode::Branch: return "branch";
+        case IrOpcode::Jump: return "jump";
+        default: {}
+    }
+    return "return";
+}
+
+void IrFunction::dump(std::ostream& os) const {
+    for (const IrBlock* block : blocks) {
+        os << 'b' << block->id << ':' ;
+        for (size_t i = 0; i < block->predecessors.size(); i++)
+            os << (i ? ", b" : "  ; preds b") << block->predecessors[i]->id ;
+        os << '\n' ;
+        for (const IrInstruction* instruction : block->instructions) {
+            os << "    " ;
+            if (!instruction->has_effects())
+                os << '%' << instruction->id << " = " ;
+            os << mnemonic(instruction->opcode) ;
+            if (instruction->type)
+                os << ' ' << instruction->type->type_name ;
+            switch (instruction->opcode) {
+                case IrOpcode::Unary:
+                    os << ' ' << static_cast<Unary*>(instruction->origin)->unary_op.value ;
+                    break;
+                case IrOpcode::Binary:
+                case IrOpcode::Equality:
+                    os << ' ' << static_cast<Binary*>(instruction->origin)->op.value ;
+                    break;
+                case IrOpcode::Constant: {
+                    Object* value = instruction->constant.box();
+                    os << ' ' << (value ? value->to_string() : "none") ;
+                    break;
+                }
+                default: {}
+            }
+            if (!instruction->name.empty())
+                os << ' ' << instruction->name ;
+            for (size_t i = 0; i < instruction->operands.size(); i++) {
+                os << (i ? ", " : " ") ;
+                if (instruction->opcode == IrOpcode::Phi)
+                    os << "[%" << instruction->operands[i]->id << ", b" << instruction->incoming[i]->id << ']' ;
+                else
+                    os << '%' << instruction->operands[i]->id ;
+            }
+            for (size_t i = 0; i < 2 && instruction->targets[i]; i++)
+                os << (i || !instruction->operands.empty() ? ", b" : " b") << instruction->targets[i]->id ;
+            os << '\n' ;
+        }
+    }
+}
+
+// ------------------------- IrBuilder -------------------------
+
+void IrBuilder::build(TreeBase* tree, IrFunction& out) noexcept {
+    function = &out;
+    scopes.clear();
+    scopes.emplace_back();
+    current = out.make_block();
+    IrInstruction* value = statement(tree);
+    append(IrOpcode::Return)->operands.push_back(value);
+}
+
+IrInstruction* IrBuilder::append(IrOpcode opcode, Type* type) noexcept {
+    IrInstruction* instruction = function->make(opcode);
+    instruction->type = type;
+    instruction->block = current;
+    current->instructions.push_back(instruction);
+    return instruction;
+}
+
+IrInstruction* IrBuilder::constant(const Value& value) noexcept {
+    IrInstruction* instruction = append(IrOpcode::Constant, type_of(value));
+    instruction->constant = value;
+    return instruction;
+}
+
+IrBuilder::Variable* IrBuilder::lookup(const std::string& name) noexcept {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); scope++) {
+        auto entry = scope->find(name);
+        if (entry != scope->end())
+            return &entry->second;
+    }
+    // Declared by an earlier program
+    const Slot* slot = env.find(name);
+    if (!slot)
+        return nullptr;
+    return &(scopes.front()[name] = Variable{slot->type, nullptr, true});
+}
+
+IrInstruction* IrBuilder::load(const std::string& name) noexcept {
+    Variable* variable = lookup(name);
+    if (!variable->value) {
+        variable->value = append(IrOpcode::LoadGlobal, variable->type);
+        variable->value->name = name;
+    }
+    return variable->value;
+}
+
+void IrBuilder::store(const std::string& name, IrInstruction* value) noexcept {
+    Variable* variable = lookup(name);
+    IrInstruction* assign = append(IrOpcode::Assign, variable->type);
+    assign->operands.push_back(value);
+    assign->name = name;
+    variable->value = assign;
+    if (variable->global) {
+        IrInstruction* global = append(IrOpcode::StoreGlobal);
+        global->operands.push_back(assign);
+        global->name = name;
+    }
+}
+
+IrInstruction* IrBuilder::statement(TreeBase* tree) noexcept {
+    switch (tree->kind) {
+        case TreeKind::Program: {
+            // Value of the program is the value of its last statement
+            IrInstruction* value = constant(Value::of_object(nullptr));
+            for (Statement* stmt : static_cast<Program*>(tree)->statements)
+                value = statement(stmt);
+            return value;
+        }
+        case TreeKind::VariableDeclaration:
+            return variable_declaration(static_cast<VariableDeclaration*>(tree));
+        case TreeKind::Assignment: {
+            Assignment* assignment = static_cast<Assignment*>(tree);
+            store(assignment->name.value, expression(assignment->expr));
+            return constant(Value::of_object(nullptr));
+        }
+        case TreeKind::Print: {
+            Print* print = static_cast<Print*>(tree);
+            IrInstruction* value = print->expr ? expression(print->expr) : nullptr;
+            IrInstruction* instruction = append(IrOpcode::Print);
+            if (value)
+                instruction->operands.push_back(value);
+            return constant(Value::of_object(nullptr));
+        }
+        case TreeKind::Return:
+            return expression(static_cast<Return*>(tree)->expr);
+        default: {}
+    }
+    return expression(tree);
+}
+
+IrInstruction* IrBuilder::variable_declaration(VariableDeclaration* tree) noexcept {
+    Type* type = tree->target_type;
+    const bool global = keep_globals && scopes.size() == 1;
+    for (const auto& [name, initializer] : tree->pairs) {
+        if (global)
+            append(IrOpcode::DefineGlobal, type)->name = name;
+        scopes.back()[name] =
+            Variable{type, constant(Environment::zero_value(type)), global};
+        if (initializer)
+            store(name, expression(initializer));
+    }
+    return constant(Value::of_object(nullptr));
+}
+
+IrInstruction* IrBuilder::expression(TreeBase* tree) noexcept {
+    switch (tree->kind) {
+        case TreeKind::Literal:
+            return constant(Value::unbox(static_cast<Literal*>(tree)->value_object));
+        case TreeKind::Name:
+            return load(static_cast<Name*>(tree)->name_str);
+        case TreeKind::GroupedExpression:
+            return expression(static_cast<GroupedExpression*>(tree)->grouped_expr);
+        case TreeKind::Cast: {
+            Cast* cast = static_cast<Cast*>(tree);
+            IrInstruction* operand = expression(cast->casted_expr);
+            IrInstruction* instruction = append(IrOpcode::Cast, cast->target_type);
+            instruction->operands.push_back(operand);
+            return instruction;
+        }
+        case TreeKind::Block:
+            return block(static_cast<Block*>(tree));
+        case TreeKind::Unary:
+            return unary(static_cast<Unary*>(tree));
+        case TreeKind::Equality: {
+            Equality* equality = static_cast<Equality*>(tree);
+            IrInstruction* left = expression(equality->left);
+            IrInstruction* right = expression(equality->right);
+            IrInstruction* instruction =
+                append(IrOpcode::Equality, TypeBoolean::get_type_object());
+            instruction->operands = {left, right};
+            instruction->origin = tree;
+            return instruction;
+        }
+        case TreeKind::Logical:
+            return logical(static_cast<Logical*>(tree));
+        default: {}
+    }
+    return binary(static_cast<Binary*>(tree));
+}
+
+IrInstruction* IrBuilder::block(Block* tree) noexcept {
+    if (tree->statements.empty())
+        return constant(Value::of_object(nullptr));
+    if (tree->declares_variables)
+        scopes.emplace_back();
+    IrInstruction* value = nullptr;
+    for (Statement* stmt : tree->statements) {
+        if (stmt->kind == TreeKind::Return) {
+            value = expression(static_cast<Return*>(stmt)->expr);
+            break;
+        }
+        statement(stmt);
+    }
+    if (!value)
+        value = constant(Value::of_object(ObjectVoid::VOID_OBJECT));
+    if (tree->declares_variables)
+        scopes.pop_back();
+    return value;
+}
+
+IrInstruction* IrBuilder::unary(Unary* tree) noexcept {
+    IrInstruction* operand = expression(tree->expr);
+    Type* type = nullptr;
+    if (tree->unary_op.ttype == TokenType::BANG)
+        type = TypeBoolean::get_type_object();
+    else if (tree->operands == Operands::Integers)
+        type = TypeInteger::get_type_object();
+    else if (tree->operands == Operands::Floats)
+        type = TypeFloat::get_type_object();
+    IrInstruction* instruction = append(IrOpcode::Unary, type);
+    instruction->operands.push_back(operand);
+    instruction->origin = tree;
+    return instruction;
+}
+
+IrInstruction* IrBuilder::binary(Binary* tree) noexcept {
+    IrInstruction* left = expression(tree->left);
+    IrInstruction* right = expression(tree->right);
+    const TokenType op = tree->op.ttype;
+    Type* type = nullptr;
+    if (tree->kind == TreeKind::Comparison) {
+        type = TypeBoolean::get_type_object();
+    } else if (op == TokenType::SLASH && tree->operands != Operands::Unknown) {
+        type = TypeFloat::get_type_object();
+    } else if (tree->operands == Operands::Integers && op != TokenType::EXPONENT) {
+        type = TypeInteger::get_type_object();
+    } else if (
+        tree->operands != Operands::Integers && tree->operands != Operands::Unknown &&
+        (op == TokenType::PLUS || op == TokenType::MINUS || op == TokenType::STAR)
+    ) {
+        type = TypeFloat::get_type_object();
+    }
+    IrInstruction* instruction = append(IrOpcode::Binary, type);
+    instruction->operands = {left, right};
+    instruction->origin = tree;
+    return instruction;
+}
+
+IrInstruction* IrBuilder::logical(Logical* tree) noexcept {
+    IrInstruction* left = expression(tree->left);
+    Type* boolean = TypeBoolean::get_type_object();
+    if (tree->op.ttype == TokenType::KEYWORD_XOR) {
+        IrInstruction* right = expression(tree->right);
+        IrInstruction* instruction = append(IrOpcode::Xor, boolean);
+        instruction->operands = {left, right};
+        return instruction;
+    }
+    // Right operand only runs when it decides the result
+    IrBlock* left_end = current;
+    IrBlock* right_begin = function->make_block();
+    IrBlock* join = function->make_block();
+    IrInstruction* branch = append(IrOpcode::Branch);
+    branch->operands.push_back(left);
+    if (tree->op.ttype == TokenType::KEYWORD_AND) {
+        branch->targets[0] = right_begin;
+        branch->targets[1] = join;
+    } else {
+        branch->targets[0] = join;
+        branch->targets[1] = right_begin;
+    }
+    const std::vector<Scope> before = scopes;
+    right_begin->predecessors.push_back(left_end);
+    current = right_begin;
+    IrInstruction* right = expression(tree->right);
+    IrBlock* right_end = current;
+    append(IrOpcode::Jump)->targets[0] = join;
+    join->predecessors = {left_end, right_end};
+    current = join;
+    auto phi = [&](Type* type, IrInstruction* from_left, IrInstruction* from_right) {
+        IrInstruction* instruction = append(IrOpcode::Phi, type);
+        instruction->operands = {from_left, from_right};
+        instruction->incoming = {left_end, right_end};
+        return instruction;
+    };
+    IrInstruction* value = phi(left->type == right->type ? left->type : nullptr, left, right);
+    // Variables the right operand assigned get a phi too
+    for (size_t i = 0; i < before.size(); i++) {
+        for (auto& [name, variable] : scopes[i]) {
+            auto previous = before[i].find(name);
+            if (previous == before[i].end() || !previous->second.value) {
+                // Loaded on one path only, loaded again when needed
+                variable.value = nullptr;
+            } else if (previous->second.value != variable.value) {
+                variable.value = phi(variable.type, previous->second.value, variable.value);
+            }
+        }
+    }
+    IrInstruction* instruction = append(IrOpcode::ToBoolean, boolean);
+    instruction->operands.push_back(value);
+    return instruction;
+}
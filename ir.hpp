@@ -0,0 +1,162 @@
+#ifndef IR_H_INCLUDED
+#define IR_H_INCLUDED
+
+#include <deque>
+#include <unordered_map>
+#include "environment.hpp"
+#include "syntax_tree.hpp"
+
+// SSA form of a program, lowered from a type checked tree by IrBuilder,
+// optimized by the passes in ir_passes.hpp and run by IrInterpreter
+// Local variables are SSA values, globals other programs can see live in
+// the Environment and are loaded and stored explicitly
+enum class IrOpcode : u8 {
+    Constant,
+    // Same value as its operand, left by passes for copy propagation
+    Copy,
+    Phi,
+    LoadGlobal,
+    DefineGlobal,
+    StoreGlobal,
+    // Value converted for a variable of `type`, as Environment::store
+    Assign,
+    Unary,
+    Binary,
+    Equality,
+    Xor,
+    ToBoolean,
+    Cast,
+    Print,
+    // Terminators
+    Branch,
+    Jump,
+    Return,
+};
+
+class IrBlock;
+
+class IrInstruction {
+public:
+    IrOpcode opcode;
+    // %id in dumps, also where IrInterpreter keeps the value
+    u32 id = 0;
+    // Static type of the value, nullptr when unknown or there's no value
+    Type* type = nullptr;
+    std::vector<IrInstruction*> operands{};
+    // Phi, the predecessor each operand comes from
+    std::vector<IrBlock*> incoming{};
+    // Branch, taken when true then when false, Jump, its target
+    IrBlock* targets[2] = {nullptr, nullptr};
+    Value constant{};
+    // Unary and Binary, node with the operator and its kernels
+    TreeBase* origin = nullptr;
+    // Variable of Assign and the global instructions
+    std::string name{};
+    IrBlock* block = nullptr;
+
+    IrInstruction(IrOpcode _opcode): opcode{_opcode} {}
+
+    inline bool is_terminator() const noexcept {
+        return opcode == IrOpcode::Branch || opcode == IrOpcode::Jump || opcode == IrOpcode::Return;
+    }
+
+    // Must stay even without users
+    inline bool has_effects() const noexcept {
+        switch (opcode) {
+            case IrOpcode::DefineGlobal:
+            case IrOpcode::StoreGlobal:
+            case IrOpcode::Print:
+            case IrOpcode::Branch:
+            case IrOpcode::Jump:
+            case IrOpcode::Return:
+                return true;
+            default: {}
+        }
+        return false;
+    }
+
+    // Whether running it can end the program with an error
+    bool may_fail() const noexcept;
+};
+
+class IrBlock {
+public:
+    u32 id;
+    std::vector<IrInstruction*> instructions{};
+    std::vector<IrBlock*> predecessors{};
+
+    IrBlock(u32 _id): id{_id} {}
+
+    inline IrInstruction* terminator() const noexcept {
+        return instructions.empty() ? nullptr : instructions.back();
+    }
+
+    std::vector<IrBlock*> successors() const noexcept;
+};
+
+class IrFunction {
+    std::deque<IrInstruction> instruction_pool{};
+    std::deque<IrBlock> block_pool{};
+
+public:
+    // Entry block first
+    std::vector<IrBlock*> blocks{};
+    u32 values_count = 0;
+
+    IrInstruction* make(IrOpcode opcode) noexcept;
+    IrBlock* make_block() noexcept;
+
+    size_t size() const noexcept;
+    // Predecessors before successors, unreachable blocks left out
+    std::vector<IrBlock*> reverse_postorder() const noexcept;
+    // Rewrites every use of a key to its value, dropping the keys
+    void replace_uses(const std::unordered_map<IrInstruction*, IrInstruction*>& replacements) noexcept;
+    // Dense ids after passes removed instructions
+    void renumber() noexcept;
+    void dump(std::ostream& os) const;
+};
+
+// Lowers a tree that passed the TypeChecker
+class IrBuilder {
+    struct Variable {
+        Type* type;
+        // Current SSA value, nullptr for globals not loaded yet
+        IrInstruction* value;
+        // Lives in the Environment
+        bool global;
+    };
+    using Scope = std::unordered_map<std::string, Variable>;
+
+    const Environment& env;
+    IrFunction* function = nullptr;
+    IrBlock* current = nullptr;
+    std::vector<Scope> scopes{};
+    // Top level variables stay in the Environment only for later
+    // programs, file mode runs a single one
+    bool keep_globals;
+
+    IrInstruction* append(IrOpcode opcode, Type* type = nullptr) noexcept;
+    IrInstruction* constant(const Value& value) noexcept;
+    Variable* lookup(const std::string& name) noexcept;
+    IrInstruction* load(const std::string& name) noexcept;
+    void store(const std::string& name, IrInstruction* value) noexcept;
+
+    IrInstruction* statement(TreeBase* tree) noexcept;
+    IrInstruction* variable_declaration(VariableDeclaration* tree) noexcept;
+    IrInstruction* expression(TreeBase* tree) noexcept;
+    IrInstruction* block(Block* tree) noexcept;
+    IrInstruction* unary(Unary* tree) noexcept;
+    IrInstruction* binary(Binary* tree) noexcept;
+    IrInstruction* logical(Logical* tree) noexcept;
+
+public:
+    IrBuilder(const Environment& _env, bool _keep_globals):
+        env{_env}, keep_globals{_keep_globals} {}
+
+    void build(TreeBase* tree, IrFunction& out) noexcept;
+};
+
+// Static type of a runtime value
+Type* type_of(const Value& value) noexcept;
+
+#endif
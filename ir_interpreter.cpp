@@ -0,0 +1,121 @@
+#include "ir_interpreter.hpp"
+
+ValueResult IrInterpreter::apply(
+    const IrInstruction* instruction, const Value* operands
+) noexcept {
+    switch (instruction->opcode) {
+        case IrOpcode::Copy:
+            return ValueResult::Ok(operands[0]);
+        case IrOpcode::Assign: {
+            Slot slot{instruction->type};
+            EnvironmentResult stored =
+                Environment::store(instruction->name, &slot, operands[0]);
+            if (stored.is_error())
+                return ValueResult::Error(stored.unwrap_error());
+            return ValueResult::Ok(slot.value);
+        }
+        case IrOpcode::Unary:
+            return interpreter.apply_unary(static_cast<Unary*>(instruction->origin), operands[0]);
+        case IrOpcode::Binary:
+            return interpreter.apply_binary(
+                static_cast<Binary*>(instruction->origin), operands[0], operands[1]
+            );
+        case IrOpcode::Equality: {
+            const bool negated =
+                static_cast<Equality*>(instruction->origin)->op.ttype == TokenType::LOGICAL_NOT_EQUAL;
+            return ValueResult::Ok(Value::of_boolean(operands[0].equals(operands[1]) != negated));
+        }
+        case IrOpcode::Xor:
+            return ValueResult::Ok(
+                Value::of_boolean(operands[0].to_boolean() != operands[1].to_boolean())
+            );
+        case IrOpcode::ToBoolean:
+            return ValueResult::Ok(Value::of_boolean(operands[0].to_boolean()));
+        case IrOpcode::Cast: {
+            CastResult cast = instruction->type->cast(operands[0].box());
+            if (cast.is_error())
+                return ValueResult::Error(cast.unwrap_error());
+            return ValueResult::Ok(Value::unbox(cast.unwrap()));
+        }
+        default: {}
+    }
+    return ValueResult::Ok(instruction->constant);
+}
+
+InterpreterResult IrInterpreter::run(const IrFunction& function) noexcept {
+    std::vector<Value> values(function.values_count);
+    Environment& env = interpreter.environment();
+    OutputSink& out = interpreter.output();
+    Budget& budget = interpreter.budget();
+    const IrBlock* previous = nullptr;
+    const IrBlock* block = function.blocks[0];
+    while (true) {
+        const IrBlock* next = nullptr;
+        for (const IrInstruction* instruction : block->instructions) {
+            if (!budget.step()) [[unlikely]]
+                return interpreter.fail(budget.error());
+            Value& value = values[instruction->id];
+            switch (instruction->opcode) {
+                case IrOpcode::Constant:
+                    value = instruction->constant;
+                    break;
+                case IrOpcode::Phi:
+                    for (size_t i = 0; i < instruction->incoming.size(); i++) {
+                        if (instruction->incoming[i] == previous)
+                            value = values[instruction->operands[i]->id];
+                    }
+                    break;
+                case IrOpcode::LoadGlobal: {
+                    SlotResult slot = env.lookup(instruction->name);
+                    if (slot.is_error())
+                        return interpreter.fail(slot.unwrap_error());
+                    value = slot.unwrap()->value;
+                    break;
+                }
+                case IrOpcode::DefineGlobal: {
+                    SlotResult slot = env.define(instruction->name, instruction->type);
+                    if (slot.is_error())
+                        return interpreter.fail(slot.unwrap_error());
+                    break;
+                }
+                case IrOpcode::StoreGlobal: {
+                    // Converted by the Assign it stores
+                    SlotResult slot = env.lookup(instruction->name);
+                    if (slot.is_error())
+                        return interpreter.fail(slot.unwrap_error());
+                    slot.unwrap()->value = values[instruction->operands[0]->id];
+                    break;
+                }
+                case IrOpcode::Print:
+                    if (!instruction->operands.empty())
+                        values[instruction->operands[0]->id].box()->format_to(out);
+                    if (interpreter.interactive())
+                        out.write('\n');
+                    break;
+                case IrOpcode::Branch:
+                    next = instruction->targets[
+                        values[instruction->operands[0]->id].to_boolean() ? 0 : 1
+                    ];
+                    break;
+                case IrOpcode::Jump:
+                    next = instruction->targets[0];
+                    break;
+                case IrOpcode::Return: {
+                    Object* result = values[instruction->operands[0]->id].box();
+                    return interpreter.finish(InterpreterResult::Ok(result));
+                }
+                default: {
+                    Value operands[2];
+                    for (size_t i = 0; i < instruction->operands.size(); i++)
+                        operands[i] = values[instruction->operands[i]->id];
+                    ValueResult result = apply(instruction, operands);
+                    if (result.is_error())
+                        return interpreter.fail(result.unwrap_error());
+                    value = result.unwrap();
+                }
+            }
+        }
+        previous = block;
+        block = next;
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef IR_INTERPRETER_H_INCLUDED
+#define IR_INTERPRETER_H_INCLUDED
+
+#include "interpreter.hpp"
+#include "ir.hpp"
+
+// Runs an IrFunction, operators go through the Interpreter's kernels and
+// globals, output and errors are shared with it
+class IrInterpreter {
+    Interpreter& interpreter;
+
+public:
+    IrInterpreter(Interpreter& _interpreter): interpreter{_interpreter} {}
+
+    // Value of an instruction without effects given its operands' values,
+    // also how ConstantPropagation folds
+    ValueResult apply(const IrInstruction* instruction, const Value* operands) noexcept;
+    InterpreterResult run(const IrFunction& function) noexcept;
+};
+
+#endif
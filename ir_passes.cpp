@@ -0,0 +1,325 @@
+#include <chrono>
+#include <unordered_set>
+#include "ir_passes.hpp"
+#include "trace.hpp"
+
+// ------------------------- Constant propagation -------------------------
+
+// Drops the edge from predecessor into block, phis included
+static void remove_edge(IrBlock* predecessor, IrBlock* block) noexcept {
+    std::erase(block->predecessors, predecessor);
+    for (IrInstruction* instruction : block->instructions) {
+        if (instruction->opcode != IrOpcode::Phi)
+            continue;
+        for (size_t i = instruction->incoming.size(); i-- > 0;) {
+            if (instruction->incoming[i] == predecessor) {
+                instruction->incoming.erase(instruction->incoming.begin() + i);
+                instruction->operands.erase(instruction->operands.begin() + i);
+            }
+        }
+    }
+}
+
+static void make_constant(IrInstruction* instruction, const Value& value) noexcept {
+    instruction->opcode = IrOpcode::Constant;
+    instruction->constant = value;
+    instruction->type = type_of(value);
+    instruction->operands.clear();
+    instruction->incoming.clear();
+}
+
+static void make_copy(IrInstruction* instruction, IrInstruction* source) noexcept {
+    instruction->opcode = IrOpcode::Copy;
+    instruction->operands = {source};
+    instruction->incoming.clear();
+}
+
+void ConstantPropagation::run(IrFunction& function) noexcept {
+    std::unordered_set<IrBlock*> reachable{function.blocks[0]};
+    // The CFG is acyclic, predecessors are done before their successors
+    for (IrBlock* block : function.reverse_postorder()) {
+        if (!reachable.contains(block))
+            continue;
+        const std::vector<IrBlock*> predecessors = block->predecessors;
+        for (IrBlock* predecessor : predecessors) {
+            if (!reachable.contains(predecessor))
+                remove_edge(predecessor, block);
+        }
+        for (IrInstruction* instruction : block->instructions) {
+            switch (instruction->opcode) {
+                case IrOpcode::Phi: {
+                    IrInstruction* first = instruction->operands[0];
+                    bool same = true;
+                    for (IrInstruction* operand : instruction->operands)
+                        same = same && operand == first;
+                    if (same && first->opcode == IrOpcode::Constant)
+                        make_constant(instruction, first->constant);
+                    else if (same)
+                        make_copy(instruction, first);
+                    break;
+                }
+                case IrOpcode::Copy:
+                case IrOpcode::Assign:
+                case IrOpcode::Unary:
+                case IrOpcode::Binary:
+                case IrOpcode::Equality:
+                case IrOpcode::Xor:
+                case IrOpcode::ToBoolean:
+                case IrOpcode::Cast: {
+                    Value operands[2];
+                    bool known = true;
+                    for (size_t i = 0; i < instruction->operands.size(); i++) {
+                        const IrInstruction* operand = instruction->operands[i];
+                        while (operand->opcode == IrOpcode::Copy)
+                            operand = operand->operands[0];
+                        // Nothing to gain evaluating expressions without a value
+                        known = known && operand->opcode == IrOpcode::Constant &&
+                            (operand->constant.tag != ValueTag::OBJECT || operand->constant.object);
+                        if (known)
+                            operands[i] = operand->constant;
+                    }
+                    if (!known)
+                        break;
+                    ValueResult result = evaluator.apply(instruction, operands);
+                    if (result.is_ok())
+                        make_constant(instruction, result.unwrap());
+                    break;
+                }
+                case IrOpcode::Branch: {
+                    const IrInstruction* condition = instruction->operands[0];
+                    if (condition->opcode != IrOpcode::Constant)
+                        break;
+                    const bool taken = condition->constant.to_boolean();
+                    IrBlock* target = instruction->targets[taken ? 0 : 1];
+                    IrBlock* skipped = instruction->targets[taken ? 1 : 0];
+                    instruction->opcode = IrOpcode::Jump;
+                    instruction->operands.clear();
+                    instruction->targets[0] = target;
+                    instruction->targets[1] = nullptr;
+                    if (skipped != target)
+                        remove_edge(block, skipped);
+                    break;
+                }
+                default: {}
+            }
+        }
+        for (IrBlock* successor : block->successors())
+            reachable.insert(successor);
+    }
+    std::erase_if(function.blocks, [&](IrBlock* block) {
+        return !reachable.contains(block);
+    });
+}
+
+// ------------------------- Copy propagation -------------------------
+
+void CopyPropagation::run(IrFunction& function) noexcept {
+    std::unordered_map<IrInstruction*, IrInstruction*> replacements;
+    for (IrBlock* block : function.blocks) {
+        for (IrInstruction* instruction : block->instructions) {
+            switch (instruction->opcode) {
+                case IrOpcode::Copy:
+                    replacements[instruction] = instruction->operands[0];
+                    break;
+                case IrOpcode::Phi: {
+                    IrInstruction* first = instruction->operands[0];
+                    if (std::ranges::all_of(instruction->operands, [&](auto* o) { return o == first; }))
+                        replacements[instruction] = first;
+                    break;
+                }
+                case IrOpcode::Assign: {
+                    // Stores of the declared type keep the value as it is
+                    const Type* source = instruction->operands[0]->type;
+                    if (source && source->kind == instruction->type->kind)
+                        replacements[instruction] = instruction->operands[0];
+                    break;
+                }
+                default: {}
+            }
+        }
+    }
+    function.replace_uses(replacements);
+}
+
+// ------------------------- Dead code elimination -------------------------
+
+void DeadCodeElimination::run(IrFunction& function) noexcept {
+    std::unordered_map<const IrInstruction*, size_t> uses;
+    for (IrBlock* block : function.blocks) {
+        for (IrInstruction* instruction : block->instructions) {
+            for (IrInstruction* operand : instruction->operands)
+                uses[operand]++;
+        }
+    }
+    auto removable = [&](const IrInstruction* instruction) {
+        return !uses[instruction] && !instruction->has_effects() && !instruction->may_fail();
+    };
+    std::vector<IrInstruction*> worklist;
+    for (IrBlock* block : function.blocks) {
+        for (IrInstruction* instruction : block->instructions) {
+            if (removable(instruction))
+                worklist.push_back(instruction);
+        }
+    }
+    std::unordered_set<IrInstruction*> dead;
+    while (!worklist.empty()) {
+        IrInstruction* instruction = worklist.back();
+        worklist.pop_back();
+        if (!dead.insert(instruction).second)
+            continue;
+        for (IrInstruction* operand : instruction->operands) {
+            if (--uses[operand] == 0 && removable(operand))
+                worklist.push_back(operand);
+        }
+    }
+    for (IrBlock* block : function.blocks) {
+        std::erase_if(block->instructions, [&](IrInstruction* instruction) {
+            return dead.contains(instruction);
+        });
+    }
+}
+
+// ------------------------- Common subexpression elimination -------------------------
+
+// Identifies what an instruction computes, empty when it can't be shared
+static std::string value_key(const IrInstruction* instruction) {
+    std::string key;
+    switch (instruction->opcode) {
+        case IrOpcode::Constant: {
+            const Value& value = instruction->constant;
+            switch (value.tag) {
+                case ValueTag::INTEGER:
+                    return std::format("i{}", value.integer);
+                case ValueTag::FLOAT: {
+                    // Bit pattern, 0.0 and -0.0 differ
+                    char digits[64];
+                    std::snprintf(digits, sizeof(digits), "%La", value.real);
+                    return std::format("f{}", digits);
+                }
+                case ValueTag::BOOLEAN:
+                    return std::format("b{}", value.boolean);
+                default: {}
+            }
+            return std::format("o{}", static_cast<const void*>(value.object));
+        }
+        case IrOpcode::Unary:
+            key = std::format("u{}", static_cast<int>(static_cast<Unary*>(instruction->origin)->unary_op.ttype));
+            break;
+        case IrOpcode::Binary:
+        case IrOpcode::Equality:
+            key = std::format("n{}", static_cast<int>(static_cast<Binary*>(instruction->origin)->op.ttype));
+            break;
+        case IrOpcode::Assign:
+        case IrOpcode::Cast:
+            // Same conversion to the same type
+            key = std::format("c{}{}", static_cast<int>(instruction->opcode), instruction->type->type_name);
+            break;
+        case IrOpcode::Xor:
+        case IrOpcode::ToBoolean:
+            key = std::format("l{}", static_cast<int>(instruction->opcode));
+            break;
+        default:
+            return key;
+    }
+    for (const IrInstruction* operand : instruction->operands)
+        key += std::format(",{}", operand->id);
+    return key;
+}
+
+void CommonSubexpressionElimination::run(IrFunction& function) noexcept {
+    // Immediate dominators, Cooper, Harvey and Kennedy on the acyclic CFG
+    std::vector<IrBlock*> order = function.reverse_postorder();
+    std::unordered_map<const IrBlock*, size_t> position;
+    for (size_t i = 0; i < order.size(); i++)
+        position[order[i]] = i;
+    std::vector<size_t> idom(order.size(), 0);
+    for (size_t i = 1; i < order.size(); i++) {
+        size_t dominator = SIZE_MAX;
+        for (const IrBlock* predecessor : order[i]->predecessors) {
+            auto found = position.find(predecessor);
+            // Unreachable
+            if (found == position.end())
+                continue;
+            size_t other = found->second;
+            if (dominator == SIZE_MAX) {
+                dominator = other;
+                continue;
+            }
+            while (dominator != other) {
+                while (dominator > other) dominator = idom[dominator];
+                while (other > dominator) other = idom[other];
+            }
+        }
+        idom[i] = dominator;
+    }
+    std::vector<std::vector<size_t>> children(order.size());
+    for (size_t i = 1; i < order.size(); i++)
+        children[idom[i]].push_back(i);
+
+    // Available values along the current path of the dominator tree
+    std::unordered_map<std::string, IrInstruction*> available;
+    std::unordered_map<IrInstruction*, IrInstruction*> replacements;
+    auto visit = [&](auto& self, size_t index) -> void {
+        std::vector<std::string> added;
+        for (IrInstruction* instruction : order[index]->instructions) {
+            // Operands already replaced get their replacement's id
+            for (IrInstruction*& operand : instruction->operands) {
+                auto replaced = replacements.find(operand);
+                if (replaced != replacements.end())
+                    operand = replaced->second;
+            }
+            std::string key = value_key(instruction);
+            if (key.empty())
+                continue;
+            auto [entry, inserted] = available.try_emplace(key, instruction);
+            if (inserted)
+                added.push_back(std::move(key));
+            else
+                replacements[instruction] = entry->second;
+        }
+        for (size_t child : children[index])
+            self(self, child);
+        for (const std::string& key : added)
+            available.erase(key);
+    };
+    visit(visit, 0);
+    function.replace_uses(replacements);
+}
+
+// ------------------------- PassManager -------------------------
+
+void PassManager::add(std::unique_ptr<IrPass> pass) {
+    passes.push_back(std::move(pass));
+}
+
+void PassManager::run(IrFunction& function) noexcept {
+    timings.clear();
+    for (const std::unique_ptr<IrPass>& pass : passes) {
+        const size_t before = function.size();
+        const auto start = std::chrono::steady_clock::now();
+        TRACE_SCOPE("pass", pass->name());
+        pass->run(function);
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        timings.push_back(Timing{pass->name(), elapsed.count(), before, function.size()});
+    }
+    function.renumber();
+}
+
+void PassManager::report_timings(std::ostream& os) const {
+    for (const Timing& timing : timings) {
+        os << std::format("{:<34}{:>10.1f} us{:>6} ->{:>6} instructions\n",
+            timing.pass, timing.microseconds,
+            timing.instructions_before, timing.instructions_after);
+    }
+}
+
+PassManager PassManager::standard(IrInterpreter& evaluator) {
+    PassManager manager;
+    manager.add(std::make_unique<ConstantPropagation>(evaluator));
+    manager.add(std::make_unique<CopyPropagation>());
+    manager.add(std::make_unique<CommonSubexpressionElimination>());
+    // Last, the others leave constants without users
+    manager.add(std::make_unique<DeadCodeElimination>());
+    return manager;
+}
@@ -0,0 +1,71 @@
+#ifndef IR_PASSES_H_INCLUDED
+#define IR_PASSES_H_INCLUDED
+
+#include <memory>
+#include "ir_interpreter.hpp"
+
+class IrPass {
+public:
+    virtual ~IrPass() = default;
+    virtual const char* name() const noexcept = 0;
+    virtual void run(IrFunction& function) noexcept = 0;
+};
+
+// Folds instructions whose operands are all constants, evaluated like they
+// would be at run time, and branches on constants, removing the blocks
+// that became unreachable
+// Anything that would report an error is left to report it at run time
+class ConstantPropagation: public IrPass {
+    IrInterpreter& evaluator;
+
+public:
+    ConstantPropagation(IrInterpreter& _evaluator): evaluator{_evaluator} {}
+    const char* name() const noexcept override { return "constant-propagation"; }
+    void run(IrFunction& function) noexcept override;
+};
+
+// Uses of copies, phis of a single value and assignments that convert
+// nothing are replaced by the value itself
+class CopyPropagation: public IrPass {
+public:
+    const char* name() const noexcept override { return "copy-propagation"; }
+    void run(IrFunction& function) noexcept override;
+};
+
+// Removes instructions without effects or users, unused variables among
+// them, an instruction that may fail still has to run
+class DeadCodeElimination: public IrPass {
+public:
+    const char* name() const noexcept override { return "dead-code-elimination"; }
+    void run(IrFunction& function) noexcept override;
+};
+
+// An instruction computing what a dominating one already did reuses it
+class CommonSubexpressionElimination: public IrPass {
+public:
+    const char* name() const noexcept override { return "common-subexpression-elimination"; }
+    void run(IrFunction& function) noexcept override;
+};
+
+class PassManager {
+    struct Timing {
+        const char* pass;
+        double microseconds;
+        size_t instructions_before;
+        size_t instructions_after;
+    };
+
+    std::vector<std::unique_ptr<IrPass>> passes{};
+    // Of the last run
+    std::vector<Timing> timings{};
+
+public:
+    void add(std::unique_ptr<IrPass> pass);
+    void run(IrFunction& function) noexcept;
+    void report_timings(std::ostream& os) const;
+
+    // Pipeline of --engine=ir
+    static PassManager standard(IrInterpreter& evaluator);
+};
+
+#endif
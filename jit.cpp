@@ -0,0 +1,474 @@
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <sys/mman.h>
+#include "jit.hpp"
+
+JitCompiler::~JitCompiler() {
+    for (const Region& region : regions)
+        munmap(region.base, region.size);
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+
+u8* JitCompiler::allocate(size_t size) noexcept {
+    if (regions.empty() || regions.back().size - regions.back().used < size) {
+        const size_t region_size = std::max(size, REGION_SIZE);
+        void* base = mmap(
+            nullptr, region_size, PROT_READ | PROT_EXEC,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+        );
+        if (base == MAP_FAILED)
+            return nullptr;
+        regions.push_back(Region{static_cast<u8*>(base), region_size, 0});
+    }
+    Region& region = regions.back();
+    u8* code = region.base + region.used;
+    region.used += size;
+    return code;
+}
+
+// ------------------------- Assembler -------------------------
+
+namespace {
+
+enum Reg : u8 {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+const char* const REGISTER_NAMES[] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+};
+
+const char* const BYTE_REGISTER_NAMES[] = {
+    "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+    "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b",
+};
+
+// Expression values by depth, all caller saved, rdi keeps the out pointer
+constexpr Reg REGISTERS[] = {RAX, RCX, RDX, RSI, R8, R9, R10, R11};
+constexpr size_t REGISTERS_COUNT = std::size(REGISTERS);
+
+// Low nibble of the jcc and setcc opcodes
+enum class Condition : u8 {
+    Overflow = 0x0,
+    NotEqual = 0x5,
+    Less = 0xC,
+    GreaterEqual = 0xD,
+    LessEqual = 0xE,
+    Greater = 0xF,
+};
+
+const char* condition_name(Condition cc) noexcept {
+    switch (cc) {
+        case Condition::Overflow: return "o";
+        case Condition::NotEqual: return "ne";
+        case Condition::Less: return "l";
+        case Condition::GreaterEqual: return "ge";
+        case Condition::LessEqual: return "le";
+        default: {}
+    }
+    return "g";
+}
+
+// Encodes the few instructions the generator needs, recording a line of
+// assembly for each one so --jit-dump needs no disassembler
+class Assembler {
+    std::vector<u8> code{};
+    std::vector<std::pair<size_t, std::string>> listing{};
+    // rel32 fields of the jumps to the bailout
+    std::vector<size_t> bailouts{};
+
+    void instruction(std::string text) {
+        listing.emplace_back(code.size(), std::move(text));
+    }
+
+    void byte(u8 b) { code.push_back(b); }
+
+    void imm32(u32 v) {
+        for (int i = 0; i < 4; i++)
+            byte(static_cast<u8>(v >> (8 * i)));
+    }
+
+    void imm64(u64 v) {
+        for (int i = 0; i < 8; i++)
+            byte(static_cast<u8>(v >> (8 * i)));
+    }
+
+    // 64-bit operand size with the high bits of both register fields
+    void rex_w(u8 reg, Reg rm) { byte(0x48 | ((reg >> 3) << 2) | (rm >> 3)); }
+
+    void modrm_direct(u8 reg, Reg rm) { byte(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+
+    // [base + disp32], base is never rsp or r12 which would need a SIB byte
+    void modrm_memory(u8 reg, Reg base, i32 disp) {
+        byte(0x80 | ((reg & 7) << 3) | (base & 7));
+        imm32(static_cast<u32>(disp));
+    }
+
+public:
+    inline const std::vector<u8>& bytes() const noexcept { return code; }
+
+    // op dst, src of the add, or, and, sub, xor, cmp and mov family
+    void alu(u8 opcode, const char* mnemonic, Reg dst, Reg src) {
+        instruction(std::format("{} {}, {}", mnemonic, REGISTER_NAMES[dst], REGISTER_NAMES[src]));
+        rex_w(src, dst);
+        byte(opcode);
+        modrm_direct(src, dst);
+    }
+
+    void mov(Reg dst, Reg src) { alu(0x89, "mov", dst, src); }
+    void add(Reg dst, Reg src) { alu(0x01, "add", dst, src); }
+    void sub(Reg dst, Reg src) { alu(0x29, "sub", dst, src); }
+    void and_(Reg dst, Reg src) { alu(0x21, "and", dst, src); }
+    void or_(Reg dst, Reg src) { alu(0x09, "or", dst, src); }
+    void xor_(Reg dst, Reg src) { alu(0x31, "xor", dst, src); }
+    void cmp(Reg dst, Reg src) { alu(0x39, "cmp", dst, src); }
+
+    void imul(Reg dst, Reg src) {
+        instruction(std::format("imul {}, {}", REGISTER_NAMES[dst], REGISTER_NAMES[src]));
+        rex_w(dst, src);
+        byte(0x0F);
+        byte(0xAF);
+        modrm_direct(dst, src);
+    }
+
+    void mov_imm(Reg dst, i64 imm) {
+        instruction(std::format("mov {}, {:#x}", REGISTER_NAMES[dst], static_cast<u64>(imm)));
+        rex_w(0, dst);
+        byte(0xB8 | (dst & 7));
+        imm64(static_cast<u64>(imm));
+    }
+
+    void load(Reg dst, Reg base, i32 disp) {
+        instruction(std::format("mov {}, qword [{} + {}]", REGISTER_NAMES[dst], REGISTER_NAMES[base], disp));
+        rex_w(dst, base);
+        byte(0x8B);
+        modrm_memory(dst, base, disp);
+    }
+
+    void store(Reg base, i32 disp, Reg src) {
+        instruction(std::format("mov qword [{} + {}], {}", REGISTER_NAMES[base], disp, REGISTER_NAMES[src]));
+        rex_w(src, base);
+        byte(0x89);
+        modrm_memory(src, base, disp);
+    }
+
+    void cmp_byte(Reg base, i32 disp, u8 imm) {
+        instruction(std::format("cmp byte [{} + {}], {}", REGISTER_NAMES[base], disp, imm));
+        if (base >= R8)
+            byte(0x41);
+        byte(0x80);
+        modrm_memory(7, base, disp);
+        byte(imm);
+    }
+
+    // shl is /4, sar is /7
+    void shift(u8 extension, const char* mnemonic, Reg dst, u8 count) {
+        instruction(std::format("{} {}, {}", mnemonic, REGISTER_NAMES[dst], count));
+        rex_w(0, dst);
+        byte(0xC1);
+        modrm_direct(extension, dst);
+        byte(count);
+    }
+
+    // not is /2, neg is /3
+    void unary(u8 extension, const char* mnemonic, Reg dst) {
+        instruction(std::format("{} {}", mnemonic, REGISTER_NAMES[dst]));
+        rex_w(0, dst);
+        byte(0xF7);
+        modrm_direct(extension, dst);
+    }
+
+    // dst = 1 when cc holds, 0 otherwise
+    void set(Condition cc, Reg dst) {
+        instruction(std::format("set{} {}", condition_name(cc), BYTE_REGISTER_NAMES[dst]));
+        // Plain REX so sil and dil are addressable
+        byte(0x40 | (dst >> 3));
+        byte(0x0F);
+        byte(0x90 | static_cast<u8>(cc));
+        modrm_direct(0, dst);
+        instruction(std::format("movzx {}, {}", REGISTER_NAMES[dst], BYTE_REGISTER_NAMES[dst]));
+        rex_w(dst, dst);
+        byte(0x0F);
+        byte(0xB6);
+        modrm_direct(dst, dst);
+    }
+
+    void bail_if(Condition cc) {
+        instruction(std::format("j{} bailout", condition_name(cc)));
+        byte(0x0F);
+        byte(0x80 | static_cast<u8>(cc));
+        bailouts.push_back(code.size());
+        imm32(0);
+    }
+
+    void return_status(bool status) {
+        instruction(std::format("mov eax, {}", static_cast<int>(status)));
+        byte(0xB8);
+        imm32(status);
+        instruction("ret");
+        byte(0xC3);
+    }
+
+    // Points every bail_if here
+    void bailout() {
+        for (size_t field : bailouts) {
+            const u32 rel = static_cast<u32>(code.size() - (field + 4));
+            std::memcpy(&code[field], &rel, sizeof(rel));
+        }
+        instruction("bailout:");
+        return_status(false);
+    }
+
+    void dump(std::ostream& os, const u8* address) const {
+        for (size_t i = 0; i < listing.size(); i++) {
+            const auto& [offset, text] = listing[i];
+            const size_t end = i + 1 < listing.size() ? listing[i + 1].first : code.size();
+            std::string hex;
+            for (size_t b = offset; b < end; b++)
+                hex += std::format("{:02x} ", code[b]);
+            os << std::format("  {:p}  {:<33}{}\n",
+                static_cast<const void*>(address + offset), hex, text);
+        }
+    }
+};
+
+// ------------------------- Code generation -------------------------
+
+// Offsets the generated code reads a variable through
+constexpr i32 TAG_OFFSET = offsetof(Slot, value) + offsetof(Value, tag);
+constexpr i32 INTEGER_OFFSET = offsetof(Slot, value) + offsetof(Value, integer);
+
+TreeBase* ungroup(TreeBase* tree) noexcept {
+    while (tree->kind == TreeKind::GroupedExpression)
+        tree = static_cast<GroupedExpression*>(tree)->grouped_expr;
+    return tree;
+}
+
+// Value of a non negative int literal, -1 for anything else
+i64 literal_count(TreeBase* tree) noexcept {
+    tree = ungroup(tree);
+    if (tree->kind != TreeKind::Literal)
+        return -1;
+    ObjectInteger* literal =
+        exact_cast<ObjectInteger>(static_cast<Literal*>(tree)->value_object);
+    return literal && literal->value >= 0 ? literal->value : -1;
+}
+
+// Values are computed into REGISTERS[depth], a tree needing more
+// registers than there are isn't compiled
+class Generator {
+    Assembler& as;
+    const JitCompiler::Resolver& resolve;
+
+    bool name(Name* tree, Reg dst) {
+        Slot** cell = resolve(tree->name_str);
+        if (!cell)
+            return false;
+        as.mov_imm(dst, reinterpret_cast<i64>(cell));
+        as.load(dst, dst, 0);
+        // A big integer is boxed, the interpreter takes over
+        as.cmp_byte(dst, TAG_OFFSET, static_cast<u8>(ValueTag::INTEGER));
+        as.bail_if(Condition::NotEqual);
+        as.load(dst, dst, INTEGER_OFFSET);
+        return true;
+    }
+
+    bool unary(Unary* tree, size_t depth) {
+        if (tree->operands != Operands::Integers || !integer(tree->expr, depth))
+            return false;
+        const Reg dst = REGISTERS[depth];
+        switch (tree->unary_op.ttype) {
+            case TokenType::PLUS:
+                return true;
+            case TokenType::MINUS:
+                // Negating INT64_MIN overflows
+                as.unary(3, "neg", dst);
+                as.bail_if(Condition::Overflow);
+                return true;
+            case TokenType::TILDE:
+                as.unary(2, "not", dst);
+                return true;
+            default: {}
+        }
+        return false;
+    }
+
+    bool shift(Binary* tree, size_t depth) {
+        // Only constant counts, variable ones would have to go through cl
+        const i64 count = literal_count(tree->right);
+        if (count < 0 || !integer(tree->left, depth))
+            return false;
+        const Reg dst = REGISTERS[depth];
+        if (tree->op.ttype == TokenType::RIGHT_SHIFT) {
+            as.shift(7, "sar", dst, static_cast<u8>(std::min<i64>(count, 63)));
+            return true;
+        }
+        if (count >= 64 || depth + 1 >= REGISTERS_COUNT)
+            return false;
+        if (count == 0)
+            return true;
+        // Bits shifted out need a big integer
+        const Reg scratch = REGISTERS[depth + 1];
+        as.mov(scratch, dst);
+        as.shift(4, "shl", scratch, static_cast<u8>(count));
+        as.shift(7, "sar", scratch, static_cast<u8>(count));
+        as.cmp(scratch, dst);
+        as.bail_if(Condition::NotEqual);
+        as.shift(4, "shl", dst, static_cast<u8>(count));
+        return true;
+    }
+
+    bool binary(Binary* tree, size_t depth) {
+        if (tree->operands != Operands::Integers)
+            return false;
+        switch (tree->op.ttype) {
+            case TokenType::LEFT_SHIFT:
+            case TokenType::RIGHT_SHIFT:
+                return shift(tree, depth);
+            case TokenType::PLUS:
+            case TokenType::MINUS:
+            case TokenType::STAR:
+            case TokenType::BITWISE_AND:
+            case TokenType::BITWISE_OR:
+            case TokenType::BITWISE_XOR:
+                break;
+            default:
+                return false;
+        }
+        if (depth + 1 >= REGISTERS_COUNT)
+            return false;
+        if (!integer(tree->left, depth) || !integer(tree->right, depth + 1))
+            return false;
+        const Reg dst = REGISTERS[depth];
+        const Reg src = REGISTERS[depth + 1];
+        switch (tree->op.ttype) {
+            case TokenType::PLUS:
+                as.add(dst, src);
+                as.bail_if(Condition::Overflow);
+                break;
+            case TokenType::MINUS:
+                as.sub(dst, src);
+                as.bail_if(Condition::Overflow);
+                break;
+            case TokenType::STAR:
+                as.imul(dst, src);
+                as.bail_if(Condition::Overflow);
+                break;
+            case TokenType::BITWISE_AND:
+                as.and_(dst, src);
+                break;
+            case TokenType::BITWISE_OR:
+                as.or_(dst, src);
+                break;
+            default:
+                as.xor_(dst, src);
+        }
+        return true;
+    }
+
+    // An int valued tree into REGISTERS[depth]
+    bool integer(TreeBase* tree, size_t depth) {
+        tree = ungroup(tree);
+        switch (tree->kind) {
+            case TreeKind::Literal: {
+                ObjectInteger* literal =
+                    exact_cast<ObjectInteger>(static_cast<Literal*>(tree)->value_object);
+                if (!literal)
+                    return false;
+                as.mov_imm(REGISTERS[depth], literal->value);
+                return true;
+            }
+            case TreeKind::Name:
+                return name(static_cast<Name*>(tree), REGISTERS[depth]);
+            case TreeKind::Unary:
+                return unary(static_cast<Unary*>(tree), depth);
+            case TreeKind::Term:
+            case TreeKind::Factor:
+            case TreeKind::Shift:
+            case TreeKind::Bitwise:
+                return binary(static_cast<Binary*>(tree), depth);
+            default: {}
+        }
+        return false;
+    }
+
+    bool comparison(Comparison* tree) {
+        if (tree->operands != Operands::Integers)
+            return false;
+        if (!integer(tree->left, 0) || !integer(tree->right, 1))
+            return false;
+        Condition cc;
+        switch (tree->op.ttype) {
+            case TokenType::GREATER: cc = Condition::Greater; break;
+            case TokenType::GREATER_EQUAL: cc = Condition::GreaterEqual; break;
+            case TokenType::LESS: cc = Condition::Less; break;
+            default: cc = Condition::LessEqual;
+        }
+        as.cmp(REGISTERS[0], REGISTERS[1]);
+        as.set(cc, REGISTERS[0]);
+        return true;
+    }
+
+public:
+    Generator(Assembler& _as, const JitCompiler::Resolver& _resolve):
+        as{_as}, resolve{_resolve} {}
+
+    // bool function(i64* out), out in rdi
+    bool function(TreeBase* tree) {
+        tree = ungroup(tree);
+        // Lone names and literals gain nothing from native code
+        if (tree->kind == TreeKind::Name || tree->kind == TreeKind::Literal)
+            return false;
+        if (tree->kind == TreeKind::Comparison) {
+            if (!comparison(static_cast<Comparison*>(tree)))
+                return false;
+        } else if (!integer(tree, 0)) {
+            return false;
+        }
+        as.store(RDI, 0, REGISTERS[0]);
+        as.return_status(true);
+        as.bailout();
+        return true;
+    }
+};
+
+} // namespace
+
+JitCompiler::Function JitCompiler::compile(TreeBase* tree, const Resolver& resolve) {
+    Assembler as;
+    if (!Generator{as, resolve}.function(tree))
+        return nullptr;
+    const std::vector<u8>& bytes = as.bytes();
+    u8* code = allocate(bytes.size());
+    if (!code)
+        return nullptr;
+    // Never writable and executable at once
+    Region& region = regions.back();
+    if (mprotect(region.base, region.size, PROT_READ | PROT_WRITE) != 0)
+        return nullptr;
+    std::memcpy(code, bytes.data(), bytes.size());
+    if (mprotect(region.base, region.size, PROT_READ | PROT_EXEC) != 0)
+        return nullptr;
+    if (dump) {
+        std::cerr << std::format("jit: {} ({} bytes)\n", tree->to_string(), bytes.size());
+        as.dump(std::cerr, code);
+    }
+    return reinterpret_cast<Function>(code);
+}
+
+#else
+
+u8* JitCompiler::allocate(size_t) noexcept {
+    return nullptr;
+}
+
+JitCompiler::Function JitCompiler::compile(TreeBase*, const Resolver&) {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef JIT_H_INCLUDED
+#define JIT_H_INCLUDED
+
+#include <functional>
+#include "environment.hpp"
+#include "syntax_tree.hpp"
+
+// Native code for int expression trees on Linux x86-64, used by the
+// closure engine for Term, Factor, Shift, Bitwise, Comparison, Unary,
+// Name and Literal nodes the TypeChecker proved to have int operands
+// Floats are long double and stay on the closure path
+// Other platforms get no code, compile() returns nullptr
+class JitCompiler {
+public:
+    // Stores the value in out, false whenever the interpreter is needed
+    // instead (overflow, a variable holding a big integer)
+    using Function = bool (*)(i64* out);
+    // Cell of the variable a name refers to, nullptr if unknown
+    using Resolver = std::function<Slot**(const std::string& name)>;
+
+private:
+    // Executable memory, only writable while code is being copied in
+    struct Region {
+        u8* base;
+        size_t size;
+        size_t used;
+    };
+    static constexpr size_t REGION_SIZE = 1 << 16;
+
+    std::vector<Region> regions{};
+    bool dump;
+
+    u8* allocate(size_t size) noexcept;
+
+public:
+    explicit JitCompiler(bool dump_code = false): dump{dump_code} {}
+    ~JitCompiler();
+
+    JitCompiler(const JitCompiler&) = delete; // No copy constructor
+    JitCompiler& operator=(const JitCompiler&) = delete; // No copy assignment
+
+    // nullptr when tree uses anything the JIT doesn't handle
+    // Comparisons produce 0 or 1
+    Function compile(TreeBase* tree, const Resolver& resolve);
+};
+
+#endif
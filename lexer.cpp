@@ -3,13 +3,23 @@
 
 void Lexer::init(char* in, const size_t& source_len) {
     errors = 0;
+    if (!source.empty())
+        MemoryStats::freed(MemoryStats::LEXER_SOURCE, source.capacity() + 1);
     source.assign(in, source_len);
     if (source.back() != '\n')
         source.push_back('\n');
+    MemoryStats::allocated(MemoryStats::LEXER_SOURCE, source.capacity() + 1);
     current = source.begin();
     lines.push_back(std::string{});
 }
 
+Lexer::~Lexer() {
+    if (!source.empty())
+        MemoryStats::freed(MemoryStats::LEXER_SOURCE, source.capacity() + 1);
+    if (line_bytes)
+        MemoryStats::freed(MemoryStats::LEXER_LINE, line_bytes);
+}
+
 static bool is_valid_first_char(char c) {
     return (
         std::isalpha(c) || c == '\n' ||
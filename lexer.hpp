@@ -1,12 +1,21 @@
 #ifndef LEXER_H_INCLUDED
 #define LEXER_H_INCLUDED
 
+#include "memory_stats.hpp"
 #include "token.hpp"
 
 class Lexer {
     std::string source;
     std::string::const_iterator current;
     size_t col = 0;
+    // Of the lines kept, for MemoryStats
+    u64 line_bytes = 0;
+
+    inline void count_line() noexcept {
+        const u64 bytes = lines.back().capacity() + 1;
+        line_bytes += bytes;
+        MemoryStats::allocated(MemoryStats::LEXER_LINE, bytes);
+    }
 
     inline void skip_whitespaces() {
         while (!is_at_end() && std::isspace(*current)) {
@@ -25,6 +34,7 @@ class Lexer {
             lines.back().assign(
                 source.substr(last_line_break_in_input)
             );
+            count_line();
         } else if (lines.back().empty()) {
             std::string::size_type cur_pos =
                 std::distance(source.cbegin(), current);
@@ -42,6 +52,7 @@ class Lexer {
             lines.back().assign(
                 source.substr(begin, length)
             );
+            count_line();
         }
     }
 
@@ -52,6 +63,13 @@ class Lexer {
 
 public:
     std::vector<std::string> lines;
+    // Where lexing errors are reported
+    std::ostream* diagnostics = &std::cerr;
+
+    Lexer() = default;
+    ~Lexer();
+    Lexer(const Lexer&) = delete; // No copy constructor
+    Lexer& operator=(const Lexer&) = delete; // No copy assignment
 
     void init(char* in, const size_t& source_len);
     Token generate_next_token();
@@ -66,10 +84,10 @@ public:
         const std::string& post_msg
     ) {
         errors += 1;
-        std::cerr << "Error in line " << lines.size() << ":\n" ;
-        std::cerr << error_msg << '\n';
-        std::cerr << lines.back() << '\n' ;
-        std::cerr << post_msg << '\n' ;
+        *diagnostics << "Error in line " << lines.size() << ":\n" ;
+        *diagnostics << error_msg << '\n';
+        *diagnostics << lines.back() << '\n' ;
+        *diagnostics << post_msg << '\n' ;
     }
 };
 
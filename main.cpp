@@ -1,42 +1,297 @@
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <readline/history.h>
 #include <readline/readline.h>
 
+#include "closure_compiler.hpp"
 #include "common.hpp"
+#include "counters.hpp"
+#include "cpp_emitter.hpp"
 #include "interpreter.hpp"
+#include "ir_passes.hpp"
+#include "jit.hpp"
+#include "memory_stats.hpp"
 #include "object.hpp"
 #include "parser.hpp"
+#include "sampler.hpp"
+#include "simplifier.hpp"
+#include "trace.hpp"
+#include "type_checker.hpp"
 
 using namespace std;
 
+// false unless arg is option followed by a count above 0
+static bool parse_limit(const char* arg, const char* option, u64& out) {
+    const size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0)
+        return false;
+    out = std::strtoull(arg + length, nullptr, 10);
+    return out > 0;
+}
+
 int main(int argc, char* argv[]) {
+    // All program output goes through the interpreter's sink
+    std::ios::sync_with_stdio(false);
     // Placeholder code: read it print it
     Parser parser;
     Interpreter interpreter;
+    TypeChecker checker{interpreter.environment()};
+    Simplifier simplifier;
+    ClosureCompiler closures{interpreter};
+    IrInterpreter ir{interpreter};
+    PassManager passes = PassManager::standard(ir);
     InterpreterResult eval;
     ParseResult result;
-    if (argc == 1) {
+    // Non zero when the program could not be translated
+    int status = 0;
+    // Command-line options
+    const char* path = nullptr;
+    bool show_stats = false;
+    // Allocations by category
+    bool show_memory = false;
+    bool use_closures = false;
+    bool use_tree = false;
+    bool use_ir = false;
+    bool dump_ir = false;
+    bool use_jit = false;
+    bool dump_jit = false;
+    // Ahead of time compilation instead of running the program
+    const char* emit_path = nullptr;
+    const char* aot_path = nullptr;
+    // Phase timings
+    const char* trace_path = nullptr;
+    bool trace_statements = false;
+    bool show_time = false;
+    // Hardware events per phase, printed with the phase timings
+    bool show_counters = false;
+    // Per node profile of the tree engine
+    bool profile = false;
+    const char* folded_path = nullptr;
+    // Microseconds of cpu time between samples, 0 when not sampling
+    u64 sample_interval = 0;
+    // Of each run, none by default
+    Budget::Limits limits;
+    bool valid_arguments = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--file") == 0 || strcmp(argv[i], "-f") == 0) {
+            if (path || i + 1 == argc)
+                valid_arguments = false;
+            else
+                path = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            show_stats = true;
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            show_memory = true;
+        } else if (strcmp(argv[i], "--engine=closure") == 0) {
+            use_closures = true;
+            use_tree = use_ir = false;
+        } else if (strcmp(argv[i], "--engine=tree") == 0) {
+            use_closures = use_ir = false;
+            use_tree = true;
+        } else if (strcmp(argv[i], "--engine=ir") == 0) {
+            use_ir = true;
+            use_closures = use_tree = false;
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            use_ir = dump_ir = true;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            use_jit = true;
+        } else if (strcmp(argv[i], "--jit-dump") == 0) {
+            use_jit = dump_jit = true;
+        } else if (strncmp(argv[i], "--emit-cpp=", 11) == 0) {
+            emit_path = argv[i] + 11;
+        } else if (strncmp(argv[i], "--aot=", 6) == 0) {
+            aot_path = argv[i] + 6;
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_path = argv[i] + 8;
+        } else if (strcmp(argv[i], "--trace-statements") == 0) {
+            trace_statements = true;
+        } else if (strcmp(argv[i], "--time") == 0) {
+            show_time = true;
+        } else if (strcmp(argv[i], "--counters") == 0) {
+            show_counters = true;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strncmp(argv[i], "--profile-folded=", 17) == 0) {
+            profile = true;
+            folded_path = argv[i] + 17;
+        } else if (strcmp(argv[i], "--sample") == 0) {
+            sample_interval = 1000;
+        } else if (strncmp(argv[i], "--sample=", 9) == 0) {
+            sample_interval = std::strtoull(argv[i] + 9, nullptr, 10);
+            if (sample_interval == 0)
+                valid_arguments = false;
+        } else if (
+            parse_limit(argv[i], "--max-steps=", limits.max_steps) ||
+            parse_limit(argv[i], "--timeout-ms=", limits.timeout_ms) ||
+            parse_limit(argv[i], "--max-heap=", limits.max_heap)
+        ) {
+            continue;
+        } else {
+            valid_arguments = false;
+        }
+    }
+    if ((emit_path || aot_path) && !path)
+        valid_arguments = false;
+    if (trace_statements && !trace_path)
+        valid_arguments = false;
+    // The JIT only plugs into the closure engine
+    if (use_jit && (use_tree || use_ir))
+        valid_arguments = false;
+    // Only the tree engine runs nodes one by one
+    if ((profile || sample_interval) && (use_closures || use_ir || use_jit))
+        valid_arguments = false;
+    if (!valid_arguments) {
+        // Print help on how to use
+        cerr << "Invalid command-line arguments\n" ;
+        cerr << "Usage:\n" ;
+        cerr << "   ./main [options]\n" ;
+        cerr << "   ./main [options] (--file/-f) path\n" ;
+        cerr << "Options:\n" ;
+        cerr << "   --stats                   print runtime counters on exit\n" ;
+        cerr << "   --mem-stats               print allocations, their bytes and peak per syntax\n" ;
+        cerr << "                             tree node, object kind, environment and lexer on exit\n" ;
+        cerr << "   --engine=(tree|closure|ir) evaluate the syntax tree, compiled closures\n" ;
+        cerr << "                             or the optimized SSA form\n" ;
+        cerr << "   --dump-ir                 like --engine=ir, also prints the IR and pass timings\n" ;
+        cerr << "   --jit                     native code for int expressions, implies --engine=closure\n" ;
+        cerr << "   --jit-dump                like --jit, also prints the emitted code\n" ;
+        cerr << "   --emit-cpp=out.cpp        translate the file to C++ instead of running it\n" ;
+        cerr << "   --aot=out                 compile the file to an executable with g++ -O2\n" ;
+        cerr << "   --trace=out.json          write phase timings as Chrome trace events\n" ;
+        cerr << "   --trace-statements        with --trace, also an event per top-level statement\n" ;
+        cerr << "   --time                    print phase timings on exit\n" ;
+        cerr << "   --counters                like --time, also cycles, instructions, branch and\n" ;
+        cerr << "                             cache misses of each phase where the kernel allows\n" ;
+        cerr << "   --profile                 print executions and time per line and node kind,\n" ;
+        cerr << "                             tree engine only\n" ;
+        cerr << "   --profile-folded=out      like --profile, also writes folded stacks for flamegraphs\n" ;
+        cerr << "   --sample[=us]             sample the running line and node kind every 1000 us\n" ;
+        cerr << "                             of cpu time or the given interval, tree engine only\n" ;
+        cerr << "   --max-steps=N             stop a run after N nodes, statements or instructions\n" ;
+        cerr << "   --timeout-ms=N            stop a run after N milliseconds\n" ;
+        cerr << "   --max-heap=N              stop a run once trees and objects take N bytes\n" ;
+        return 0;
+    }
+#ifdef NO_TRACING
+    if (trace_path || show_time || show_counters) {
+        cerr << "Built with NO_TRACING, --trace, --time and --counters are unavailable\n" ;
+        return 1;
+    }
+#endif
+    // The heap limit takes the syntax trees parsed into account
+    if (show_memory || limits.max_heap)
+        MemoryStats::enable();
+    show_time = show_time || show_counters;
+    if (trace_path || show_time)
+        Tracer::get()->enable(trace_statements);
+    std::unique_ptr<PerfCounters> counters;
+    if (show_counters) {
+        counters = std::make_unique<PerfCounters>();
+        if (!counters->error().empty())
+            cerr << std::format("Counters unavailable: {}\n", counters->error());
+        if (counters->available())
+            Tracer::get()->use_counters(counters.get());
+    }
+    Profiler profiler;
+    if (profile)
+        interpreter.use_profiler(&profiler);
+    if (sample_interval && !Sampler::start(sample_interval)) {
+        cerr << "Can not start the sampling timer\n" ;
+        sample_interval = 0;
+    }
+    JitCompiler jit{dump_jit};
+    if (use_jit) {
+        use_closures = true;
+        closures.use_jit(&jit);
+    }
+    // Runs a type checked tree on the selected engine, the heap limit
+    // counts what was allocated since heap_base was live
+    auto execute = [&](TreeBase* tree, u64 heap_base) {
+        Budget& budget = interpreter.budget();
+        budget.start(limits, heap_base);
+        // The tree may already be over the heap limit
+        if (!budget.check_heap())
+            return InterpreterResult::Error(budget.error());
+        {
+            TRACE_SCOPE("phase", "simplify");
+            simplifier.run(tree);
+        }
+        if (use_ir) {
+            IrFunction function;
+            {
+                TRACE_SCOPE("phase", "lower");
+                IrBuilder{interpreter.environment(), interpreter.interactive()}.build(tree, function);
+            }
+            if (dump_ir) {
+                cerr << "; lowered\n" ;
+                function.dump(cerr);
+            }
+            passes.run(function);
+            if (dump_ir) {
+                cerr << "; optimized\n" ;
+                function.dump(cerr);
+                passes.report_timings(cerr);
+            }
+            TRACE_SCOPE("phase", "evaluate");
+            return ir.run(function);
+        }
+        if (use_closures) {
+            ClosureCompiler::Closure program;
+            {
+                TRACE_SCOPE("phase", "compile");
+                program = closures.compile(tree);
+            }
+            TRACE_SCOPE("phase", "evaluate");
+            return closures.run(program);
+        }
+        TRACE_SCOPE("phase", "evaluate");
+        return interpreter.interpret(tree);
+    };
+    // Parses and type checks, the checker counts its errors
+    // The lexer runs token by token inside the parser, parse includes it
+    auto parse = [&]() {
+        TRACE_SCOPE("phase", "parse");
+        return parser.parse_source();
+    };
+    auto check = [&](TreeBase* tree) {
+        TRACE_SCOPE("phase", "typecheck");
+        return checker.check(tree);
+    };
+    if (!path) {
         // Interactive Mode
         // Read input from user directly
-        *Common::get_mode() = Mode::Interactive;
-        Common::get_filename()->assign("stdin");
+        parser.set_mode(Mode::Interactive);
+        parser.set_source_name("stdin");
+        interpreter.set_mode(Mode::Interactive);
         // Line characters store
         char* buffer;
         Object* value;
-        while ((buffer = readline("> ")) != nullptr) {
+        OutputSink& out = interpreter.output();
+        while (true) {
+            // Show everything before prompting again
+            out.flush();
+            if ((buffer = readline("> ")) == nullptr)
+                break;
             if (strlen(buffer) == 0) continue; // Ignore empty lines
             // add last read line to prompt history
             add_history(buffer);
+            const u64 heap_base = MemoryStats::total().live;
             parser.init(buffer, strlen(buffer));
-            result = parser.parse_source();
+            result = parse();
             if (result.is_ok()) {
                 TreeBase* source_tree = result.unwrap();
-                if (source_tree) {
-                    eval = interpreter.interpret(source_tree);
+                if (source_tree && check(source_tree) != 0) {
+                    // Nothing runs when types don't check
+                    cerr << checker.errors() << " type errors found\n" ;
+                } else if (source_tree) {
+                    eval = execute(source_tree, heap_base);
                     if (eval.is_ok()) {
                         value = eval.unwrap();
-                        if (value) cout << value << '\n' ;
+                        if (value) {
+                            value->format_to(out);
+                            out.write('\n');
+                        }
                     } else if (eval.is_error()) {
                         // Runtime error
                         cerr << eval.unwrap_error() << "\n" ;
@@ -50,44 +305,74 @@ int main(int argc, char* argv[]) {
             // free buffer because readline always allocates a new buffer
             free(buffer);
         }
-    } else if (argc == 3 && (strcmp(argv[1], "--file") == 0 || strcmp(argv[1], "-f") == 0)) {
+    } else {
         // File Mode
         // Read input from file
-        *Common::get_mode() = Mode::File;
-        std::string filename{argv[2]};
+        std::string filename{path};
         std::string::size_type pos =
             filename.find_last_of('/');
         if (pos == std::string::npos)
             pos = 0;
         else
             pos++;
-        Common::get_filename()->assign(
-            filename.substr(pos)
-        );
+        parser.set_source_name(filename.substr(pos));
         // Open requested file for reading
-        ifstream input_file {argv[2]};
+        ifstream input_file {path};
         // Seek to fil end
         input_file.seekg(0, std::ios::end);
         // Read total file size
         u64 file_size = input_file.tellg();
         // Allocate enough space to hold file contents
         char* input = new char[file_size + 1];
+        MemoryStats::allocated(MemoryStats::LEXER_SOURCE, file_size + 1);
         // Seek back to beginning of file to start contents copy
         input_file.seekg(0, std::ios::beg);
         // Read all characters
         input_file.read(input, file_size);
         input[file_size] = '\0';
+        const u64 heap_base = MemoryStats::total().live;
         parser.init(input, file_size);
-        result = parser.parse_source();
+        result = parse();
         if (result.is_ok()) {
             TreeBase* source_tree = result.unwrap();
-            if (source_tree) {
-                eval = interpreter.interpret(source_tree);
+            if (source_tree && check(source_tree) != 0) {
+                // Reported before any statement runs
+                cerr << checker.errors() << " type errors found\n" ;
+            } else if (source_tree && (emit_path || aot_path)) {
+                // Translated, not run
+                {
+                    TRACE_SCOPE("phase", "simplify");
+                    simplifier.run(source_tree);
+                }
+                std::string source = emit_path ? emit_path : std::string{aot_path} + ".cpp";
+                bool written;
+                {
+                    TRACE_SCOPE("phase", "emit");
+                    ofstream source_file{source};
+                    source_file << CppEmitter{}.emit(source_tree);
+                    source_file.close();
+                    written = !source_file.fail();
+                }
+                if (!written) {
+                    cerr << std::format("Can not write the generated C++ to {}\n", source);
+                    status = 1;
+                } else if (aot_path) {
+                    TRACE_SCOPE("phase", "build");
+                    BuildResult built = CppEmitter::build(source, aot_path);
+                    if (built.is_error()) {
+                        cerr << built.unwrap_error() << '\n' ;
+                        status = 1;
+                    }
+                }
+            } else if (source_tree) {
+                eval = execute(source_tree, heap_base);
                 if (eval.is_error()) {
                     // Runtime error
                     cerr << eval.unwrap_error() << '\n' ;
                 }
             }
+            // End of program
+            interpreter.output().flush();
         } else {
             // Syntax error
             parser.report_error(result.unwrap_error());
@@ -95,12 +380,39 @@ int main(int argc, char* argv[]) {
         }
         // Free input buffer
         delete[] input;
-    } else {
-        // Print help on how to use
-        cerr << "Invalid command-line arguments\n" ;
-        cerr << "Usage:\n" ;
-        cerr << "   ./main\n" ;
-        cerr << "   ./main (--file/-f) path\n" ;
+        MemoryStats::freed(MemoryStats::LEXER_SOURCE, file_size + 1);
+    }
+    if (show_stats) {
+        interpreter.report_statistics(cerr);
+        simplifier.report_statistics(cerr);
+    }
+    if (show_time || profile || sample_interval || show_memory) {
+        // Apart from whatever the program printed last
+        cout << std::flush;
+        cerr << '\n' ;
+    }
+    if (show_memory)
+        MemoryStats::report(cerr);
+    if (show_time)
+        Tracer::get()->report_summary(cerr);
+    if (sample_interval) {
+        Sampler::stop();
+        Sampler::report(cerr, 40);
+    }
+    if (profile) {
+        profiler.report(cerr, 40);
+        if (folded_path) {
+            ofstream folded_file{folded_path};
+            profiler.write_folded(folded_file);
+            if (!folded_file)
+                cerr << std::format("Can not write the folded stacks to {}\n", folded_path);
+        }
+    }
+    if (trace_path) {
+        ofstream trace_file{trace_path};
+        Tracer::get()->write_chrome_trace(trace_file);
+        if (!trace_file)
+            cerr << std::format("Can not write the trace to {}\n", trace_path);
     }
-    return 0;
+    return status;
 }
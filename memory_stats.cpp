@@ -0,0 +1,58 @@
+#include "memory_stats.hpp"
+#include "syntax_tree.hpp"
+
+const char* MemoryStats::name(Category category) noexcept {
+    static const char* NAMES[CATEGORIES - TREE_KINDS] = {
+        "object/int",
+        "object/float",
+        "object/big int",
+        "object/string",
+        "object/boolean",
+        "object/void",
+        "object/string chars",
+        "object/big int limbs",
+        "environment/table",
+        "environment/slot",
+        "lexer/source",
+        "lexer/line",
+    };
+    if (category < TREE + TREE_KINDS)
+        return tree_kind_name(static_cast<TreeKind>(category - TREE));
+    return NAMES[category - TREE_KINDS];
+}
+
+void* MemoryStats::allocate(Category category, size_t size) {
+    allocated(category, size);
+    return ::operator new(size);
+}
+
+void MemoryStats::deallocate(Category category, void* pointer, size_t size) noexcept {
+    freed(category, size);
+    ::operator delete(pointer);
+}
+
+void MemoryStats::report(std::ostream& os) {
+    std::vector<Category> used;
+    for (u8 i = 0; i < CATEGORIES; i++) {
+        if (entries[i].count)
+            used.push_back(static_cast<Category>(i));
+    }
+    std::ranges::stable_sort(used, [](Category a, Category b) {
+        return entries[a].bytes > entries[b].bytes;
+    });
+    os << std::format(
+        "{:<24}{:>12}{:>14}{:>12}{:>14}{:>14}\n",
+        "allocations", "count", "bytes", "freed", "live bytes", "peak bytes"
+    );
+    auto row = [&](const std::string& label, const Entry& entry) {
+        os << std::format(
+            "{:<24}{:>12}{:>14}{:>12}{:>14}{:>14}\n",
+            label, entry.count, entry.bytes, entry.frees, entry.live, entry.peak
+        );
+    };
+    for (Category category : used) {
+        const bool tree = category < TREE + TREE_KINDS;
+        row(tree ? std::format("tree/{}", name(category)) : name(category), entries[category]);
+    }
+    row("total", all);
+}
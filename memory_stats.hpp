@@ -0,0 +1,111 @@
+#ifndef MEMORY_STATS_H_INCLUDED
+#define MEMORY_STATS_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include "common.hpp"
+
+// Allocation accounting for --mem-stats, nothing is counted until enable()
+// Syntax tree nodes and objects are counted by the class specific
+// operator new of each class, so only heap instances are, bytes are the
+// size of the instance
+// The characters of strings and the limbs of big integers, scope tables
+// and their slots, and the lexer's copies of the source, are counted
+// where they are made
+// Counts are kept per thread, a run sees only what its own thread
+// allocated and threads never contend on them
+class MemoryStats {
+public:
+    // Must match TreeKind, checked in syntax_tree.cpp
+    static constexpr u8 TREE_KINDS = 19;
+
+    enum Category : u8 {
+        // One per TreeKind, TREE + kind
+        TREE = 0,
+        OBJECT_INTEGER = TREE + TREE_KINDS,
+        OBJECT_FLOAT,
+        OBJECT_BIG_INTEGER,
+        OBJECT_STRING,
+        OBJECT_BOOLEAN,
+        OBJECT_VOID,
+        // Out of line characters and limbs of those objects
+        STRING_CHARACTERS,
+        BIG_INTEGER_LIMBS,
+        ENVIRONMENT_TABLE,
+        // Estimated, a map node holding the name and slot
+        ENVIRONMENT_SLOT,
+        LEXER_SOURCE,
+        LEXER_LINE,
+        CATEGORIES,
+    };
+
+    // Zeroed as statics are
+    struct Entry {
+        u64 count;
+        u64 bytes;
+        u64 frees;
+        u64 live;
+        u64 peak;
+    };
+
+private:
+    static inline std::atomic<bool> on{false};
+    static inline thread_local Entry entries[CATEGORIES];
+    // Over every category
+    static inline thread_local Entry all;
+
+    static inline void add(Entry& entry, u64 bytes) noexcept {
+        entry.count++;
+        entry.bytes += bytes;
+        entry.live += bytes;
+        entry.peak = std::max(entry.peak, entry.live);
+    }
+
+    // Freeing what was made before enable() never goes below zero
+    static inline void remove(Entry& entry, u64 bytes) noexcept {
+        entry.frees++;
+        entry.live -= std::min(entry.live, bytes);
+    }
+
+public:
+    static inline void enable() noexcept { on.store(true, std::memory_order_relaxed); }
+    static inline bool enabled() noexcept { return on.load(std::memory_order_relaxed); }
+
+    static inline void allocated(Category category, u64 bytes) noexcept {
+        if (!enabled()) return;
+        add(entries[category], bytes);
+        add(all, bytes);
+    }
+
+    static inline void freed(Category category, u64 bytes) noexcept {
+        if (!enabled()) return;
+        remove(entries[category], bytes);
+        remove(all, bytes);
+    }
+
+    // Behind ACCOUNTED_ALLOCATION, out of line so that GCC does not pair
+    // the global operator new it would inline with the class delete
+    static void* allocate(Category category, size_t size);
+    static void deallocate(Category category, void* pointer, size_t size) noexcept;
+
+    static inline const Entry& entry(Category category) noexcept { return entries[category]; }
+    static inline const Entry& total() noexcept { return all; }
+    static const char* name(Category category) noexcept;
+
+    // Categories with allocations by this thread, the most bytes first
+    static void report(std::ostream& os);
+};
+
+// Class specific allocation functions counting instances under category,
+// placement new is declared again as these hide the global one
+#define ACCOUNTED_ALLOCATION(category) \
+    static inline void* operator new(size_t size) { \
+        return MemoryStats::allocate(category, size); \
+    } \
+    static inline void* operator new(size_t, void* place) noexcept { return place; } \
+    static inline void operator delete(void* pointer, size_t size) noexcept { \
+        MemoryStats::deallocate(category, pointer, size); \
+    }
+
+#endif
@@ -1,6 +1,15 @@
+#include <charconv>
 #include <cmath>
-#include <iomanip>
 #include "object.hpp"
+#include "output.hpp"
+
+// ------------------------- Object -------------------------
+
+void Object::format_to(OutputSink& sink) const noexcept {
+    sink.write(to_string());
+}
+
+// ------------------------- Object -------------------------
 
 // ------------------------- ObjectInteger -------------------------
 
@@ -8,122 +17,222 @@ std::string ObjectInteger::to_string() const noexcept {
     return std::to_string(value);
 }
 
-ObjectInteger* ObjectInteger::operator-() const noexcept {
-    return new ObjectInteger{-value};
+void ObjectInteger::format_to(OutputSink& sink) const noexcept {
+    sink.write_integer(value);
 }
 
-ObjectInteger* ObjectInteger::operator*(const ObjectInteger* other) const noexcept {
-    return new ObjectInteger{value * other->value};
+Object* ObjectInteger::operator-() const noexcept {
+    if (value == INT64_MIN) [[unlikely]]
+        return ObjectBigInteger::from(-BigInteger{value});
+    return ObjectInteger::make(-value);
+}
+
+Object* ObjectInteger::operator*(const ObjectInteger* other) const noexcept {
+    i64 result;
+    if (__builtin_mul_overflow(value, other->value, &result)) [[unlikely]]
+        return ObjectBigInteger::from(BigInteger{value} * BigInteger{other->value});
+    return ObjectInteger::make(result);
 }
 
 ObjectFloat* ObjectInteger::operator*(const ObjectFloat* other) const noexcept {
-    return new ObjectFloat{
+    return ObjectFloat::make(
         static_cast<float64>(value) * other->value
-    };
+    );
 }
 
 ObjectInteger* ObjectInteger::operator%(const ObjectInteger* other) const noexcept {
     if (!other->value) return nullptr;
-    return new ObjectInteger {value % other->value};
+    // INT64_MIN % -1 traps on some targets
+    if (other->value == -1) return ObjectInteger::make(0);
+    return ObjectInteger::make(value % other->value);
 }
 
-ObjectInteger* ObjectInteger::operator+(const ObjectInteger* other) const noexcept {
-    return new ObjectInteger {value + other->value};
+Object* ObjectInteger::operator+(const ObjectInteger* other) const noexcept {
+    i64 result;
+    if (__builtin_add_overflow(value, other->value, &result)) [[unlikely]]
+        return ObjectBigInteger::from(BigInteger{value} + BigInteger{other->value});
+    return ObjectInteger::make(result);
 }
 
 ObjectFloat* ObjectInteger::operator+(const ObjectFloat* other) const noexcept {
-    return new ObjectFloat {static_cast<float64>(value) + other->value};
+    return ObjectFloat::make(static_cast<float64>(value) + other->value);
 }
 
-ObjectInteger* ObjectInteger::operator-(const ObjectInteger* other) const noexcept {
-    return new ObjectInteger {value - other->value};
+Object* ObjectInteger::operator-(const ObjectInteger* other) const noexcept {
+    i64 result;
+    if (__builtin_sub_overflow(value, other->value, &result)) [[unlikely]]
+        return ObjectBigInteger::from(BigInteger{value} - BigInteger{other->value});
+    return ObjectInteger::make(result);
 }
 
 ObjectFloat* ObjectInteger::operator-(const ObjectFloat* other) const noexcept {
-    return new ObjectFloat {static_cast<float64>(value) - other->value};
+    return ObjectFloat::make(static_cast<float64>(value) - other->value);
 }
 
 ObjectInteger* ObjectInteger::operator~() const noexcept {
-    return new ObjectInteger{~value};
+    return ObjectInteger::make(~value);
 }
 
 ObjectInteger* ObjectInteger::operator>>(const ObjectInteger* count) const noexcept {
-    return new ObjectInteger{value >> count->value};
-}
-
-ObjectInteger* ObjectInteger::operator<<(const ObjectInteger* count) const noexcept {
-    return new ObjectInteger{value << count->value};
+    // Shifting by the width or more is undefined for i64
+    if (count->value >= 64)
+        return ObjectInteger::make(value < 0 ? -1 : 0);
+    return ObjectInteger::make(value >> count->value);
+}
+
+Object* ObjectInteger::operator<<(const ObjectInteger* count) const noexcept {
+    if (value == 0)
+        return ObjectInteger::make(0);
+    if (count->value < 64) {
+        i64 result = value << count->value;
+        // Shifting back recovers value unless bits were lost
+        if ((result >> count->value) == value) [[likely]]
+            return ObjectInteger::make(result);
+    }
+    BigInteger big{value};
+    if (static_cast<u64>(count->value) > BigInteger::MAX_BITS - big.bit_length())
+        return nullptr;
+    return ObjectBigInteger::from(big << static_cast<u64>(count->value));
+}
+
+Object* ObjectInteger::power(const ObjectInteger* exponent) const noexcept {
+    if (exponent->value < 0) {
+        // 1/(value**n) truncated
+        if (value == 0) return nullptr;
+        if (value == 1) return ObjectInteger::make(1);
+        if (value == -1) return ObjectInteger::make((exponent->value & 1) ? -1 : 1);
+        return ObjectInteger::make(0);
+    }
+    // Exponentiation by squaring, bail out to BigInteger on overflow
+    i64 result = 1;
+    i64 base = value;
+    u64 n = static_cast<u64>(exponent->value);
+    bool overflow = false;
+    while (true) {
+        if ((n & 1) && __builtin_mul_overflow(result, base, &result)) {
+            overflow = true;
+            break;
+        }
+        n >>= 1;
+        if (!n) break;
+        if (__builtin_mul_overflow(base, base, &base)) {
+            overflow = true;
+            break;
+        }
+    }
+    if (!overflow) [[likely]]
+        return ObjectInteger::make(result);
+    BigInteger big{value};
+    if (static_cast<u64>(exponent->value) > BigInteger::MAX_BITS / big.bit_length())
+        return nullptr;
+    return ObjectBigInteger::from(big.pow(static_cast<u64>(exponent->value)));
 }
 
 ObjectInteger* ObjectInteger::operator&(const ObjectInteger* count) const noexcept {
-    return new ObjectInteger{value & count->value};
+    return ObjectInteger::make(value & count->value);
 }
 
 ObjectInteger* ObjectInteger::operator^(const ObjectInteger* count) const noexcept {
-    return new ObjectInteger{value ^ count->value};
+    return ObjectInteger::make(value ^ count->value);
 }
 
 ObjectInteger* ObjectInteger::operator|(const ObjectInteger* count) const noexcept {
-    return new ObjectInteger{value | count->value};
+    return ObjectInteger::make(value | count->value);
 }
 
 ObjectInteger* ObjectInteger::copy() const noexcept {
-    return new ObjectInteger{this->value};
+    return ObjectInteger::make(this->value);
 }
 
 // ------------------------- ObjectInteger -------------------------
 
 // ------------------------- ObjectFloat -------------------------
 
-std::string ObjectFloat::to_string() const noexcept {
-    std::ostringstream oss;
+// Same text std::ostream produces: whole values use the default
+// precision (6) followed by ".0", everything else 16 significant digits
+static size_t format_float(char* buffer, size_t size, float64 value) noexcept {
+    std::to_chars_result r;
     if (std::ceil(value) == std::floor(value)) {
-        oss << value << ".0" ;
+        r = std::to_chars(buffer, buffer + size - 2, value, std::chars_format::general, 6);
+        *r.ptr++ = '.';
+        *r.ptr++ = '0';
     } else {
-        oss << std::setprecision(16) ;
-        oss << value ;
+        r = std::to_chars(buffer, buffer + size, value, std::chars_format::general, 16);
     }
-    return oss.str();
+    return static_cast<size_t>(r.ptr - buffer);
+}
+
+std::string ObjectFloat::to_string() const noexcept {
+    char buffer[64];
+    return std::string(buffer, format_float(buffer, sizeof(buffer), value));
+}
+
+void ObjectFloat::format_to(OutputSink& sink) const noexcept {
+    char buffer[64];
+    sink.write(buffer, format_float(buffer, sizeof(buffer), value));
 }
 
 ObjectFloat* ObjectFloat::operator-() const noexcept {
-    return new ObjectFloat{-value};
+    return ObjectFloat::make(-value);
 }
 
 ObjectFloat* ObjectFloat::operator*(const ObjectInteger* other) const noexcept {
-    return new ObjectFloat{
+    return ObjectFloat::make(
         static_cast<float64>(value * other->value)
-    };
+    );
 }
 
 ObjectFloat* ObjectFloat::operator*(const ObjectFloat* other) const noexcept {
-    return new ObjectFloat{
+    return ObjectFloat::make(
         static_cast<float64>(value * other->value)
-    };
+    );
 }
 
 ObjectFloat* ObjectFloat::operator+(const ObjectInteger* other) const noexcept {
-    return new ObjectFloat{value + static_cast<float64>(other->value)};
+    return ObjectFloat::make(value + static_cast<float64>(other->value));
 }
 
 ObjectFloat* ObjectFloat::operator+(const ObjectFloat* other) const noexcept {
-    return new ObjectFloat{value + other->value};
+    return ObjectFloat::make(value + other->value);
 }
 
 ObjectFloat* ObjectFloat::operator-(const ObjectInteger* other) const noexcept {
-    return new ObjectFloat{value - static_cast<float64>(other->value)};
+    return ObjectFloat::make(value - static_cast<float64>(other->value));
 }
 
 ObjectFloat* ObjectFloat::operator-(const ObjectFloat* other) const noexcept {
-    return new ObjectFloat{value - other->value};
+    return ObjectFloat::make(value - other->value);
 }
 
 ObjectFloat* ObjectFloat::copy() const noexcept {
-    return new ObjectFloat{this->value};
+    return ObjectFloat::make(this->value);
 }
 
 // ------------------------- ObjectFloat -------------------------
 
+// ------------------------- ObjectBigInteger -------------------------
+
+Object* ObjectBigInteger::from(BigInteger&& value) noexcept {
+    if (value.fits_i64())
+        return ObjectInteger::make(value.to_i64());
+    return new ObjectBigInteger{std::move(value)};
+}
+
+std::string ObjectBigInteger::to_string() const noexcept {
+    return value.to_string();
+}
+
+ObjectBoolean* ObjectBigInteger::to_boolean() const noexcept {
+    // Zero always fits in i64
+    return ObjectBoolean::TRUE;
+}
+
+ObjectBigInteger* ObjectBigInteger::copy() const noexcept {
+    return new ObjectBigInteger{BigInteger{value}};
+}
+
+// ------------------------- ObjectBigInteger -------------------------
+
 // ------------------------- ObjectVoid -------------------------
 
 ObjectVoid* ObjectVoid::VOID_OBJECT = new ObjectVoid;
@@ -132,6 +241,10 @@ std::string ObjectVoid::to_string() const noexcept {
     return std::string("void");
 }
 
+void ObjectVoid::format_to(OutputSink& sink) const noexcept {
+    sink.write("void");
+}
+
 ObjectBoolean* ObjectVoid::to_boolean() const noexcept {
     // Void is always false
     return ObjectBoolean::FALSE;
@@ -149,6 +262,10 @@ std::string ObjectString::to_string() const noexcept {
     return *this;
 }
 
+void ObjectString::format_to(OutputSink& sink) const noexcept {
+    sink.write(data(), size());
+}
+
 ObjectBoolean* ObjectString::to_boolean() const noexcept {
     // Empty string is false
     // Non-empty string is true
@@ -169,6 +286,10 @@ std::string ObjectBoolean::to_string() const noexcept {
     return std::string(value ? "true" : "false");
 }
 
+void ObjectBoolean::format_to(OutputSink& sink) const noexcept {
+    sink.write(value ? "true" : "false");
+}
+
 ObjectBoolean* ObjectBoolean::negated() const noexcept {
     return ObjectBoolean::as_object(!value);
 }
@@ -1,11 +1,17 @@
 #ifndef OBJECT_H_INCLUDED
 #define OBJECT_H_INCLUDED
 
+#include <cmath>
+#include <type_traits>
+#include <typeinfo>
+#include "bigint.hpp"
 #include "common.hpp"
+#include "memory_stats.hpp"
 
 class Type;
 class ObjectBoolean;
 class ObjectFloat;
+class OutputSink;
 
 class Object {
 public:
@@ -15,15 +21,40 @@ public:
     virtual ObjectBoolean* equals(const Object* other) const noexcept = 0;
     virtual std::string to_string() const noexcept = 0;
     virtual ObjectBoolean* to_boolean() const noexcept = 0;
+    // Write textual representation into sink
+    // Default goes through to_string(), subclasses avoid the temporary
+    virtual void format_to(OutputSink& sink) const noexcept;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Object* obj) {
     return os << obj->to_string() ;
 }
 
+// dynamic_cast for leaf classes, compares the dynamic type directly
+// instead of walking the class hierarchy
+template <typename T>
+inline T* exact_cast(Object* obj) noexcept {
+    return typeid(*obj) == typeid(T) ? static_cast<T*>(obj) : nullptr;
+}
+
+template <typename T>
+inline const T* exact_cast(const Object* obj) noexcept {
+    return typeid(*obj) == typeid(T) ? static_cast<const T*>(obj) : nullptr;
+}
+
 class ObjectInteger;
 class ObjectFloat;
 
+// Integers in this range are preallocated once and shared
+// Override with -DSMALL_INTEGER_MIN=... -DSMALL_INTEGER_MAX=...
+#ifndef SMALL_INTEGER_MIN
+#define SMALL_INTEGER_MIN (-1024)
+#endif
+
+#ifndef SMALL_INTEGER_MAX
+#define SMALL_INTEGER_MAX 65535
+#endif
+
 template <typename T>
 class Number: public Object {
 public:
@@ -33,10 +64,11 @@ public:
     ObjectBoolean* equals(const Object* other) const noexcept override;
     ObjectBoolean* to_boolean() const noexcept override;
 
-    virtual Number* operator-() const noexcept = 0;
+    virtual Object* operator-() const noexcept = 0;
 
+    // nullptr when the truncated divisor is zero
     template <typename U>
-    ObjectInteger* integer_div(const Number<U>* other) const noexcept;
+    Object* integer_div(const Number<U>* other) const noexcept;
     template <typename U>
     ObjectFloat* operator/(const Number<U>* other) const noexcept;
 
@@ -53,25 +85,45 @@ public:
 template class Number<i64>;
 template class Number<float64>;
 
+// Integer arithmetic stays on i64 and checks for overflow, results that
+// do not fit are promoted to an ObjectBigInteger, hence the Object* returns
 class ObjectInteger: public Number<i64> {
 public:
+    ACCOUNTED_ALLOCATION(MemoryStats::OBJECT_INTEGER)
+
+    // Cached objects for [SMALL_INTEGER_MIN, SMALL_INTEGER_MAX], never freed
+    static ObjectInteger* SMALL_INTEGERS;
+
     ObjectInteger(const i64& val);
+
+    // Preferred way to create integers, shares cached small values
+    static inline ObjectInteger* make(i64 value) noexcept {
+        if (value >= SMALL_INTEGER_MIN && value <= SMALL_INTEGER_MAX) [[likely]]
+            return &SMALL_INTEGERS[value - SMALL_INTEGER_MIN];
+        return new ObjectInteger{value};
+    }
+
     std::string to_string() const noexcept override;
+    void format_to(OutputSink& sink) const noexcept override;
     ObjectInteger* copy() const noexcept override;
 
-    ObjectInteger* operator*(const ObjectInteger* other) const noexcept;
+    Object* operator*(const ObjectInteger* other) const noexcept;
     ObjectFloat* operator*(const ObjectFloat* other) const noexcept;
-    ObjectInteger* operator+(const ObjectInteger* other) const noexcept;
+    Object* operator+(const ObjectInteger* other) const noexcept;
     ObjectFloat* operator+(const ObjectFloat* other) const noexcept;
-    ObjectInteger* operator-(const ObjectInteger* other) const noexcept;
+    Object* operator-(const ObjectInteger* other) const noexcept;
     ObjectFloat* operator-(const ObjectFloat* other) const noexcept;
 
-    ObjectInteger* operator-() const noexcept override;
+    Object* operator-() const noexcept override;
 
     ObjectInteger* operator~() const noexcept;
     ObjectInteger* operator%(const ObjectInteger* other) const noexcept;
     ObjectInteger* operator>>(const ObjectInteger* count) const noexcept;
-    ObjectInteger* operator<<(const ObjectInteger* count) const noexcept;
+    // nullptr when the result would exceed BigInteger::MAX_BITS
+    Object* operator<<(const ObjectInteger* count) const noexcept;
+    // Negative exponents truncate towards zero
+    // nullptr for 0 ** -n and for results exceeding BigInteger::MAX_BITS
+    Object* power(const ObjectInteger* exponent) const noexcept;
     ObjectInteger* operator&(const ObjectInteger* count) const noexcept;
     ObjectInteger* operator^(const ObjectInteger* count) const noexcept;
     ObjectInteger* operator|(const ObjectInteger* count) const noexcept;
@@ -80,8 +132,26 @@ public:
 
 class ObjectFloat: public Number<float64> {
 public:
+    ACCOUNTED_ALLOCATION(MemoryStats::OBJECT_FLOAT)
+
+    // Shared 0.0 and 1.0, never freed
+    static ObjectFloat* ZERO;
+    static ObjectFloat* ONE;
+
     ObjectFloat(const float64& val);
+
+    // Preferred way to create floats, shares cached common values
+    static inline ObjectFloat* make(float64 value) noexcept {
+        // -0.0 compares equal to 0.0 but prints differently
+        if (value == 0.0 && !std::signbit(value))
+            return ZERO;
+        if (value == 1.0)
+            return ONE;
+        return new ObjectFloat{value};
+    }
+
     std::string to_string() const noexcept override;
+    void format_to(OutputSink& sink) const noexcept override;
     ObjectFloat* operator-() const noexcept override;
     ObjectFloat* operator*(const ObjectInteger* other) const noexcept;
     ObjectFloat* operator*(const ObjectFloat* other) const noexcept;
@@ -93,7 +163,29 @@ public:
     // More float specific code here later
 };
 
+// Integers outside i64 range, the language sees them as plain `int`
+// Values that fit in i64 are always represented by ObjectInteger
+class ObjectBigInteger: public Object {
+public:
+    ACCOUNTED_ALLOCATION(MemoryStats::OBJECT_BIG_INTEGER)
+
+    BigInteger value;
+    ObjectBigInteger(BigInteger&& val);
+    ~ObjectBigInteger();
+
+    // Narrowest object holding value
+    static Object* from(BigInteger&& value) noexcept;
+
+    ObjectBoolean* equals(const Object* other) const noexcept override;
+    std::string to_string() const noexcept override;
+    ObjectBoolean* to_boolean() const noexcept override;
+    ObjectBigInteger* copy() const noexcept override;
+};
+
 class ObjectVoid: public Object {
+public:
+    ACCOUNTED_ALLOCATION(MemoryStats::OBJECT_VOID)
+
 private:
     ObjectVoid(); // Only a single object availaible
     ObjectVoid(const ObjectVoid&) = delete; // No copy constructor
@@ -105,20 +197,25 @@ public:
 
     ObjectBoolean* equals(const Object* other) const noexcept override;
     std::string to_string() const noexcept override;
+    void format_to(OutputSink& sink) const noexcept override;
     ObjectBoolean* to_boolean() const noexcept override;
     ObjectVoid* copy() const noexcept override;
 };
 
 class ObjectString: public Object, public std::string {
 public:
+    ACCOUNTED_ALLOCATION(MemoryStats::OBJECT_STRING)
+
     ObjectString();
     ObjectString(const char* s);
     ObjectString(const char* s, size_t len);
     ObjectString(const std::string& s);
     ObjectString(const std::string&& s);
+    ~ObjectString();
 
     ObjectBoolean* equals(const Object* other) const noexcept override;
     std::string to_string() const noexcept override;
+    void format_to(OutputSink& sink) const noexcept override;
 
     ObjectBoolean* to_boolean() const noexcept override;
     ObjectString* copy() const noexcept override;
@@ -126,6 +223,9 @@ public:
 };
 
 class ObjectBoolean: public Object {
+public:
+    ACCOUNTED_ALLOCATION(MemoryStats::OBJECT_BOOLEAN)
+
 private:
     ObjectBoolean(const ObjectBoolean&) = delete; // No copy constructor
     ObjectBoolean& operator=(const ObjectBoolean&) = delete; // No copy assignment
@@ -144,6 +244,7 @@ public:
 
     ObjectBoolean* equals(const Object* other) const noexcept override;
     std::string to_string() const noexcept override;
+    void format_to(OutputSink& sink) const noexcept override;
 
     ObjectBoolean* negated() const noexcept;
     ObjectBoolean* operator!() const noexcept;
@@ -167,20 +268,45 @@ ObjectBoolean* Number<T>::to_boolean() const noexcept {
 
 template <typename T>
 template <typename U>
-ObjectInteger* Number<T>::integer_div(const Number<U>* other) const noexcept {
-    if (!other->value) return nullptr;
-    return new ObjectInteger {
-        static_cast<i64>(value) / static_cast<i64>(other->value)
-    };
+Object* Number<T>::integer_div(const Number<U>* other) const noexcept {
+    if constexpr (std::is_same_v<T, i64> && std::is_same_v<U, i64>) {
+        if (!other->value) return nullptr;
+        // The only quotient that overflows
+        if (value == INT64_MIN && other->value == -1)
+            return ObjectBigInteger::from(-BigInteger{value});
+        return ObjectInteger::make(value / other->value);
+    } else {
+        // Float operands are truncated before dividing
+        const float64 dividend = std::trunc(static_cast<float64>(value));
+        const float64 divisor = std::trunc(static_cast<float64>(other->value));
+        if (divisor == 0 || !std::isfinite(dividend) || !std::isfinite(divisor))
+            return nullptr;
+        if (
+            dividend >= -0x1p63L && dividend < 0x1p63L &&
+            divisor >= -0x1p63L && divisor < 0x1p63L
+        ) {
+            const i64 a = static_cast<i64>(dividend);
+            const i64 b = static_cast<i64>(divisor);
+            if (a == INT64_MIN && b == -1)
+                return ObjectBigInteger::from(-BigInteger{a});
+            return ObjectInteger::make(a / b);
+        }
+        BigInteger quotient, remainder;
+        BigInteger::divmod(
+            BigInteger::from_float64(dividend), BigInteger::from_float64(divisor),
+            quotient, remainder
+        );
+        return ObjectBigInteger::from(std::move(quotient));
+    }
 }
 
 template <typename T>
 template <typename U>
 ObjectFloat* Number<T>::operator/(const Number<U>* other) const noexcept {
     if (!other->value) return nullptr;
-    return new ObjectFloat {
+    return ObjectFloat::make(
         static_cast<float64>(value) / static_cast<float64>(other->value)
-    };
+    );
 }
 
 template <typename T>
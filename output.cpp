@@ -0,0 +1,43 @@
+#include <cerrno>
+#include <charconv>
+#include "output.hpp"
+
+OutputSink::OutputSink(int _fd): fd{_fd} {
+    buffer = new char[CAPACITY];
+}
+
+OutputSink::~OutputSink() {
+    flush();
+    delete[] buffer;
+}
+
+void OutputSink::write_through(const char* s, size_t len) noexcept {
+    if (captured) {
+        captured->append(s, len);
+        return;
+    }
+    while (len > 0) {
+        ssize_t written = ::write(fd, s, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            // Nowhere to report it, drop the rest
+            return;
+        }
+        s += written;
+        len -= static_cast<size_t>(written);
+    }
+}
+
+void OutputSink::write_integer(i64 value) noexcept {
+    // 20 digits and a sign cover every i64
+    char digits[24];
+    std::to_chars_result r =
+        std::to_chars(digits, digits + sizeof(digits), value);
+    write(digits, static_cast<size_t>(r.ptr - digits));
+}
+
+void OutputSink::flush() noexcept {
+    if (used == 0) return;
+    write_through(buffer, used);
+    used = 0;
+}
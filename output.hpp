@@ -0,0 +1,65 @@
+#ifndef OUTPUT_H_INCLUDED
+#define OUTPUT_H_INCLUDED
+
+#include <string_view>
+#include <unistd.h>
+#include "common.hpp"
+
+// Buffered writer used by the interpreter for everything `print` emits
+// Output is kept in user space until the buffer fills or flush() is called
+// and then written to fd, or appended to a string while capturing
+class OutputSink {
+public:
+    static constexpr size_t CAPACITY = 1 << 16;
+
+private:
+    int fd;
+    char* buffer;
+    size_t used = 0;
+    std::string* captured = nullptr;
+
+    void write_through(const char* s, size_t len) noexcept;
+
+public:
+    explicit OutputSink(int _fd = STDOUT_FILENO);
+    ~OutputSink();
+
+    OutputSink(const OutputSink&) = delete; // No copy constructor
+    OutputSink& operator=(const OutputSink&) = delete; // No copy assignment
+
+    inline size_t pending() const noexcept { return used; }
+
+    // Everything written from now on goes to s instead, nullptr writes to
+    // fd again
+    inline void capture(std::string* s) noexcept {
+        flush();
+        captured = s;
+    }
+
+    inline void write(char c) noexcept {
+        if (used == CAPACITY) flush();
+        buffer[used++] = c;
+    }
+
+    inline void write(const char* s, size_t len) noexcept {
+        if (len > CAPACITY - used) {
+            flush();
+            if (len >= CAPACITY) {
+                // Too big to be worth copying, send it directly
+                write_through(s, len);
+                return;
+            }
+        }
+        std::memcpy(buffer + used, s, len);
+        used += len;
+    }
+
+    inline void write(std::string_view s) noexcept {
+        write(s.data(), s.size());
+    }
+
+    void write_integer(i64 value) noexcept;
+    void flush() noexcept;
+};
+
+#endif
@@ -1,12 +1,13 @@
+#include <charconv>
 #include "parser.hpp"
 #include "object.hpp"
 #include "syntax_tree.hpp"
 #include "token.hpp"
 
 void Parser::report_error(const ErrorPair& error_pair) const noexcept {
-    std::cerr << std::format(
+    *diagnostics << std::format(
         "\033[36m{}:{}:{}:\033[0m \033[31merror:\033[0m {}\n{}\n",
-        *Common::get_filename(),
+        source_name,
         last_used.col+last_used.value.length()+1, last_used.line+1,
         error_pair.msg,
         error_pair.diagnostics
@@ -65,6 +66,11 @@ ParseResult Parser::parse_source() {
     Program *source_tree = new Program;
     ParseResult result;
     while (!is_at_end()) {
+        // Statements end with ;, lines between them need no token
+        if (current.ttype == TokenType::LINEBREAK) {
+            read_next_token();
+            continue;
+        }
         result = parse_statement();
         if (result.is_usable()) {
             source_tree->statements.push_back(
@@ -87,20 +93,42 @@ ParseResult Parser::parse_source() {
 }
 
 ParseResult Parser::parse_statement() {
+    const size_t line = current.line + 1;
     ParseResult result;
     if (current.is_type_keyword())
         result = parse_variable_declaration();
     else if (current.ttype == TokenType::KEYWORD_PRINT)
         result = parse_print();
-    else
+    else {
+        const Token start = current;
         result = parse_expression();
+        // Nothing consumed, callers would retry the same token forever
+        if (
+            result.is_null_value() && !is_at_end() &&
+            current.line == start.line && current.col == start.col
+        ) {
+            last_used = current;
+            if (current.ttype == TokenType::SEMI_COLON) {
+                // Empty statement
+                read_next_token();
+            } else {
+                _errors++;
+                result = ParseResult::Error(
+                    ErrorPair{std::format("Unexpected `{}`", current.value), std::string{}}
+                );
+            }
+        }
+    }
     if (result.is_usable()) {
+        // Expressions carry the line of their operator already
+        if (result.unwrap()->line == 0)
+            result.unwrap()->line = line;
         if (current.ttype == TokenType::SEMI_COLON) {
             last_used = current;
             // Consume ;
             read_next_token();
         } else if (
-            Common::is_mode_file() || !check({
+            mode == Mode::File || !check({
                 TokenType::LINEBREAK,
                 TokenType::SEMI_COLON,
                 TokenType::END_OF_FILE
@@ -699,6 +727,7 @@ ParseResult Parser::parse_primary() {
             last_used = current;
             Name* name_expr =
                 new Name{consume().value};
+            name_expr->line = last_used.line + 1;
             result = ParseResult::Ok(name_expr);
             break;
         }
@@ -731,13 +760,23 @@ ParseResult Parser::parse_literal() {
             break;
         }
         case TokenType::INTEGER: {
-            ObjectInteger* obj = new ObjectInteger{std::stoll(current.value)};
-            parsed_hunk =
-                new Literal{reinterpret_cast<Object*>(obj)};
+            i64 value = 0;
+            const char* first = current.value.data();
+            const char* last = first + current.value.size();
+            Object* obj;
+            if (std::from_chars(first, last, value).ec == std::errc{}) {
+                obj = ObjectInteger::make(value);
+            } else {
+                // Too many digits for i64
+                BigInteger big;
+                BigInteger::parse(current.value, big);
+                obj = new ObjectBigInteger{std::move(big)};
+            }
+            parsed_hunk = new Literal{obj};
             break;
         }
         case TokenType::FLOAT: {
-            ObjectFloat* obj = new ObjectFloat{std::stold(current.value, nullptr)};
+            ObjectFloat* obj = ObjectFloat::make(std::stold(current.value, nullptr));
             parsed_hunk =
                 new Literal{reinterpret_cast<Object*>(obj)};
             break;
@@ -752,6 +791,7 @@ ParseResult Parser::parse_literal() {
             return ParseResult::Ok(nullptr);
         }
     }
+    parsed_hunk->line = current.line + 1;
     last_used = current;
     read_next_token();
     return ParseResult::Ok(parsed_hunk);
@@ -762,16 +802,26 @@ ParseResult Parser::parse_block() {
     // Skip opening curly brace
     read_next_token();
     Block* block = new Block;
+    block->line = last_used.line + 1;
     ParseResult result;
-    while (current.ttype != TokenType::RIGHT_CURLY_BRACE) {
+    // Unclosed at the end of input is reported below
+    while (current.ttype != TokenType::RIGHT_CURLY_BRACE && !is_at_end()) {
+        if (current.ttype == TokenType::LINEBREAK) {
+            read_next_token();
+            continue;
+        }
         if (current.ttype == TokenType::KEYWORD_RETURN)
             result = parse_return();
         else
             result = parse_statement();
         if (result.is_usable()) {
-            block->statements.push_back(
-                reinterpret_cast<Statement*>(result.unwrap())
-            );
+            Statement* stmt =
+                reinterpret_cast<Statement*>(result.unwrap());
+            if (stmt->kind == TreeKind::VariableDeclaration)
+                block->declares_variables = true;
+            else if (stmt->kind == TreeKind::Return)
+                block->has_return = true;
+            block->statements.push_back(stmt);
         } else if (result.is_error()) {
             report_error(result.unwrap_error());
             synchronize();
@@ -801,6 +851,7 @@ ParseResult Parser::parse_block() {
 }
 
 ParseResult Parser::parse_return() {
+    const size_t line = current.line + 1;
     last_used = current;
     // Skip keyword `return`
     read_next_token();
@@ -813,6 +864,7 @@ ParseResult Parser::parse_return() {
             Return* ret = new Return{
                 reinterpret_cast<Expression*>(result.unwrap())
             };
+            ret->line = line;
             result = ParseResult::Ok(ret);
             return result;
         } else {
@@ -837,6 +889,7 @@ ParseResult Parser::parse_group() {
             read_next_token();
             GroupedExpression* grouped_expr =
                 new GroupedExpression{result.unwrap()};
+            grouped_expr->line = result.unwrap()->line;
             result = ParseResult::Ok(grouped_expr);
         } else {
             // Expected closing round brace after statement
@@ -881,6 +934,7 @@ ParseResult Parser::parse_cast() {
             target_type,
             reinterpret_cast<Expression*>(result.unwrap())
         };
+        cast_expr->line = type_token.line + 1;
         result = ParseResult::Ok(cast_expr);
     } else if (result.is_null_value()) {
         // Expected expression after cast target type
@@ -21,7 +21,20 @@ class Parser {
     Token current;
     Token last_used;
     size_t _errors = 0;
+    // Interactive input may leave out the ; ending a line
+    Mode mode = Mode::File;
+    // Shown with every syntax error
+    std::string source_name{};
+    std::ostream* diagnostics = &std::cerr;
 public:
+    inline void set_mode(Mode _mode) noexcept { mode = _mode; }
+    inline void set_source_name(const std::string& name) { source_name = name; }
+    // Syntax and lexing errors are written there instead of std::cerr
+    inline void use_diagnostics(std::ostream& os) noexcept {
+        diagnostics = &os;
+        lexer.diagnostics = &os;
+    }
+
     void report_error(const ErrorPair& error_pair) const noexcept;
     void init(char* in, size_t source_len) noexcept;
 
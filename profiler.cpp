@@ -0,0 +1,97 @@
+#include <algorithm>
+#include "profiler.hpp"
+
+size_t Profiler::entry_of(const TreeBase* node) {
+    const u64 key = static_cast<u64>(node->line) << 8 | static_cast<u8>(node->kind);
+    auto [found, added] = entry_index.try_emplace(key, entries.size());
+    if (added)
+        entries.push_back(Entry{node->line, node->kind});
+    return found->second;
+}
+
+bool Profiler::enter(TreeBase* node) {
+    if (!stack.empty() && stack.back().node == node)
+        return false;
+    const size_t entry = entry_of(node);
+    Context* parent = stack.empty() ? &root : stack.back().context;
+    Context*& context = parent->children[entry];
+    if (!context)
+        context = &contexts.emplace_back(Context{parent, entry});
+    entries[entry].active++;
+    stack.push_back(Frame{node, context, now(), 0});
+    return true;
+}
+
+void Profiler::exit() noexcept {
+    const Frame frame = stack.back();
+    stack.pop_back();
+    const u64 elapsed = now() - frame.start_ns;
+    const u64 exclusive = elapsed > frame.children_ns ? elapsed - frame.children_ns : 0;
+    Entry& entry = entries[frame.context->entry];
+    entry.count++;
+    entry.exclusive_ns += exclusive;
+    if (--entry.active == 0)
+        entry.inclusive_ns += elapsed;
+    frame.context->exclusive_ns += exclusive;
+    if (!stack.empty())
+        stack.back().children_ns += elapsed;
+}
+
+void Profiler::report(std::ostream& os, size_t limit) const {
+    std::vector<const Entry*> sorted;
+    u64 total_ns = 0;
+    for (const Entry& entry : entries) {
+        sorted.push_back(&entry);
+        total_ns += entry.exclusive_ns;
+    }
+    std::ranges::sort(sorted, [](const Entry* a, const Entry* b) {
+        return a->exclusive_ns > b->exclusive_ns;
+    });
+    os << std::format(
+        "{:>8}  {:<20}{:>12}{:>14}{:>14}{:>8}\n",
+        "line", "node", "count", "inclusive ms", "exclusive ms", "%"
+    );
+    for (size_t i = 0; i < sorted.size() && i < limit; i++) {
+        const Entry& entry = *sorted[i];
+        os << std::format(
+            "{:>8}  {:<20}{:>12}{:>14.3f}{:>14.3f}{:>7.1f}%\n",
+            entry.line, tree_kind_name(entry.kind), entry.count,
+            entry.inclusive_ns / 1e6, entry.exclusive_ns / 1e6,
+            total_ns ? entry.exclusive_ns * 100.0 / total_ns : 0
+        );
+    }
+    if (sorted.size() > limit)
+        os << std::format("{} more entries not shown\n", sorted.size() - limit);
+}
+
+std::string Profiler::frame_name(const Context* context) const {
+    const Entry& entry = entries[context->entry];
+    if (entry.line == 0)
+        return tree_kind_name(entry.kind);
+    return std::format("{}:{}", tree_kind_name(entry.kind), entry.line);
+}
+
+void Profiler::write_folded(std::ostream& os) const {
+    // Depth first, path holds the frames from the root down to context
+    std::vector<std::pair<const Context*, size_t>> pending;
+    std::vector<std::string> path;
+    for (const auto& [entry, child] : root.children)
+        pending.emplace_back(child, 0);
+    while (!pending.empty()) {
+        auto [context, depth] = pending.back();
+        pending.pop_back();
+        path.resize(depth);
+        path.push_back(frame_name(context));
+        if (context->exclusive_ns) {
+            std::string line;
+            for (const std::string& frame : path) {
+                if (!line.empty())
+                    line.push_back(';');
+                line += frame;
+            }
+            os << std::format("{} {}\n", line, context->exclusive_ns);
+        }
+        for (const auto& [entry, child] : context->children)
+            pending.emplace_back(child, depth + 1);
+    }
+}
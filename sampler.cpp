@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <map>
+#include <signal.h>
+#include <sys/time.h>
+#include "sampler.hpp"
+
+// Only async-signal-safe work: atomics and a store into the ring
+// The handler runs on the interrupted thread and sees its current node
+void Sampler::on_signal(int) noexcept {
+    const size_t index = taken.load(std::memory_order_relaxed);
+    if (index >= CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring[index] = current.load(std::memory_order_relaxed);
+    taken.store(index + 1, std::memory_order_relaxed);
+}
+
+bool Sampler::start(u64 _interval_us) noexcept {
+    if (!ring)
+        ring = new TreeBase*[CAPACITY];
+    interval_us = _interval_us;
+    struct sigaction action{};
+    action.sa_handler = on_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) < 0)
+        return false;
+    itimerval timer{};
+    timer.it_interval.tv_sec = static_cast<time_t>(interval_us / 1000000);
+    timer.it_interval.tv_usec = static_cast<suseconds_t>(interval_us % 1000000);
+    timer.it_value = timer.it_interval;
+    sampling = setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+    return sampling;
+}
+
+void Sampler::stop() noexcept {
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sampling = false;
+}
+
+// Most sampled first
+template <typename Key>
+static std::vector<std::pair<Key, size_t>> by_count(const std::map<Key, size_t>& histogram) {
+    std::vector<std::pair<Key, size_t>> entries{histogram.begin(), histogram.end()};
+    std::ranges::stable_sort(entries, [](const auto& a, const auto& b) { return a.second > b.second; });
+    return entries;
+}
+
+void Sampler::report(std::ostream& os, size_t limit) {
+    const size_t samples = std::min(taken.load(), CAPACITY);
+    size_t outside = 0;
+    std::map<size_t, size_t> lines;
+    std::map<TreeKind, size_t> kinds;
+    for (size_t i = 0; i < samples; i++) {
+        if (!ring[i]) {
+            outside++;
+            continue;
+        }
+        lines[ring[i]->line]++;
+        kinds[ring[i]->kind]++;
+    }
+    auto percent = [&](size_t count) { return samples ? count * 100.0 / samples : 0; };
+    os << std::format(
+        "samples: {} at an interval of {} us of cpu time, {} dropped\n"
+        "outside the interpreter: {} ({:.1f}%)\n",
+        samples, interval_us, dropped.load(), outside, percent(outside)
+    );
+    os << std::format("{:>8}{:>12}{:>8}\n", "line", "samples", "%");
+    const auto by_line = by_count(lines);
+    for (size_t i = 0; i < by_line.size() && i < limit; i++)
+        os << std::format("{:>8}{:>12}{:>7.1f}%\n", by_line[i].first, by_line[i].second, percent(by_line[i].second));
+    os << std::format("{:<20}{:>12}{:>8}\n", "node", "samples", "%");
+    for (const auto& [kind, count] : by_count(kinds))
+        os << std::format("{:<20}{:>12}{:>7.1f}%\n", tree_kind_name(kind), count, percent(count));
+}
@@ -0,0 +1,62 @@
+#ifndef SAMPLER_H_INCLUDED
+#define SAMPLER_H_INCLUDED
+
+#include <atomic>
+#include "syntax_tree.hpp"
+
+// Statistical profiler for --sample: SIGPROF interrupts the process after
+// every interval of CPU time and its handler copies the node the
+// interpreter is running into a ring buffer, aggregated per source line
+// and per node kind when reported
+// Nodes are never freed, so the pointers sampled stay valid until then
+// The kernel rounds the interval up to its timer tick, often 1 to 4 ms
+class Sampler {
+public:
+    // Samples kept, later ones are only counted as dropped
+    static constexpr size_t CAPACITY = 1 << 20;
+
+private:
+    // Innermost node being evaluated, nullptr outside the interpreter
+    // One per thread, so interpreters on other threads neither race on it
+    // nor show up in the samples of this one
+    static inline thread_local std::atomic<TreeBase*> current{nullptr};
+    // Set while the timer runs, nodes are only tracked then
+    static inline bool sampling = false;
+    static inline std::atomic<size_t> taken{0};
+    static inline std::atomic<size_t> dropped{0};
+    static inline TreeBase** ring = nullptr;
+    static inline u64 interval_us = 0;
+
+    static_assert(std::atomic<TreeBase*>::is_always_lock_free);
+    static_assert(std::atomic<size_t>::is_always_lock_free);
+
+    static void on_signal(int) noexcept;
+
+public:
+    // false when the timer or the handler can not be set
+    static bool start(u64 _interval_us) noexcept;
+    static void stop() noexcept;
+    // Lines and node kinds with the most samples, at most limit of each
+    static void report(std::ostream& os, size_t limit);
+
+    // Makes node the current one until destroyed, one branch on a static
+    // flag unless sampling
+    class Scope {
+        TreeBase* previous = nullptr;
+        bool active;
+
+    public:
+        inline explicit Scope(TreeBase* node) noexcept: active{sampling} {
+            if (active) {
+                previous = current.load(std::memory_order_relaxed);
+                current.store(node, std::memory_order_relaxed);
+            }
+        }
+
+        inline ~Scope() {
+            if (active) current.store(previous, std::memory_order_relaxed);
+        }
+    };
+};
+
+#endif
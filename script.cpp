@@ -0,0 +1,104 @@
+#include "interpreter.hpp"
+#include "ir_passes.hpp"
+#include "parser.hpp"
+#include "script.hpp"
+#include "simplifier.hpp"
+#include "type_checker.hpp"
+
+// Inputs of the script declared in env, holding their zero values
+static void declare_inputs(Environment& env, const Script::Options& options) noexcept {
+    for (const auto& [name, type] : options.inputs)
+        env.define(name, type);
+}
+
+Script::CompileResult Script::compile(const std::string& source, const Options& options) {
+    std::shared_ptr<Script> script{new Script{options}};
+    // Nothing to lex, the lexer expects at least a character
+    if (source.find_first_not_of(" \t\r\n") == std::string::npos)
+        return CompileResult::Ok(script);
+
+    std::ostringstream diagnostics;
+    Parser parser;
+    parser.set_source_name(options.name);
+    parser.use_diagnostics(diagnostics);
+    // The lexer copies what it reads
+    std::string text = source;
+    parser.init(text.data(), text.size());
+    ParseResult parsed = parser.parse_source();
+    if (parsed.is_error()) {
+        parser.report_error(parsed.unwrap_error());
+        return CompileResult::Error(diagnostics.str());
+    }
+    if (parser.errors())
+        return CompileResult::Error(diagnostics.str());
+    script->tree = parsed.unwrap();
+    if (!script->tree)
+        return CompileResult::Ok(script);
+
+    // Only resolves the inputs' names and types, never runs
+    Interpreter interpreter;
+    declare_inputs(interpreter.environment(), options);
+    TypeChecker checker{interpreter.environment()};
+    checker.use_diagnostics(diagnostics);
+    if (checker.check(script->tree) != 0)
+        return CompileResult::Error(diagnostics.str());
+    Simplifier{}.run(script->tree);
+    if (options.engine == Engine::Ir) {
+        // Globals stay in the environment, where Run reads them from
+        IrBuilder{interpreter.environment(), true}.build(script->tree, script->function);
+        IrInterpreter evaluator{interpreter};
+        PassManager::standard(evaluator).run(script->function);
+    }
+    // Runs share the tree, including the nodes IR instructions refer to
+    Interpreter::freeze(script->tree);
+    return CompileResult::Ok(script);
+}
+
+Script::Run Script::run(const Inputs& inputs, const Budget::Limits& limits) const {
+    Run result;
+    // The environment and inputs of the run count against its heap limit
+    if (limits.max_heap)
+        MemoryStats::enable();
+    const u64 heap_base = MemoryStats::total().live;
+    Interpreter interpreter;
+    Environment& env = interpreter.environment();
+    declare_inputs(env, options);
+    for (const auto& [name, value] : inputs) {
+        const bool declared = std::ranges::any_of(
+            options.inputs, [&](const auto& input) { return input.first == name; }
+        );
+        if (!declared) {
+            result.error = std::format("`{}` is not an input of the script", name);
+            return result;
+        }
+        SlotResult slot = env.lookup(name);
+        EnvironmentResult stored = Environment::store(name, slot.unwrap(), Value::unbox(value));
+        if (stored.is_error()) {
+            result.error = stored.unwrap_error();
+            return result;
+        }
+    }
+
+    interpreter.output().capture(&result.output);
+    Budget& budget = interpreter.budget();
+    budget.start(limits, heap_base);
+    InterpreterResult eval = InterpreterResult::Ok(nullptr);
+    if (!budget.check_heap())
+        eval = InterpreterResult::Error(budget.error());
+    else if (tree && options.engine == Engine::Ir)
+        eval = IrInterpreter{interpreter}.run(function);
+    else if (tree)
+        eval = interpreter.interpret(tree);
+    interpreter.output().capture(nullptr);
+
+    result.ok = eval.is_ok();
+    if (result.ok)
+        result.value = eval.unwrap();
+    else
+        result.error = eval.unwrap_error();
+    result.budget_exhausted = budget.exhausted();
+    result.steps = budget.steps_taken();
+    for (const auto& [name, slot] : *env.globals())
+        result.globals.emplace(name, slot.value.box());
+    return result;
+}
@@ -0,0 +1,79 @@
+#ifndef SCRIPT_H_INCLUDED
+#define SCRIPT_H_INCLUDED
+
+#include <memory>
+#include <unordered_map>
+#include "budget.hpp"
+#include "ir.hpp"
+#include "result.hpp"
+
+// Embedding API of libinterp, a program is parsed, type checked and
+// optimized once into a Script, then run any number of times
+// Every run gets a fresh environment holding the script's inputs, globals
+// it declares and the caller sets before the run, and its own output
+//
+//     Script::Options options;
+//     options.inputs = {{"n", TypeInteger::get_type_object()}};
+//     Script::CompileResult compiled = Script::compile("print n * 2;", options);
+//     Script::Run run = compiled.unwrap()->run({{"n", ObjectInteger::make(21)}});
+//     // run.ok, run.output == "42"
+//
+// Runs share the compiled tree, frozen once compiled, and keep everything
+// they change to themselves, so runs of one Script may overlap, on any
+// threads
+class Script {
+public:
+    enum class Engine : u8 {
+        Tree,
+        // Lowered to SSA and optimized when compiled
+        Ir,
+    };
+
+    struct Options {
+        Engine engine = Engine::Tree;
+        // Named in syntax errors
+        std::string name = "script";
+        // Globals every run provides, known to the type checker
+        std::vector<std::pair<std::string, Type*>> inputs{};
+    };
+
+    // Values of inputs, those left out hold the zero value of their type
+    using Inputs = std::vector<std::pair<std::string, Object*>>;
+
+    struct Run {
+        bool ok = false;
+        // Value of the last statement, nullptr without one or on errors
+        Object* value = nullptr;
+        // Everything printed, up to the error if any
+        std::string output{};
+        // Empty when ok
+        std::string error{};
+        // A limit of the budget ended the run
+        bool budget_exhausted = false;
+        u64 steps = 0;
+        // Top level variables once the run ended, inputs included
+        std::unordered_map<std::string, Object*> globals{};
+    };
+
+    // Syntax and type errors as the error, as the CLI would print them
+    using CompileResult = Result<std::shared_ptr<const Script>, std::string>;
+
+private:
+    Options options;
+    // nullptr for a program without statements
+    TreeBase* tree = nullptr;
+    IrFunction function{};
+
+    explicit Script(const Options& _options): options{_options} {}
+
+public:
+    static CompileResult compile(const std::string& source, const Options& options);
+    static inline CompileResult compile(const std::string& source) { return compile(source, Options{}); }
+
+    // Limits count from the start of the run, see Budget
+    Run run(const Inputs& inputs = {}, const Budget::Limits& limits = {}) const;
+
+    inline const Options& settings() const noexcept { return options; }
+};
+
+#endif
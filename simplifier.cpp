@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <bit>
+#include <format>
+#include "simplifier.hpp"
+
+// Parentheses only group, they never change a value
+static TreeBase* ungrouped(TreeBase* tree) noexcept {
+    while (tree->kind == TreeKind::GroupedExpression)
+        tree = static_cast<GroupedExpression*>(tree)->grouped_expr;
+    return tree;
+}
+
+static bool is_integer_literal(TreeBase* tree, i64 value) noexcept {
+    tree = ungrouped(tree);
+    if (tree->kind != TreeKind::Literal)
+        return false;
+    const ObjectInteger* literal =
+        exact_cast<ObjectInteger>(static_cast<Literal*>(tree)->value_object);
+    return literal && literal->value == value;
+}
+
+// Exponent k of an int literal 2**k, k > 0, otherwise 0
+static i64 power_of_two(TreeBase* tree) noexcept {
+    tree = ungrouped(tree);
+    if (tree->kind != TreeKind::Literal)
+        return 0;
+    const ObjectInteger* literal =
+        exact_cast<ObjectInteger>(static_cast<Literal*>(tree)->value_object);
+    if (!literal || literal->value < 2 || !std::has_single_bit(static_cast<u64>(literal->value)))
+        return 0;
+    return std::countr_zero(static_cast<u64>(literal->value));
+}
+
+// Evaluating it twice is the same as once
+static bool is_pure(TreeBase* tree) noexcept {
+    tree = ungrouped(tree);
+    return tree->kind == TreeKind::Name || tree->kind == TreeKind::Literal;
+}
+
+// An int literal that fits a machine word, the product of two stays
+// far below BigInteger::MAX_BITS
+static bool is_machine_integer(const TreeBase* tree) noexcept {
+    while (tree->kind == TreeKind::GroupedExpression)
+        tree = static_cast<const GroupedExpression*>(tree)->grouped_expr;
+    return tree->kind == TreeKind::Literal &&
+        exact_cast<ObjectInteger>(static_cast<const Literal*>(tree)->value_object);
+}
+
+// Evaluating it has no effects and can't fail, given operand types
+// the TypeChecker proved
+static bool is_removable(const TreeBase* tree) noexcept {
+    switch (tree->kind) {
+        case TreeKind::Literal:
+        case TreeKind::Name:
+            return true;
+        case TreeKind::GroupedExpression:
+            return is_removable(static_cast<const GroupedExpression*>(tree)->grouped_expr);
+        case TreeKind::Unary:
+            return is_removable(static_cast<const Unary*>(tree)->expr);
+        case TreeKind::Factor: {
+            // Divisions may divide by zero, int products may pass the
+            // bit limit unless both factors are small literals
+            const Binary* binary = static_cast<const Binary*>(tree);
+            if (binary->op.ttype != TokenType::STAR)
+                return false;
+            if (binary->operands == Operands::Floats)
+                return is_removable(binary->left) && is_removable(binary->right);
+            return is_machine_integer(binary->left) && is_machine_integer(binary->right);
+        }
+        case TreeKind::Logical:
+        case TreeKind::Bitwise:
+        case TreeKind::Equality:
+        case TreeKind::Comparison:
+        case TreeKind::Term: {
+            const Binary* binary = static_cast<const Binary*>(tree);
+            return is_removable(binary->left) && is_removable(binary->right);
+        }
+        default: {}
+    }
+    // Shifts and powers may pass the bit limit, casts may not convert
+    return false;
+}
+
+void Simplifier::run(TreeBase* tree) noexcept {
+    // Statements are never replaced, only expressions
+    simplify(tree);
+}
+
+void Simplifier::report_statistics(std::ostream& os) const noexcept {
+    os << std::format(
+        "nodes simplified: {}\n"
+        "statements removed: {}\n",
+        rewrites,
+        statements_removed
+    );
+}
+
+// Statements except keep whose values nobody uses
+void Simplifier::remove_unused(std::vector<Statement*>& statements, const Statement* keep) noexcept {
+    statements_removed += std::erase_if(statements, [&](const Statement* stmt) {
+        return stmt != keep && is_removable(stmt);
+    });
+}
+
+void Simplifier::simplify_block(Block* tree) noexcept {
+    std::vector<Statement*>& statements = tree->statements;
+    // An empty block has no value at all, unlike one without a return
+    if (statements.empty())
+        return;
+    auto returned = std::ranges::find_if(statements, [](const Statement* stmt) {
+        return stmt->kind == TreeKind::Return;
+    });
+    if (returned != statements.end()) {
+        statements_removed += statements.end() - returned - 1;
+        statements.erase(returned + 1, statements.end());
+    }
+    for (Statement*& stmt : statements)
+        stmt = static_cast<Statement*>(simplify(stmt));
+    // Only the return has its value used, the last statement stays
+    // either way so the block is never left empty
+    remove_unused(statements, statements.back());
+    tree->declares_variables = std::ranges::any_of(statements, [](const Statement* stmt) {
+        return stmt->kind == TreeKind::VariableDeclaration;
+    });
+}
+
+TreeBase* Simplifier::simplify(TreeBase* tree) noexcept {
+    switch (tree->kind) {
+        case TreeKind::Program: {
+            std::vector<Statement*>& statements = static_cast<Program*>(tree)->statements;
+            for (Statement*& stmt : statements)
+                stmt = static_cast<Statement*>(simplify(stmt));
+            // The last statement is the value of the program
+            if (!statements.empty())
+                remove_unused(statements, statements.back());
+            break;
+        }
+        case TreeKind::Block:
+            simplify_block(static_cast<Block*>(tree));
+            break;
+        case TreeKind::VariableDeclaration:
+            for (auto& [name, initializer] : static_cast<VariableDeclaration*>(tree)->pairs) {
+                if (initializer)
+                    initializer = simplify(initializer);
+            }
+            break;
+        case TreeKind::Assignment: {
+            Assignment* assignment = static_cast<Assignment*>(tree);
+            assignment->expr = static_cast<Expression*>(simplify(assignment->expr));
+            break;
+        }
+        case TreeKind::Print: {
+            Print* print = static_cast<Print*>(tree);
+            if (print->expr)
+                print->expr = static_cast<Expression*>(simplify(print->expr));
+            break;
+        }
+        case TreeKind::Return: {
+            Return* ret = static_cast<Return*>(tree);
+            if (ret->expr)
+                ret->expr = static_cast<Expression*>(simplify(ret->expr));
+            break;
+        }
+        case TreeKind::Cast: {
+            Cast* cast = static_cast<Cast*>(tree);
+            cast->casted_expr = static_cast<Expression*>(simplify(cast->casted_expr));
+            break;
+        }
+        case TreeKind::GroupedExpression: {
+            GroupedExpression* group = static_cast<GroupedExpression*>(tree);
+            group->grouped_expr = simplify(group->grouped_expr);
+            break;
+        }
+        case TreeKind::Unary: {
+            Unary* unary = static_cast<Unary*>(tree);
+            unary->expr = simplify(unary->expr);
+            return simplify_unary(unary);
+        }
+        case TreeKind::Logical:
+        case TreeKind::Bitwise:
+        case TreeKind::Equality:
+        case TreeKind::Comparison:
+        case TreeKind::Shift:
+        case TreeKind::Term:
+        case TreeKind::Factor:
+        case TreeKind::Exponential: {
+            Binary* binary = static_cast<Binary*>(tree);
+            binary->left = simplify(binary->left);
+            binary->right = simplify(binary->right);
+            return simplify_binary(binary);
+        }
+        default: {}
+    }
+    return tree;
+}
+
+TreeBase* Simplifier::simplify_binary(Binary* tree) noexcept {
+    // Float arithmetic has no identities that hold for -0.0 and NaN alike,
+    // and mixed operands would turn the int into a float
+    if (tree->operands != Operands::Integers)
+        return tree;
+    TreeBase* replacement = nullptr;
+    switch (tree->op.ttype) {
+        case TokenType::PLUS:
+        case TokenType::BITWISE_OR:
+        case TokenType::BITWISE_XOR:
+            if (is_integer_literal(tree->right, 0))
+                replacement = tree->left;
+            else if (is_integer_literal(tree->left, 0))
+                replacement = tree->right;
+            break;
+        case TokenType::MINUS:
+        case TokenType::LEFT_SHIFT:
+        case TokenType::RIGHT_SHIFT:
+            if (is_integer_literal(tree->right, 0))
+                replacement = tree->left;
+            break;
+        case TokenType::DOUBLE_SLASH:
+            // Division truncates, a right shift would floor negative values
+            if (is_integer_literal(tree->right, 1))
+                replacement = tree->left;
+            break;
+        case TokenType::STAR: {
+            if (is_integer_literal(tree->right, 1)) {
+                replacement = tree->left;
+                break;
+            }
+            if (is_integer_literal(tree->left, 1)) {
+                replacement = tree->right;
+                break;
+            }
+            // The literal has no effects, its side can go first
+            TreeBase* operand = tree->left;
+            i64 count = power_of_two(tree->right);
+            if (!count) {
+                operand = tree->right;
+                count = power_of_two(tree->left);
+            }
+            if (!count)
+                break;
+            // Overflow promotes to a big integer just like multiplying does
+            Shift* shift = new Shift{
+                operand,
+                Token{TokenType::LEFT_SHIFT, "<<", tree->op.col, tree->op.line},
+                new Literal{ObjectInteger::make(count)}
+            };
+            shift->operands = Operands::Integers;
+            replacement = shift;
+            break;
+        }
+        case TokenType::EXPONENT:
+            if (is_integer_literal(tree->right, 1)) {
+                replacement = tree->left;
+            } else if (is_integer_literal(tree->right, 2) && is_pure(tree->left)) {
+                Factor* square = new Factor{
+                    tree->left,
+                    Token{TokenType::STAR, "*", tree->op.col, tree->op.line},
+                    tree->left
+                };
+                square->operands = Operands::Integers;
+                replacement = square;
+            }
+            break;
+        default: {}
+    }
+    if (!replacement)
+        return tree;
+    rewrites++;
+    return replacement;
+}
+
+TreeBase* Simplifier::simplify_unary(Unary* tree) noexcept {
+    TreeBase* operand = ungrouped(tree->expr);
+    switch (tree->unary_op.ttype) {
+        case TokenType::PLUS:
+            // Numeric proven, returns its operand as it is
+            rewrites++;
+            return tree->expr;
+        case TokenType::MINUS:
+        case TokenType::TILDE:
+        case TokenType::BANG:
+            // Negating twice is exact for ints, floats and booleans
+            if (
+                operand->kind == TreeKind::Unary &&
+                static_cast<Unary*>(operand)->unary_op.ttype == tree->unary_op.ttype
+            ) {
+                rewrites++;
+                return static_cast<Unary*>(operand)->expr;
+            }
+            break;
+        default: {}
+    }
+    return tree;
+}
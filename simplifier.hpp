@@ -0,0 +1,31 @@
+#ifndef SIMPLIFIER_H_INCLUDED
+#define SIMPLIFIER_H_INCLUDED
+
+#include <ostream>
+#include "syntax_tree.hpp"
+
+// Rewrites arithmetic of a type checked tree into cheaper equivalents:
+// identities like `x * 1` and `x + 0` become `x`, `x * 8` a shift,
+// `x ** 2` a multiplication and double negations disappear
+// Only operators whose int operands the TypeChecker proved are touched,
+// every rewrite gives the same value and the same errors at run time
+// Statements that never run or whose values go unused without effects
+// are removed
+class Simplifier {
+    // Nodes replaced so far, for --stats
+    size_t rewrites = 0;
+    size_t statements_removed = 0;
+
+    TreeBase* simplify(TreeBase* tree) noexcept;
+    void simplify_block(Block* tree) noexcept;
+    void remove_unused(std::vector<Statement*>& statements, const Statement* keep) noexcept;
+    TreeBase* simplify_binary(Binary* tree) noexcept;
+    TreeBase* simplify_unary(Unary* tree) noexcept;
+
+public:
+    // tree must have passed the TypeChecker, engines run it afterwards
+    void run(TreeBase* tree) noexcept;
+    void report_statistics(std::ostream& os) const noexcept;
+};
+
+#endif
@@ -1,5 +1,32 @@
 #include "syntax_tree.hpp"
 
+static_assert(MemoryStats::TREE_KINDS == static_cast<u8>(TreeKind::GroupedExpression) + 1);
+
+const char* tree_kind_name(TreeKind kind) noexcept {
+    switch (kind) {
+        case TreeKind::Program: return "Program";
+        case TreeKind::Assignment: return "Assignment";
+        case TreeKind::Return: return "Return";
+        case TreeKind::Print: return "Print";
+        case TreeKind::VariableDeclaration: return "VariableDeclaration";
+        case TreeKind::Cast: return "Cast";
+        case TreeKind::Block: return "Block";
+        case TreeKind::Logical: return "Logical";
+        case TreeKind::Bitwise: return "Bitwise";
+        case TreeKind::Equality: return "Equality";
+        case TreeKind::Comparison: return "Comparison";
+        case TreeKind::Shift: return "Shift";
+        case TreeKind::Term: return "Term";
+        case TreeKind::Factor: return "Factor";
+        case TreeKind::Exponential: return "Exponential";
+        case TreeKind::Unary: return "Unary";
+        case TreeKind::Literal: return "Literal";
+        case TreeKind::Name: return "Name";
+        case TreeKind::GroupedExpression: return "GroupedExpression";
+    }
+    return "?";
+}
+
 std::string Assignment::to_string() const noexcept {
     return std::format(
         "{} = {};", name.value, expr->to_string()
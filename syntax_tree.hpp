@@ -5,10 +5,57 @@
 #include "token.hpp"
 #include "object.hpp"
 #include "typing.hpp"
+#include "value.hpp"
 #include "visitor.hpp"
 
+// Concrete class of a node, lets evaluation fast paths and passes
+// switch on a node instead of probing it with dynamic_cast
+enum class TreeKind : u8 {
+    Program,
+    Assignment,
+    Return,
+    Print,
+    VariableDeclaration,
+    Cast,
+    Block,
+    Logical,
+    Bitwise,
+    Equality,
+    Comparison,
+    Shift,
+    Term,
+    Factor,
+    Exponential,
+    Unary,
+    Literal,
+    Name,
+    GroupedExpression,
+};
+
+// Class name of the kind, for reports
+const char* tree_kind_name(TreeKind kind) noexcept;
+
+// Allocations of a node class counted under its kind for --mem-stats
+#define TREE_ALLOCATION(kind) ACCOUNTED_ALLOCATION( \
+    static_cast<MemoryStats::Category>(MemoryStats::TREE + static_cast<u8>(TreeKind::kind)) \
+)
+
+// Operand types proven by the TypeChecker before evaluation
+enum class Operands : u8 {
+    Unknown,
+    // int operands, either may still be a big integer
+    Integers,
+    Floats,
+    // An int and a float
+    Numbers,
+};
+
 class TreeBase {
 public:
+    const TreeKind kind;
+    // Source line counting from 1, 0 when unknown
+    size_t line = 0;
+    TreeBase(TreeKind _kind): kind{_kind} {}
     ~TreeBase() = default;
     virtual std::string to_string() const noexcept = 0;
     virtual InterpreterResult accept(Visitor* visitor) = 0;
@@ -22,72 +69,95 @@ class Statement;
 
 class Program: public TreeBase {
 public:
+    TREE_ALLOCATION(Program)
+
     std::vector<Statement*> statements;
+    Program(): TreeBase{TreeKind::Program} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Statement: public TreeBase {
 public:
+    using TreeBase::TreeBase;
     ~Statement() = default;
 };
 
 class Expression: public Statement {
 public:
+    using Statement::Statement;
     ~Expression() = default;
 };
 
 class Assignment: public Expression {
 public:
+    TREE_ALLOCATION(Assignment)
+
     Token name;
     Expression* expr;
     Assignment(Token _name, Expression* _expr):
-        name{_name}, expr{_expr} {}
+        Expression{TreeKind::Assignment}, name{_name}, expr{_expr} { line = _name.line + 1; }
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Return: public Statement {
 public:
+    TREE_ALLOCATION(Return)
+
     Expression* expr;
-    Return(Expression* e): expr{e} {}
+    Return(Expression* e): Statement{TreeKind::Return}, expr{e} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Print: public Statement {
 public:
+    TREE_ALLOCATION(Print)
+
     Expression* expr;
-    Print(Expression* e): expr{e} {}
+    Print(Expression* e): Statement{TreeKind::Print}, expr{e} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class VariableDeclaration: public Statement {
 public:
+    TREE_ALLOCATION(VariableDeclaration)
+
     using initializer = std::pair<std::string, TreeBase*>;
     using var_value_pairs = std::vector<initializer>;
     Type* target_type;
     var_value_pairs pairs;
     VariableDeclaration(Type* _type, var_value_pairs list):
-        target_type{_type}, pairs{list} {}
+        Statement{TreeKind::VariableDeclaration}, target_type{_type}, pairs{list} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Cast: public Expression {
 public:
+    TREE_ALLOCATION(Cast)
+
     Type* target_type;
     Expression* casted_expr;
     Cast(Type* to_type, Expression* expr):
-        target_type{to_type}, casted_expr{expr} {}
+        Expression{TreeKind::Cast}, target_type{to_type}, casted_expr{expr} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Block: public Expression {
 public:
+    TREE_ALLOCATION(Block)
+
     std::vector<Statement*> statements;
+    // Set by the parser, blocks without declarations need no scope
+    bool declares_variables = false;
+    // Set by the parser, statements after the first return stay for the
+    // TypeChecker until the Simplifier drops them
+    bool has_return = false;
+    Block(): Expression{TreeKind::Block} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
@@ -97,90 +167,140 @@ public:
     TreeBase* left;
     Token op;
     TreeBase* right;
-    Binary(TreeBase* lhs, Token _op, TreeBase* rhs):
-        left{lhs}, op{_op}, right{rhs} {}
+    Operands operands = Operands::Unknown;
+
+    // Quickening, the interpreter installs a kernel specialized for the
+    // operand tags it observed, guarded by those tags
+    // Kernels return false for results they can not produce (overflow...)
+    using Kernel = bool (*)(const Value& left, const Value& right, Value& value) noexcept;
+    Kernel kernel = nullptr;
+    ValueTag left_tag = ValueTag::OBJECT;
+    ValueTag right_tag = ValueTag::OBJECT;
+    // Times a kernel was installed, stays generic after a few misses
+    u8 specializations = 0;
+    // Nodes whose operand tags keep changing stop being specialized
+    static constexpr u8 MAX_SPECIALIZATIONS = 3;
+    // Kernel chosen before any run by Interpreter::freeze, runs never
+    // write to the node
+    static constexpr u8 FROZEN = UINT8_MAX;
+
+    Binary(TreeKind _kind, TreeBase* lhs, Token _op, TreeBase* rhs):
+        Expression{_kind}, left{lhs}, op{_op}, right{rhs} { line = _op.line + 1; }
     std::string to_string() const noexcept override;
 };
 
 class Logical: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Logical)
+
+    Logical(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Logical, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Bitwise: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Bitwise)
+
+    Bitwise(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Bitwise, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Equality: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Equality)
+
+    Equality(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Equality, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Comparison: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Comparison)
+
+    Comparison(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Comparison, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Shift: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Shift)
+
+    Shift(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Shift, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Term: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Term)
+
+    Term(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Term, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Factor: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Factor)
+
+    Factor(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Factor, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Exponential: public Binary {
 public:
-    using Binary::Binary;
+    TREE_ALLOCATION(Exponential)
+
+    Exponential(TreeBase* lhs, Token _op, TreeBase* rhs):
+        Binary{TreeKind::Exponential, lhs, _op, rhs} {}
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Unary: public Expression {
 public:
+    TREE_ALLOCATION(Unary)
+
     Token unary_op;
     TreeBase* expr;
+    Operands operands = Operands::Unknown;
     Unary(Token op, TreeBase* node):
-        unary_op{op}, expr{node} {}
+        Expression{TreeKind::Unary}, unary_op{op}, expr{node} { line = op.line + 1; }
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Literal: public Expression {
 public:
+    TREE_ALLOCATION(Literal)
+
     Object* value_object;
-    Literal(Object* val): value_object{val} {}
+    Literal(Object* val): Expression{TreeKind::Literal}, value_object{val} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class Name: public Expression {
 public:
+    TREE_ALLOCATION(Name)
+
     std::string name_str;
-    Name(std::string _str): name_str{_str} {}
+    Name(std::string _str): Expression{TreeKind::Name}, name_str{_str} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
 
 class GroupedExpression: public Expression {
 public:
+    TREE_ALLOCATION(GroupedExpression)
+
     TreeBase* grouped_expr;
     GroupedExpression(TreeBase* expr):
-        grouped_expr{expr} {}
+        Expression{TreeKind::GroupedExpression}, grouped_expr{expr} {}
     std::string to_string() const noexcept override;
     InterpreterResult accept(Visitor* visitor) override;
 };
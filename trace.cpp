@@ -0,0 +1,85 @@
+#include <unistd.h>
+#include "trace.hpp"
+
+void Tracer::enable(bool with_statements) noexcept {
+    origin = std::chrono::steady_clock::now();
+    on = true;
+    statements = with_statements;
+}
+
+Tracer::Total& Tracer::total(const char* category, const char* name) {
+    auto [found, added] = total_index.try_emplace(name, totals.size());
+    if (added)
+        totals.emplace_back(name, Total{category, 0, 0, {}});
+    return totals[found->second].second;
+}
+
+void Tracer::record(const char* category, const char* name, u64 start_ns, size_t line) {
+    const u64 duration = now() - start_ns;
+    events.push_back(Event{category, name, start_ns, duration, line});
+    Total& sum = total(category, name);
+    sum.count++;
+    sum.ns += duration;
+}
+
+void Tracer::record_counts(const char* category, const char* name, const PerfCounters::Reading& start) {
+    const PerfCounters::Reading taken = PerfCounters::difference(counters->read(), start);
+    Total& sum = total(category, name);
+    for (size_t i = 0; i < PerfCounters::EVENTS; i++)
+        sum.counts[i] += taken[i];
+}
+
+// Complete events ("ph": "X") in microseconds
+void Tracer::write_chrome_trace(std::ostream& os) const {
+    const int pid = getpid();
+    os << "{\"traceEvents\": [";
+    for (size_t i = 0; i < events.size(); i++) {
+        const Event& event = events[i];
+        os << std::format(
+            "{}\n  {{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, "
+            "\"pid\": {}, \"tid\": 1",
+            i ? "," : "", event.name, event.category,
+            event.start_ns / 1e3, event.duration_ns / 1e3, pid
+        );
+        if (event.line)
+            os << std::format(", \"args\": {{\"line\": {}}}", event.line);
+        os << '}';
+    }
+    os << "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
+
+void Tracer::report_summary(std::ostream& os) const {
+    const double elapsed = now() / 1e6;
+    os << std::format("{:<36}{:>10}{:>12}{:>8}\n", "phase", "calls", "ms", "%");
+    for (const auto& [name, sum] : totals) {
+        const double ms = sum.ns / 1e6;
+        os << std::format(
+            "{:<36}{:>10}{:>12.3f}{:>7.1f}%\n",
+            std::format("{}/{}", sum.category, name), sum.count, ms,
+            elapsed > 0 ? ms / elapsed * 100 : 0
+        );
+    }
+    os << std::format("{:<36}{:>10}{:>12.3f}\n", "total", "", elapsed);
+    if (!counters || !counters->available())
+        return;
+    // Nested phases are counted in their parents too, like their time
+    os << std::format("\n{:<36}", "phase");
+    for (const char* event : PerfCounters::NAMES)
+        os << std::format("{:>15}", event);
+    os << std::format("{:>7}\n", "IPC");
+    for (const auto& [name, sum] : totals) {
+        if (sum.counts == PerfCounters::Reading{})
+            continue;
+        os << std::format("{:<36}", std::format("{}/{}", sum.category, name));
+        for (u8 i = 0; i < PerfCounters::EVENTS; i++) {
+            if (counters->has(static_cast<PerfCounters::Event>(i)))
+                os << std::format("{:>15}", sum.counts[i]);
+            else
+                os << std::format("{:>15}", "-");
+        }
+        const u64 cycles = sum.counts[PerfCounters::CYCLES];
+        if (cycles)
+            os << std::format("{:>7.2f}", static_cast<double>(sum.counts[PerfCounters::INSTRUCTIONS]) / cycles);
+        os << '\n';
+    }
+}
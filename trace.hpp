@@ -0,0 +1,111 @@
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include <chrono>
+#include <map>
+#include "common.hpp"
+#include "counters.hpp"
+
+// Phase timers for --trace and --time, nothing is recorded until enable()
+// Every scope becomes a Chrome trace event (chrome://tracing or
+// ui.perfetto.dev) and its time is summed per name for the summary
+// With counters, phases also sum the hardware events they took
+// Built with -DNO_TRACING the TRACE_* macros expand to nothing
+class Tracer {
+public:
+    struct Event {
+        const char* category;
+        const char* name;
+        u64 start_ns;
+        u64 duration_ns;
+        // Source line of a statement event, 0 for phases
+        size_t line;
+    };
+
+    struct Total {
+        const char* category;
+        u64 count;
+        u64 ns;
+        PerfCounters::Reading counts;
+    };
+
+private:
+    static inline bool on = false;
+    static inline bool statements = false;
+    static inline PerfCounters* counters = nullptr;
+    std::chrono::steady_clock::time_point origin{};
+    std::vector<Event> events{};
+    // By name, in the order each first ended
+    std::vector<std::pair<const char*, Total>> totals{};
+    std::map<std::string_view, size_t> total_index{};
+
+    Total& total(const char* category, const char* name);
+
+public:
+    static Tracer* get() {
+        static Tracer* tracer = new Tracer;
+        return tracer;
+    }
+
+    static inline bool enabled() noexcept { return on; }
+    static inline bool tracing_statements() noexcept { return statements; }
+
+    // Statement events are one per top-level statement run, too many for
+    // most traces unless asked for
+    void enable(bool with_statements) noexcept;
+    // Read around every phase from then on
+    inline void use_counters(PerfCounters* _counters) noexcept { counters = _counters; }
+
+    inline u64 now() const noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - origin
+        ).count();
+    }
+
+    void record(const char* category, const char* name, u64 start_ns, size_t line = 0);
+    void record_counts(const char* category, const char* name, const PerfCounters::Reading& start);
+
+    void write_chrome_trace(std::ostream& os) const;
+    void report_summary(std::ostream& os) const;
+
+    // Records the time from its construction to its destruction
+    class Scope {
+        const char* category;
+        const char* name;
+        size_t line;
+        u64 start = 0;
+        bool active;
+        // Statements are too short for counters to tell much
+        bool counting;
+        PerfCounters::Reading start_counts{};
+
+    public:
+        inline Scope(const char* _category, const char* _name, size_t _line = 0) noexcept:
+            category{_category}, name{_name}, line{_line},
+            active{on && (_line == 0 || statements)},
+            counting{active && _line == 0 && counters}
+        {
+            if (counting) start_counts = counters->read();
+            if (active) start = get()->now();
+        }
+
+        inline ~Scope() {
+            if (active) get()->record(category, name, start, line);
+            if (counting) get()->record_counts(category, name, start_counts);
+        }
+    };
+};
+
+#ifdef NO_TRACING
+#define TRACE_SCOPE(category, name)
+#define TRACE_STATEMENT(line)
+#else
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(category, name) \
+    Tracer::Scope TRACE_CONCAT(trace_scope_, __LINE__){category, name}
+#define TRACE_STATEMENT(line) \
+    Tracer::Scope TRACE_CONCAT(trace_statement_, __LINE__){"statement", "statement", line}
+#endif
+
+#endif
@@ -0,0 +1,422 @@
+#include "type_checker.hpp"
+
+// Error already reported, stops checking the rest of the statement
+static const std::string REPORTED{};
+
+static inline TypeKind kind_of(const Object* type) noexcept {
+    return static_cast<const Type*>(type)->kind;
+}
+
+static inline bool is_kind(const Object* type, TypeKind kind) noexcept {
+    return type && kind_of(type) == kind;
+}
+
+static inline bool is_numeric(const Object* type) noexcept {
+    return is_kind(type, TypeKind::INTEGER) || is_kind(type, TypeKind::FLOAT);
+}
+
+static inline Operands numeric_operands(const Object* left, const Object* right) noexcept {
+    const bool left_int = is_kind(left, TypeKind::INTEGER);
+    const bool right_int = is_kind(right, TypeKind::INTEGER);
+    if (left_int && right_int)
+        return Operands::Integers;
+    if (!left_int && !right_int)
+        return Operands::Floats;
+    return Operands::Numbers;
+}
+
+static InterpreterResult no_value(const std::string& where) {
+    return InterpreterResult::Error(
+        "Expression without a value used as " + where
+    );
+}
+
+size_t TypeChecker::check(TreeBase* tree) noexcept {
+    errors_count = 0;
+    scopes.clear();
+    // Names declared by tree at top level
+    scopes.emplace_back();
+    check_statement(tree);
+    return errors_count;
+}
+
+void TypeChecker::report_error(const std::string& msg) noexcept {
+    errors_count++;
+    *diagnostics << "Type error: " << msg << '\n' ;
+}
+
+Type* TypeChecker::lookup(const std::string& name) const noexcept {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); scope++) {
+        auto entry = scope->find(name);
+        if (entry != scope->end())
+            return entry->second;
+    }
+    const Slot* slot = env.find(name);
+    return slot ? slot->type : nullptr;
+}
+
+InterpreterResult TypeChecker::define(const std::string& name, Type* type) noexcept {
+    if (lookup(name)) {
+        return InterpreterResult::Error(
+            std::format("Name `{}` already defined!", name)
+        );
+    }
+    scopes.back()[name] = type;
+    return InterpreterResult::Ok(nullptr);
+}
+
+InterpreterResult TypeChecker::check_statement(TreeBase* tree) noexcept {
+    InterpreterResult result = tree->accept(this);
+    if (result.is_error() && !result.unwrap_error().empty()) {
+        report_error(result.unwrap_error());
+        return InterpreterResult::Error(REPORTED);
+    }
+    return result;
+}
+
+InterpreterResult TypeChecker::check_assignable(
+    const std::string& name, Type* target, Object* source
+) noexcept {
+    if (!source) {
+        return InterpreterResult::Error(
+            std::format("Assigning an expression without a value to `{}`", name)
+        );
+    }
+    const TypeKind source_kind = kind_of(source);
+    // Same conversion Environment::store does
+    if (
+        source_kind == target->kind ||
+        (source_kind == TypeKind::INTEGER && target->kind == TypeKind::FLOAT)
+    ) {
+        return InterpreterResult::Ok(nullptr);
+    }
+    return InterpreterResult::Error(
+        std::format(
+            "Can not assign value of type `{}` to `{}` variable `{}`",
+            static_cast<Type*>(source)->type_name, target->type_name, name
+        )
+    );
+}
+
+InterpreterResult TypeChecker::check_numeric(
+    Binary* tree, Object* left, Object* right
+) noexcept {
+    if (!left || !right)
+        return no_value("operand of " + tree->op.value);
+    if (!is_numeric(left)) {
+        return InterpreterResult::Error(
+            "Left operand of operator " + tree->op.value + " is not numeric"
+        );
+    }
+    if (!is_numeric(right)) {
+        return InterpreterResult::Error(
+            "right operand of operator " + tree->op.value + " is not numeric"
+        );
+    }
+    tree->operands = numeric_operands(left, right);
+    return InterpreterResult::Ok(nullptr);
+}
+
+InterpreterResult TypeChecker::visit_program(Program* tree) {
+    for (Statement* stmt : tree->statements)
+        check_statement(stmt);
+    return InterpreterResult::Ok(nullptr);
+}
+
+InterpreterResult TypeChecker::visit_literal(Literal* tree) {
+    return InterpreterResult::Ok(tree->value_object->type_info);
+}
+
+InterpreterResult TypeChecker::visit_grouped_expression(GroupedExpression* tree) {
+    return tree->grouped_expr->accept(this);
+}
+
+InterpreterResult TypeChecker::visit_unary(Unary* tree) {
+    InterpreterResult operand = tree->expr->accept(this);
+    if (operand.is_error())
+        return operand;
+    Object* type = operand.unwrap();
+    if (!type)
+        return no_value("operand of unary " + tree->unary_op.value);
+    switch (tree->unary_op.ttype) {
+        case TokenType::BANG:
+            if (!is_kind(type, TypeKind::BOOLEAN))
+                return InterpreterResult::Error("Unary logical operator ! applied to non-boolean");
+            return operand;
+        case TokenType::MINUS:
+        case TokenType::PLUS:
+            if (!is_numeric(type)) {
+                return InterpreterResult::Error(
+                    "Unary arithmetic operator " + tree->unary_op.value + " applied to non-numeric"
+                );
+            }
+            tree->operands = numeric_operands(type, type);
+            return operand;
+        case TokenType::TILDE:
+            if (!is_kind(type, TypeKind::INTEGER))
+                return InterpreterResult::Error("Unary bitwise operator ~ applied to non-integer");
+            tree->operands = Operands::Integers;
+            return operand;
+        default: {}
+    }
+    return InterpreterResult::Error(
+        "Invalid unary operator " + tree->unary_op.value
+    );
+}
+
+InterpreterResult TypeChecker::visit_exponential(Exponential* tree) {
+    InterpreterResult base = tree->left->accept(this);
+    if (base.is_error())
+        return base;
+    InterpreterResult exponent = tree->right->accept(this);
+    if (exponent.is_error())
+        return exponent;
+    if (!base.unwrap() || !exponent.unwrap())
+        return no_value("operand of **");
+    if (!is_numeric(base.unwrap()))
+        return InterpreterResult::Error("Numeric operator ** used with non-numeric base");
+    if (!is_numeric(exponent.unwrap()))
+        return InterpreterResult::Error("Numeric operator ** used with non-numeric exponent");
+    tree->operands = numeric_operands(base.unwrap(), exponent.unwrap());
+    if (tree->operands == Operands::Integers)
+        return InterpreterResult::Ok(TypeInteger::get_type_object());
+    return InterpreterResult::Ok(TypeFloat::get_type_object());
+}
+
+InterpreterResult TypeChecker::visit_factor(Factor* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    InterpreterResult numeric = check_numeric(tree, left.unwrap(), right.unwrap());
+    if (numeric.is_error())
+        return numeric;
+    const bool integers = tree->operands == Operands::Integers;
+    switch (tree->op.ttype) {
+        case TokenType::STAR:
+            if (integers)
+                return InterpreterResult::Ok(TypeInteger::get_type_object());
+            return InterpreterResult::Ok(TypeFloat::get_type_object());
+        case TokenType::SLASH:
+            return InterpreterResult::Ok(TypeFloat::get_type_object());
+        case TokenType::DOUBLE_SLASH:
+            return InterpreterResult::Ok(TypeInteger::get_type_object());
+        case TokenType::PERCENT:
+            if (!integers) {
+                return InterpreterResult::Error(
+                    "Applying mod operator % with a non-integer operand"
+                );
+            }
+            return InterpreterResult::Ok(TypeInteger::get_type_object());
+        default: {}
+    }
+    return InterpreterResult::Error(
+        "Invalid binary operator " + tree->op.value + " for numeric operands"
+    );
+}
+
+InterpreterResult TypeChecker::visit_term(Term* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    if (
+        left.unwrap() && right.unwrap() &&
+        (is_kind(left.unwrap(), TypeKind::STRING) || is_kind(right.unwrap(), TypeKind::STRING))
+    ) {
+        // Concatenation, the other operand is converted
+        return InterpreterResult::Ok(TypeString::get_type_object());
+    }
+    InterpreterResult numeric = check_numeric(tree, left.unwrap(), right.unwrap());
+    if (numeric.is_error())
+        return numeric;
+    if (tree->operands == Operands::Integers)
+        return InterpreterResult::Ok(TypeInteger::get_type_object());
+    return InterpreterResult::Ok(TypeFloat::get_type_object());
+}
+
+InterpreterResult TypeChecker::visit_comparison(Comparison* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    InterpreterResult numeric = check_numeric(tree, left.unwrap(), right.unwrap());
+    if (numeric.is_error())
+        return numeric;
+    return InterpreterResult::Ok(TypeBoolean::get_type_object());
+}
+
+InterpreterResult TypeChecker::visit_shift(Shift* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    if (!left.unwrap() || !right.unwrap())
+        return no_value("operand of " + tree->op.value);
+    if (!is_kind(left.unwrap(), TypeKind::INTEGER))
+        return InterpreterResult::Error("Can not shift a non-integer value");
+    if (!is_kind(right.unwrap(), TypeKind::INTEGER))
+        return InterpreterResult::Error("Shift count is not an integer");
+    tree->operands = Operands::Integers;
+    return left;
+}
+
+InterpreterResult TypeChecker::visit_equality(Equality* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    if (!left.unwrap() || !right.unwrap())
+        return no_value("operand of " + tree->op.value);
+    return InterpreterResult::Ok(TypeBoolean::get_type_object());
+}
+
+InterpreterResult TypeChecker::visit_bitwise(Bitwise* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    if (!left.unwrap() || !right.unwrap())
+        return no_value("operand of " + tree->op.value);
+    if (
+        !is_kind(left.unwrap(), TypeKind::INTEGER) ||
+        !is_kind(right.unwrap(), TypeKind::INTEGER)
+    ) {
+        return InterpreterResult::Error(
+            "Applying bitwise `" + tree->op.value + "` to non-integer operands"
+        );
+    }
+    tree->operands = Operands::Integers;
+    return left;
+}
+
+InterpreterResult TypeChecker::visit_logical(Logical* tree) {
+    InterpreterResult left = tree->left->accept(this);
+    if (left.is_error())
+        return left;
+    InterpreterResult right = tree->right->accept(this);
+    if (right.is_error())
+        return right;
+    // Operands count by their truthiness, any value will do
+    if (!left.unwrap() || !right.unwrap())
+        return no_value("operand of " + tree->op.value);
+    return InterpreterResult::Ok(TypeBoolean::get_type_object());
+}
+
+InterpreterResult TypeChecker::visit_block(Block* tree) {
+    if (tree->statements.empty())
+        return InterpreterResult::Ok(nullptr);
+    if (tree->declares_variables)
+        scopes.emplace_back();
+    Object* type = TypeVoid::get_type_object();
+    bool returned = false, failed = false;
+    for (Statement* stmt : tree->statements) {
+        InterpreterResult result = check_statement(stmt);
+        if (result.is_error()) {
+            failed = true;
+        } else if (stmt->kind == TreeKind::Return && !returned) {
+            // The first return decides the value of the block
+            type = result.unwrap();
+            returned = true;
+        }
+    }
+    if (tree->declares_variables)
+        scopes.pop_back();
+    if (failed)
+        return InterpreterResult::Error(REPORTED);
+    return InterpreterResult::Ok(type);
+}
+
+InterpreterResult TypeChecker::visit_cast(Cast* tree) {
+    InterpreterResult operand = tree->casted_expr->accept(this);
+    if (operand.is_error())
+        return operand;
+    if (!operand.unwrap())
+        return no_value("operand of a cast");
+    const Type* source = static_cast<Type*>(operand.unwrap());
+    if (!tree->target_type->castable_from(source)) {
+        return InterpreterResult::Error(
+            std::format(
+                "Object of type `{}` can not be casted to object of type `{}`",
+                source->to_string(),
+                tree->target_type->to_string()
+            )
+        );
+    }
+    return InterpreterResult::Ok(tree->target_type);
+}
+
+InterpreterResult TypeChecker::visit_variable_declaration(VariableDeclaration* tree) {
+    bool failed = false;
+    for (const auto& [name, initializer] : tree->pairs) {
+        InterpreterResult result = define(name, tree->target_type);
+        if (result.is_ok() && initializer) {
+            result = initializer->accept(this);
+            if (result.is_ok())
+                result = check_assignable(name, tree->target_type, result.unwrap());
+        }
+        if (result.is_error()) {
+            if (!result.unwrap_error().empty())
+                report_error(result.unwrap_error());
+            failed = true;
+        }
+    }
+    if (failed)
+        return InterpreterResult::Error(REPORTED);
+    return InterpreterResult::Ok(nullptr);
+}
+
+InterpreterResult TypeChecker::visit_print(Print* tree) {
+    if (tree->expr) {
+        InterpreterResult operand = tree->expr->accept(this);
+        if (operand.is_error())
+            return operand;
+        if (!operand.unwrap())
+            return no_value("operand of print");
+    }
+    return InterpreterResult::Ok(nullptr);
+}
+
+InterpreterResult TypeChecker::visit_return(Return* tree) {
+    return tree->expr->accept(this);
+}
+
+InterpreterResult TypeChecker::visit_name(Name* tree) {
+    Type* type = lookup(tree->name_str);
+    if (!type) {
+        return InterpreterResult::Error(
+            std::format("Name `{}` not defined!", tree->name_str)
+        );
+    }
+    return InterpreterResult::Ok(type);
+}
+
+InterpreterResult TypeChecker::visit_assignment(Assignment* tree) {
+    Type* target = lookup(tree->name.value);
+    if (!target) {
+        return InterpreterResult::Error(
+            std::format("Name `{}` not defined!", tree->name.value)
+        );
+    }
+    InterpreterResult value = tree->expr->accept(this);
+    if (value.is_error())
+        return value;
+    InterpreterResult assignable =
+        check_assignable(tree->name.value, target, value.unwrap());
+    if (assignable.is_error())
+        return assignable;
+    // Assignments produce no value
+    return InterpreterResult::Ok(nullptr);
+}
@@ -0,0 +1,64 @@
+#ifndef TYPE_CHECKER_H_INCLUDED
+#define TYPE_CHECKER_H_INCLUDED
+
+#include <unordered_map>
+#include "environment.hpp"
+#include "syntax_tree.hpp"
+
+// Runs over a whole tree before the interpreter does
+// Each visit returns the Type of the expression as an Object, nullptr for
+// expressions without a value, errors are reported and checking goes on
+// with the next statement
+// Operators whose operand types are proven get their `operands` tagged
+class TypeChecker: public Visitor {
+    using Scope = std::unordered_map<std::string, Type*>;
+
+    // Names declared by interpretations that already ran
+    const Environment& env;
+    std::vector<Scope> scopes{};
+    size_t errors_count = 0;
+    std::ostream* diagnostics = &std::cerr;
+
+    Type* lookup(const std::string& name) const noexcept;
+    InterpreterResult define(const std::string& name, Type* type) noexcept;
+    InterpreterResult check_statement(TreeBase* tree) noexcept;
+    InterpreterResult check_assignable(
+        const std::string& name, Type* target, Object* source
+    ) noexcept;
+    InterpreterResult check_numeric(
+        Binary* tree, Object* left, Object* right
+    ) noexcept;
+
+public:
+    TypeChecker(const Environment& _env): env{_env} {}
+
+    // Type errors are written there instead of std::cerr
+    inline void use_diagnostics(std::ostream& os) noexcept { diagnostics = &os; }
+
+    // Number of type errors found in tree
+    size_t check(TreeBase* tree) noexcept;
+    inline size_t errors() const noexcept { return errors_count; }
+    void report_error(const std::string& msg) noexcept;
+
+    InterpreterResult visit_program(Program* tree);
+    InterpreterResult visit_literal(Literal* tree);
+    InterpreterResult visit_grouped_expression(GroupedExpression* tree);
+    InterpreterResult visit_unary(Unary* tree);
+    InterpreterResult visit_exponential(Exponential* tree);
+    InterpreterResult visit_factor(Factor* tree);
+    InterpreterResult visit_term(Term* tree);
+    InterpreterResult visit_comparison(Comparison* tree);
+    InterpreterResult visit_shift(Shift* tree);
+    InterpreterResult visit_equality(Equality* tree);
+    InterpreterResult visit_bitwise(Bitwise* tree);
+    InterpreterResult visit_logical(Logical* tree);
+    InterpreterResult visit_block(Block* tree);
+    InterpreterResult visit_cast(Cast* tree);
+    InterpreterResult visit_variable_declaration(VariableDeclaration* tree);
+    InterpreterResult visit_print(Print* tree);
+    InterpreterResult visit_return(Return* tree);
+    InterpreterResult visit_name(Name* tree);
+    InterpreterResult visit_assignment(Assignment* tree);
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <charconv>
+#include <new>
 #include "typing.hpp"
 #include "token.hpp"
 
@@ -8,26 +10,71 @@ const std::string TypeString::NAME = "string";
 const std::string TypeFloat::NAME = "float";
 const std::string TypeInteger::NAME = "int";
 
+// Characters allocated apart from the string, none when short enough to
+// be stored in it
+static u64 characters_bytes(const std::string& s) noexcept {
+    static const size_t inline_capacity = std::string{}.capacity();
+    return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+static void count_characters(const std::string& s) noexcept {
+    if (u64 bytes = characters_bytes(s))
+        MemoryStats::allocated(MemoryStats::STRING_CHARACTERS, bytes);
+}
+
 ObjectString::ObjectString(): std::string() {
     type_info = TypeString::get_type_object();
 }
 
 ObjectString::ObjectString(const char* s): std::string(s) {
     type_info = TypeString::get_type_object();
+    count_characters(*this);
 }
 
 ObjectString::ObjectString(const char* s, size_t len):
-    std::string(s, len) {type_info = TypeString::get_type_object();}
+    std::string(s, len) {type_info = TypeString::get_type_object(); count_characters(*this);}
 
 ObjectString::ObjectString(const std::string& s):
-    std::string(s) {type_info = TypeString::get_type_object();}
+    std::string(s) {type_info = TypeString::get_type_object(); count_characters(*this);}
 
 ObjectString::ObjectString(const std::string&& s):
-    std::string(s) {type_info = TypeString::get_type_object();}
+    std::string(s) {type_info = TypeString::get_type_object(); count_characters(*this);}
+
+ObjectString::~ObjectString() {
+    if (u64 bytes = characters_bytes(*this))
+        MemoryStats::freed(MemoryStats::STRING_CHARACTERS, bytes);
+}
 
 ObjectInteger::ObjectInteger(const i64& value):
     Number::Number(value) {type_info = TypeInteger::get_type_object();}
 
+// Defined here rather than in object.cpp so the type objects
+// their constructors refer to are set up first
+static ObjectInteger* make_small_integers() {
+    constexpr i64 count = SMALL_INTEGER_MAX - SMALL_INTEGER_MIN + 1;
+    ObjectInteger* cache = static_cast<ObjectInteger*>(
+        ::operator new(count * sizeof(ObjectInteger))
+    );
+    for (i64 value = SMALL_INTEGER_MIN; value <= SMALL_INTEGER_MAX; value++)
+        new (&cache[value - SMALL_INTEGER_MIN]) ObjectInteger{value};
+    return cache;
+}
+
+ObjectInteger* ObjectInteger::SMALL_INTEGERS = make_small_integers();
+
+ObjectFloat* ObjectFloat::ZERO = new ObjectFloat{0.0};
+ObjectFloat* ObjectFloat::ONE = new ObjectFloat{1.0};
+
+ObjectBigInteger::ObjectBigInteger(BigInteger&& val):
+    value{std::move(val)} {
+    type_info = TypeInteger::get_type_object();
+    MemoryStats::allocated(MemoryStats::BIG_INTEGER_LIMBS, value.heap_bytes());
+}
+
+ObjectBigInteger::~ObjectBigInteger() {
+    MemoryStats::freed(MemoryStats::BIG_INTEGER_LIMBS, value.heap_bytes());
+}
+
 ObjectFloat::ObjectFloat(const float64& value):
     Number::Number(value) {type_info = TypeFloat::get_type_object();}
 
@@ -56,6 +103,18 @@ ObjectBoolean* ObjectBoolean::equals(const Object* other) const noexcept {
     );
 }
 
+ObjectBoolean* ObjectBigInteger::equals(const Object* other) const noexcept {
+    const ObjectBigInteger* big =
+        dynamic_cast<const ObjectBigInteger*>(other);
+    if (big)
+        return ObjectBoolean::as_object(this->value == big->value);
+    const ObjectFloat* float_obj =
+        dynamic_cast<const ObjectFloat*>(other);
+    return ObjectBoolean::as_object(
+        float_obj && this->value.to_float64() == float_obj->value
+    );
+}
+
 ObjectBoolean* ObjectVoid::equals(const Object* other) const noexcept {
     // There is only one (void)
     return ObjectBoolean::as_object(
@@ -80,10 +139,6 @@ ObjectBoolean* Type::to_boolean() const noexcept {
     return ObjectBoolean::TRUE;
 }
 
-Object* Type::cast(const Object* obj) const noexcept {
-    return obj->type_info;
-}
-
 Type* Type::get_type_by_token(TokenType type_keyword) {
     switch (type_keyword) {
         case TokenType::KEYWORD_TYPE:
@@ -103,70 +158,169 @@ Type* Type::get_type_by_token(TokenType type_keyword) {
     return nullptr;
 }
 
-ObjectInteger* TypeInteger::cast(const Object* obj) const noexcept {
-    const std::string& obj_type_name = obj->type_info->type_name;
-    if (obj_type_name == TypeVoid::NAME) {
-        return new ObjectInteger{0};
-    } else if (obj_type_name == TypeFloat::NAME) {
-        const ObjectFloat* _obj =
-            reinterpret_cast<const ObjectFloat*>(obj);
-        return new ObjectInteger{
-            static_cast<i64>(_obj->value)
-        };
-    } else if (obj_type_name == TypeString::NAME) {
-        const ObjectString* _obj =
-            reinterpret_cast<const ObjectString*>(obj);
-        return new ObjectInteger{
-            std::stoll(std::string(_obj->c_str(), _obj->size()))
-        };
-    } else if (obj_type_name == TypeBoolean::NAME) {
-        const ObjectBoolean* _obj =
-            reinterpret_cast<const ObjectBoolean*>(obj);
-        return new ObjectInteger{
-            static_cast<i64>(_obj->value)
-        };
-    } else if (obj_type_name == Type::NAME) {
-        return nullptr;
+// ------------------------- Casting -------------------------
+
+using CastFunction = CastResult (*)(const Type* target, const Object* obj);
+
+static CastResult cast_invalid(const Type* target, const Object* obj) {
+    return CastResult::Error(
+        std::format(
+            "Object of type `{}` can not be casted to object of type `{}`",
+            obj->type_info->to_string(),
+            target->to_string()
+        )
+    );
+}
+
+static CastResult cast_identity(const Type*, const Object* obj) {
+    // Objects are never mutated, the same instance serves as the result
+    return CastResult::Ok(const_cast<Object*>(obj));
+}
+
+static CastResult cast_to_type(const Type*, const Object* obj) {
+    return CastResult::Ok(obj->type_info);
+}
+
+static CastResult cast_to_void(const Type*, const Object*) {
+    return CastResult::Ok(ObjectVoid::VOID_OBJECT);
+}
+
+static CastResult cast_to_boolean(const Type*, const Object* obj) {
+    return CastResult::Ok(obj->to_boolean());
+}
+
+static CastResult cast_to_string(const Type*, const Object* obj) {
+    return CastResult::Ok(new ObjectString(obj->to_string()));
+}
+
+static CastResult cast_void_to_integer(const Type*, const Object*) {
+    return CastResult::Ok(ObjectInteger::make(0));
+}
+
+static CastResult cast_boolean_to_integer(const Type*, const Object* obj) {
+    return CastResult::Ok(
+        ObjectInteger::make(
+            static_cast<i64>(static_cast<const ObjectBoolean*>(obj)->value)
+        )
+    );
+}
+
+static CastResult cast_float_to_integer(const Type*, const Object* obj) {
+    float64 value = static_cast<const ObjectFloat*>(obj)->value;
+    if (!std::isfinite(value)) {
+        return CastResult::Error(
+            std::format("Float value {} can not be casted to `int`", obj->to_string())
+        );
     }
-    return reinterpret_cast<ObjectInteger*>(obj->copy());
-}
-
-ObjectFloat* TypeFloat::cast(const Object* obj) const noexcept {
-    const std::string& obj_type_name = obj->type_info->type_name;
-    if (obj_type_name == TypeVoid::NAME) {
-        return new ObjectFloat{0.0};
-    } else if (obj_type_name == TypeInteger::NAME) {
-        const ObjectInteger* _obj =
-            reinterpret_cast<const ObjectInteger*>(obj);
-        return new ObjectFloat{
-            static_cast<float64>(_obj->value)
-        };
-    } else if (obj_type_name == TypeString::NAME) {
-        const ObjectString* _obj =
-            reinterpret_cast<const ObjectString*>(obj);
-        return new ObjectFloat{
-            std::stold(std::string(_obj->c_str(), _obj->size()), nullptr)
-        };
-    } else if (obj_type_name == TypeBoolean::NAME) {
-        const ObjectBoolean* _obj =
-            reinterpret_cast<const ObjectBoolean*>(obj);
-        return new ObjectFloat{
-            static_cast<float64>(_obj->value)
-        };
-    } else if (obj_type_name == Type::NAME) {
-        return nullptr;
+    // Both bounds are exact powers of two, so the comparison is exact too
+    if (value >= -0x1p63L && value < 0x1p63L)
+        return CastResult::Ok(ObjectInteger::make(static_cast<i64>(value)));
+    return CastResult::Ok(
+        ObjectBigInteger::from(BigInteger::from_float64(value))
+    );
+}
+
+// Surrounding whitespace is ignored, as is a leading plus sign
+// std::from_chars understands neither
+static std::string_view numeric_text(const ObjectString* str) {
+    std::string_view text{str->data(), str->size()};
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+        text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+        text.remove_suffix(1);
+    if (text.size() > 1 && text.front() == '+' && text[1] != '-')
+        text.remove_prefix(1);
+    return text;
+}
+
+static CastResult cast_string_to_integer(const Type*, const Object* obj) {
+    const ObjectString* str = static_cast<const ObjectString*>(obj);
+    std::string_view text = numeric_text(str);
+    i64 value = 0;
+    std::from_chars_result r =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    BigInteger big;
+    if (r.ec == std::errc::result_out_of_range && BigInteger::parse(text, big)) {
+        // Well formed, just too long for i64
+        return CastResult::Ok(new ObjectBigInteger{std::move(big)});
+    } else if (r.ec != std::errc{} || text.empty() || r.ptr != text.data() + text.size()) {
+        return CastResult::Error(
+            std::format("String \"{}\" is not a valid `int`", *str)
+        );
     }
-    return reinterpret_cast<ObjectFloat*>(obj->copy());
+    return CastResult::Ok(ObjectInteger::make(value));
+}
+
+static CastResult cast_void_to_float(const Type*, const Object*) {
+    return CastResult::Ok(ObjectFloat::make(0.0));
+}
+
+static CastResult cast_boolean_to_float(const Type*, const Object* obj) {
+    return CastResult::Ok(
+        ObjectFloat::make(
+            static_cast<float64>(static_cast<const ObjectBoolean*>(obj)->value)
+        )
+    );
 }
 
-ObjectString* TypeString::cast(const Object* obj) const noexcept {
-    return new ObjectString(obj->to_string());
+static CastResult cast_integer_to_float(const Type*, const Object* obj) {
+    const ObjectInteger* int_obj =
+        dynamic_cast<const ObjectInteger*>(obj);
+    if (int_obj)
+        return CastResult::Ok(
+            ObjectFloat::make(static_cast<float64>(int_obj->value))
+        );
+    return CastResult::Ok(
+        ObjectFloat::make(
+            static_cast<const ObjectBigInteger*>(obj)->value.to_float64()
+        )
+    );
 }
 
-ObjectBoolean* TypeBoolean::cast(const Object* obj) const noexcept {
-    return obj->to_boolean();
+static CastResult cast_string_to_float(const Type*, const Object* obj) {
+    const ObjectString* str = static_cast<const ObjectString*>(obj);
+    std::string_view text = numeric_text(str);
+    float64 value = 0.0;
+    std::from_chars_result r =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (r.ec == std::errc::result_out_of_range) {
+        return CastResult::Error(
+            std::format("String \"{}\" is out of `float` range", *str)
+        );
+    } else if (r.ec != std::errc{} || text.empty() || r.ptr != text.data() + text.size()) {
+        return CastResult::Error(
+            std::format("String \"{}\" is not a valid `float`", *str)
+        );
+    }
+    return CastResult::Ok(ObjectFloat::make(value));
 }
 
-ObjectVoid* TypeVoid::cast(const Object* obj) const noexcept {
-    return ObjectVoid::VOID_OBJECT;
+// Indexed by [source kind][target kind], follows TypeKind order
+static const CastFunction CAST_TABLE[TYPE_KIND_COUNT][TYPE_KIND_COUNT] = {
+    // type
+    {cast_to_type, cast_to_void, cast_to_boolean, cast_invalid, cast_invalid, cast_to_string},
+    // void
+    {cast_to_type, cast_to_void, cast_to_boolean, cast_void_to_integer, cast_void_to_float, cast_to_string},
+    // boolean
+    {cast_to_type, cast_to_void, cast_identity, cast_boolean_to_integer, cast_boolean_to_float, cast_to_string},
+    // int
+    {cast_to_type, cast_to_void, cast_to_boolean, cast_identity, cast_integer_to_float, cast_to_string},
+    // float
+    {cast_to_type, cast_to_void, cast_to_boolean, cast_float_to_integer, cast_identity, cast_to_string},
+    // string
+    {cast_to_type, cast_to_void, cast_to_boolean, cast_string_to_integer, cast_string_to_float, cast_identity},
+};
+
+CastResult Type::cast(const Object* obj) const noexcept {
+    const size_t source = static_cast<size_t>(obj->type_info->kind);
+    const size_t target = static_cast<size_t>(this->kind);
+    return CAST_TABLE[source][target](this, obj);
 }
+
+bool Type::castable_from(const Type* source) const noexcept {
+    return CAST_TABLE
+        [static_cast<size_t>(source->kind)]
+        [static_cast<size_t>(this->kind)] != cast_invalid;
+}
+
+// ------------------------- Casting -------------------------
@@ -2,11 +2,28 @@
 #define TYPING_H_INCLUDED
 
 #include "object.hpp"
+#include "result.hpp"
 #include "token.hpp"
 
+// Dense index of builtin types, suitable for indexing dispatch tables
+enum class TypeKind : u8 {
+    TYPE = 0,
+    VOID = 1,
+    BOOLEAN = 2,
+    INTEGER = 3,
+    FLOAT = 4,
+    STRING = 5,
+};
+
+constexpr size_t TYPE_KIND_COUNT = 6;
+
+using CastResult =
+    PointerValueResult<Object*/*value type*/, std::string/*error type*/>;
+
 class Type: public Object {
 public:
     std::string type_name = NAME;
+    TypeKind kind = TypeKind::TYPE;
     const static std::string NAME;
     static inline Type* get_type_object() {
         static Type* type_type_object =
@@ -21,7 +38,10 @@ public:
     std::string to_string() const noexcept override;
     ObjectBoolean* to_boolean() const noexcept override;
 
-    virtual Object* cast(const Object* obj) const noexcept;
+    // Convert obj to this type, malformed input is reported as an error
+    CastResult cast(const Object* obj) const noexcept;
+    // False when no value of type source can ever be cast to this type
+    bool castable_from(const Type* source) const noexcept;
 
     static Type* get_type_by_token(TokenType type_keyword);
 };
@@ -29,6 +49,7 @@ public:
 class TypeInteger: public Type {
     TypeInteger(): Type() {
         this->type_name = TypeInteger::NAME;
+        this->kind = TypeKind::INTEGER;
         this->type_info = Type::get_type_object();
     }
 public:
@@ -41,12 +62,12 @@ public:
     TypeInteger* copy() const noexcept override {
         return TypeInteger::get_type_object();
     }
-    ObjectInteger* cast(const Object* obj) const noexcept override;
 };
 
 class TypeFloat: public Type {
     TypeFloat(): Type() {
         this->type_name = TypeFloat::NAME;
+        this->kind = TypeKind::FLOAT;
         this->type_info = Type::get_type_object();
     }
 public:
@@ -59,12 +80,12 @@ public:
     TypeFloat* copy() const noexcept override {
         return TypeFloat::get_type_object();
     }
-    ObjectFloat* cast(const Object* obj) const noexcept override;
 };
 
 class TypeString: public Type {
     TypeString(): Type() {
         this->type_name = TypeString::NAME;
+        this->kind = TypeKind::STRING;
         this->type_info = Type::get_type_object();
     }
 public:
@@ -77,12 +98,12 @@ public:
     TypeString* copy() const noexcept override {
         return TypeString::get_type_object();
     }
-    ObjectString* cast(const Object* obj) const noexcept override;
 };
 
 class TypeBoolean: public Type {
     TypeBoolean(): Type() {
         this->type_name = TypeBoolean::NAME;
+        this->kind = TypeKind::BOOLEAN;
         this->type_info = Type::get_type_object();
     }
 public:
@@ -95,12 +116,12 @@ public:
     TypeBoolean* copy() const noexcept override {
         return TypeBoolean::get_type_object();
     }
-    ObjectBoolean* cast(const Object* obj) const noexcept override;
 };
 
 class TypeVoid: public Type {
     TypeVoid(): Type() {
         this->type_name = TypeVoid::NAME;
+        this->kind = TypeKind::VOID;
         this->type_info = Type::get_type_object();
     }
 public:
@@ -113,7 +134,6 @@ public:
     TypeVoid* copy() const noexcept override {
         return TypeVoid::get_type_object();
     }
-    ObjectVoid* cast(const Object* obj) const noexcept override;
 };
 
 template <typename T>
@@ -133,8 +153,17 @@ ObjectBoolean* Number<T>::equals(const Object* other) const noexcept {
 
     const ObjectFloat* other_float =
         dynamic_cast<const ObjectFloat*>(other);
+    if (other_float)
+        return ObjectBoolean::as_object(
+            this->value == other_float->value
+        );
+
+    // Big integers never equal an i64, floats compare by value
+    const ObjectBigInteger* other_big =
+        static_cast<const ObjectBigInteger*>(other);
     return ObjectBoolean::as_object(
-        this->value == other_float->value
+        std::is_same_v<T, float64> &&
+        this->value == other_big->value.to_float64()
     );
 }
 
@@ -0,0 +1,113 @@
+#ifndef VALUE_H_INCLUDED
+#define VALUE_H_INCLUDED
+
+#include "object.hpp"
+
+enum class ValueTag : u8 {
+    INTEGER,
+    FLOAT,
+    BOOLEAN,
+    // Everything else, strings, types, void and big integers
+    OBJECT,
+};
+
+// Unboxed int, float and boolean values, lets typed variables and the
+// arithmetic on them skip allocating an Object for every intermediate
+struct Value {
+    ValueTag tag = ValueTag::OBJECT;
+    union {
+        i64 integer;
+        float64 real;
+        bool boolean;
+        Object* object = nullptr;
+    };
+
+    static inline Value of_integer(i64 v) noexcept {
+        Value value;
+        value.tag = ValueTag::INTEGER;
+        value.integer = v;
+        return value;
+    }
+
+    static inline Value of_float(float64 v) noexcept {
+        Value value;
+        value.tag = ValueTag::FLOAT;
+        value.real = v;
+        return value;
+    }
+
+    static inline Value of_boolean(bool v) noexcept {
+        Value value;
+        value.tag = ValueTag::BOOLEAN;
+        value.boolean = v;
+        return value;
+    }
+
+    static inline Value of_object(Object* v) noexcept {
+        Value value;
+        value.object = v;
+        return value;
+    }
+
+    // Unboxed form of obj when it has one
+    static inline Value unbox(Object* obj) noexcept {
+        if (!obj)
+            return of_object(nullptr);
+        if (ObjectInteger* int_obj = exact_cast<ObjectInteger>(obj))
+            return of_integer(int_obj->value);
+        if (ObjectFloat* float_obj = exact_cast<ObjectFloat>(obj))
+            return of_float(float_obj->value);
+        if (ObjectBoolean* bool_obj = exact_cast<ObjectBoolean>(obj))
+            return of_boolean(bool_obj->value);
+        return of_object(obj);
+    }
+
+    // Materialize an Object, only needed once a value escapes
+    inline Object* box() const noexcept {
+        switch (tag) {
+            case ValueTag::INTEGER:
+                return ObjectInteger::make(integer);
+            case ValueTag::FLOAT:
+                return ObjectFloat::make(real);
+            case ValueTag::BOOLEAN:
+                return ObjectBoolean::as_object(boolean);
+            default: {}
+        }
+        return object;
+    }
+
+    // Truthiness, same as Object::to_boolean
+    inline bool to_boolean() const noexcept {
+        switch (tag) {
+            case ValueTag::INTEGER:
+                return integer != 0;
+            case ValueTag::FLOAT:
+                return real != 0;
+            case ValueTag::BOOLEAN:
+                return boolean;
+            default: {}
+        }
+        return object->to_boolean()->value;
+    }
+
+    inline bool is_number() const noexcept {
+        return tag == ValueTag::INTEGER || tag == ValueTag::FLOAT;
+    }
+
+    inline float64 as_float64() const noexcept {
+        return tag == ValueTag::INTEGER ? static_cast<float64>(integer) : real;
+    }
+
+    // Same as Object::equals without boxing numbers and booleans
+    inline bool equals(const Value& other) const noexcept {
+        if (tag == ValueTag::INTEGER && other.tag == ValueTag::INTEGER)
+            return integer == other.integer;
+        if (is_number() && other.is_number())
+            return as_float64() == other.as_float64();
+        if (tag == ValueTag::BOOLEAN && other.tag == ValueTag::BOOLEAN)
+            return boolean == other.boolean;
+        return box()->equals(other.box())->value;
+    }
+};
+
+#endif